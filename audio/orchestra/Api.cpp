@@ -6,39 +6,53 @@
  */
 
 //#include <etk/types.hpp>
+#include <math.h>
+#include <string.h>
 #include <audio/orchestra/Interface.hpp>
 #include <audio/orchestra/debug.hpp>
+#include <audio/orchestra/simd.hpp>
 #include <etk/types.hpp>
 
-// Static variable definitions.
+static etk::Vector<uint32_t> createGenericSampleRate() {
+	etk::Vector<uint32_t> list;
+	list.pushBack(4000);
+	list.pushBack(5512);
+	list.pushBack(8000);
+	list.pushBack(9600);
+	list.pushBack(11025);
+	list.pushBack(16000);
+	list.pushBack(22050);
+	list.pushBack(32000);
+	list.pushBack(44100);
+	list.pushBack(48000);
+	list.pushBack(64000);
+	list.pushBack(88200);
+	list.pushBack(96000);
+	list.pushBack(128000);
+	list.pushBack(176400);
+	list.pushBack(192000);
+	list.pushBack(256000);
+	return list;
+}
+
+// Static variable definitions (initialized once, streams can be open from many threads).
 const etk::Vector<uint32_t>& audio::orchestra::genericSampleRate() {
-	static etk::Vector<uint32_t> list;
-	if (list.size() == 0) {
-		list.pushBack(4000);
-		list.pushBack(5512);
-		list.pushBack(8000);
-		list.pushBack(9600);
-		list.pushBack(11025);
-		list.pushBack(16000);
-		list.pushBack(22050);
-		list.pushBack(32000);
-		list.pushBack(44100);
-		list.pushBack(48000);
-		list.pushBack(64000);
-		list.pushBack(88200);
-		list.pushBack(96000);
-		list.pushBack(128000);
-		list.pushBack(176400);
-		list.pushBack(192000);
-		list.pushBack(256000);
-	}
+	static const etk::Vector<uint32_t> list = createGenericSampleRate();
 	return list;
 };
 
 
 audio::orchestra::Api::Api() :
-  m_callback(null),
-  m_deviceBuffer(null) {
+  m_duplexOpen(false),
+  m_userSampleRate(0),
+  m_resampleFifoFrames(0),
+  m_resampleMaxChunk(0),
+  m_batchFrames(0),
+  m_reconnect(false),
+  m_reconnectTimeout(0),
+  m_lastGap(0),
+  m_reconnectCount(0),
+  m_streamFrames(0) {
 	m_device[0] = 11111;
 	m_device[1] = 11111;
 	m_state = audio::orchestra::state::closed;
@@ -53,6 +67,8 @@ enum audio::orchestra::error audio::orchestra::Api::startStream() {
 	ATA_VERBOSE("Start Stream");
 	m_startTime = audio::Time::now();
 	m_duration = echrono::microseconds(0);
+	__atomic_store_n(&m_streamFrames, 0, __ATOMIC_RELEASE);
+	m_clock.reset();
 	return audio::orchestra::error_none;
 }
 
@@ -61,7 +77,7 @@ enum audio::orchestra::error audio::orchestra::Api::openStream(audio::orchestra:
                                                                enum audio::format _format,
                                                                uint32_t _sampleRate,
                                                                uint32_t* _bufferFrames,
-                                                               audio::orchestra::AirTAudioCallback _callback,
+                                                               audio::orchestra::StreamCallback _callback,
                                                                const audio::orchestra::StreamOptions& _options) {
 	if (m_state != audio::orchestra::state::closed) {
 		ATA_ERROR("a stream is already open!");
@@ -86,6 +102,19 @@ enum audio::orchestra::error audio::orchestra::Api::openStream(audio::orchestra:
 		ATA_ERROR("'format' parameter value is undefined.");
 		return audio::orchestra::error_invalidUse;
 	}
+	if (    _options.flags.m_planar == true
+	     && isPlanarSupported() == false) {
+		ATA_ERROR("planar buffers are not supported by the '" << getCurrentApi() << "' interface.");
+		return audio::orchestra::error_invalidUse;
+	}
+	if (    (    (    _oParams != null
+	               && _oParams->aggregateDeviceName.size() != 0)
+	          || (    _iParams != null
+	               && _iParams->aggregateDeviceName.size() != 0))
+	     && isAggregateSupported() == false) {
+		ATA_ERROR("device aggregation is not supported by the '" << getCurrentApi() << "' interface.");
+		return audio::orchestra::error_invalidUse;
+	}
 	uint32_t nDevices = getDeviceCount();
 	uint32_t oChannels = 0;
 	if (_oParams != null) {
@@ -105,14 +134,81 @@ enum audio::orchestra::error audio::orchestra::Api::openStream(audio::orchestra:
 			return audio::orchestra::error_invalidUse;
 		}
 	}
+	// Routing of the channels: the device is open up to the highest routed channel.
+	etk::Vector<uint32_t> channelMap[2];
+	uint32_t oOpenChannels = oChannels;
+	uint32_t oFirstChannel = 0;
+	if (_oParams != null) {
+		oFirstChannel = _oParams->firstChannel;
+		if (resolveChannelMap(*_oParams, channelMap[0]) == false) {
+			return audio::orchestra::error_invalidUse;
+		}
+	}
+	uint32_t iOpenChannels = iChannels;
+	uint32_t iFirstChannel = 0;
+	if (_iParams != null) {
+		iFirstChannel = _iParams->firstChannel;
+		if (resolveChannelMap(*_iParams, channelMap[1]) == false) {
+			return audio::orchestra::error_invalidUse;
+		}
+	}
+	for (int32_t iii=0; iii<2; ++iii) {
+		if (channelMap[iii].size() == 0) {
+			continue;
+		}
+		if (    _options.flags.m_planar == true
+		     || (    iii == 0
+		          && _oParams->aggregateDeviceName.size() != 0)
+		     || (    iii == 1
+		          && _iParams->aggregateDeviceName.size() != 0)) {
+			ATA_ERROR("channel routing can not be used with the planar buffers or the device aggregation.");
+			return audio::orchestra::error_invalidUse;
+		}
+		uint32_t nbOpen = 0;
+		for (size_t jjj=0; jjj<channelMap[iii].size(); ++jjj) {
+			if (channelMap[iii][jjj] + 1 > nbOpen) {
+				nbOpen = channelMap[iii][jjj] + 1;
+			}
+		}
+		if (iii == 0) {
+			oOpenChannels = nbOpen;
+			oFirstChannel = 0;
+		} else {
+			iOpenChannels = nbOpen;
+			iFirstChannel = 0;
+		}
+	}
 	clearStreamInfo();
+	m_threadConfig = _options.thread;
+	m_duplexOpen = (    oChannels > 0
+	                 && iChannels > 0);
+	configureStreamBuffers();
+	if (_oParams != null) {
+		m_aggregateDeviceName[0] = _oParams->aggregateDeviceName;
+	}
+	if (_iParams != null) {
+		m_aggregateDeviceName[1] = _iParams->aggregateDeviceName;
+	}
+	m_reconnect = _options.reconnect;
+	m_reconnectTimeout = _options.reconnectTimeout;
+	if (_oParams != null) {
+		m_fallbackDeviceName[0] = _oParams->fallbackDeviceName;
+	}
+	if (_iParams != null) {
+		m_fallbackDeviceName[1] = _iParams->fallbackDeviceName;
+	}
 	bool result;
+	if (    oChannels > 0
+	     && iChannels > 0
+	     && _iParams->aggregateDeviceName.size() == 0) {
+		prepareOpen(audio::orchestra::mode_input, *_iParams);
+	}
 	if (oChannels > 0) {
 		if (_oParams->deviceId == -1) {
 			result = openName(_oParams->deviceName,
 			                  audio::orchestra::mode_output,
-			                  oChannels,
-			                  _oParams->firstChannel,
+			                  oOpenChannels,
+			                  oFirstChannel,
 			                  _sampleRate,
 			                  _format,
 			                  _bufferFrames,
@@ -120,24 +216,31 @@ enum audio::orchestra::error audio::orchestra::Api::openStream(audio::orchestra:
 		} else {
 			result = open(_oParams->deviceId,
 			              audio::orchestra::mode_output,
-			              oChannels,
-			              _oParams->firstChannel,
+			              oOpenChannels,
+			              oFirstChannel,
 			              _sampleRate,
 			              _format,
 			              _bufferFrames,
 			              _options);
 		}
 		if (result == false) {
+			releasePrepareOpen();
 			ATA_ERROR("system ERROR");
 			return audio::orchestra::error_systemError;
 		}
+		if (    channelMap[0].size() != 0
+		     && setupRouting(audio::orchestra::mode_output, oChannels, channelMap[0], _oParams->mixMatrix) == false) {
+			releasePrepareOpen();
+			closeStream();
+			return audio::orchestra::error_invalidUse;
+		}
 	}
 	if (iChannels > 0) {
 		if (_iParams->deviceId == -1) {
 			result = openName(_iParams->deviceName,
 			                  audio::orchestra::mode_input,
-			                  iChannels,
-			                  _iParams->firstChannel,
+			                  iOpenChannels,
+			                  iFirstChannel,
 			                  _sampleRate,
 			                  _format,
 			                  _bufferFrames,
@@ -145,13 +248,14 @@ enum audio::orchestra::error audio::orchestra::Api::openStream(audio::orchestra:
 		} else {
 			result = open(_iParams->deviceId,
 			              audio::orchestra::mode_input,
-			              iChannels,
-			              _iParams->firstChannel,
+			              iOpenChannels,
+			              iFirstChannel,
 			              _sampleRate,
 			              _format,
 			              _bufferFrames,
 			              _options);
 		}
+		releasePrepareOpen();
 		if (result == false) {
 			if (oChannels > 0) {
 				closeStream();
@@ -159,8 +263,32 @@ enum audio::orchestra::error audio::orchestra::Api::openStream(audio::orchestra:
 			ATA_ERROR("system error");
 			return audio::orchestra::error_systemError;
 		}
+		if (    channelMap[1].size() != 0
+		     && setupRouting(audio::orchestra::mode_input, iChannels, channelMap[1], _iParams->mixMatrix) == false) {
+			closeStream();
+			return audio::orchestra::error_invalidUse;
+		}
 	}
 	m_callback = _callback;
+	if (_options.callbackBatch > 1) {
+		if (setupBatch(_options.callbackBatch) == false) {
+			closeStream();
+			return audio::orchestra::error_invalidUse;
+		}
+		m_batchCallback = _callback;
+		m_callback = audio::orchestra::StreamCallback(&audio::orchestra::Api::batchEntry, this);
+	}
+	if (m_sampleRate != _sampleRate) {
+		if (_options.resampling == audio::orchestra::resamplerQuality_none) {
+			ATA_WARNING("The device run at " << m_sampleRate << "Hz instead of " << _sampleRate << "Hz (set StreamOptions::resampling to convert)");
+		} else if (setupResampling(_sampleRate, _options) == false) {
+			closeStream();
+			return audio::orchestra::error_invalidUse;
+		} else {
+			m_userCallback = m_callback;
+			m_callback = audio::orchestra::StreamCallback(&audio::orchestra::Api::resampleEntry, this);
+		}
+	}
 	//_options.numberOfBuffers = m_nBuffers;
 	m_state = audio::orchestra::state::stopped;
 	return audio::orchestra::error_none;
@@ -194,10 +322,58 @@ bool audio::orchestra::Api::open(uint32_t /*device*/,
 	return false;
 }
 
+int32_t audio::orchestra::Api::fillStreamGap(const audio::Duration& _gap) {
+	__atomic_store_n(&m_lastGap, _gap.get(), __ATOMIC_RELEASE);
+	__atomic_add_fetch(&m_reconnectCount, 1, __ATOMIC_ACQ_REL);
+	uint64_t nbFrames = uint64_t(_gap.get()) * uint64_t(m_sampleRate) / 1000000000LL;
+	uint32_t nbPeriods = (nbFrames + m_bufferSize - 1) / m_bufferSize;
+	ATA_WARNING("Stream '" << m_name << "' reconnected: gap of " << _gap << " ==> " << nbPeriods << " silent periods");
+	etk::Vector<enum audio::orchestra::status> status;
+	status.pushBack(audio::orchestra::status::reconnect);
+	if (m_userBuffer[1].size() != 0) {
+		memset(&m_userBuffer[1][0], 0, m_userBuffer[1].size());
+	}
+	const void* inputBuffer = null;
+	void* outputBuffer = null;
+	if (    m_mode == audio::orchestra::mode_input
+	     || m_mode == audio::orchestra::mode_duplex) {
+		inputBuffer = &m_userBuffer[1][0];
+	}
+	if (    m_mode == audio::orchestra::mode_output
+	     || m_mode == audio::orchestra::mode_duplex) {
+		// The played samples of the gap are lost.
+		outputBuffer = &m_userBuffer[0][0];
+	}
+	for (uint32_t iii=0; iii<nbPeriods; ++iii) {
+		// The periods of the gap are placed on the clock of the stream.
+		m_periodTime = m_clock.getFrameTime(m_streamFrames);
+		int32_t ret = m_callback(inputBuffer,
+		                         (inputBuffer == null ? audio::Time() : m_periodTime),
+		                         outputBuffer,
+		                         (outputBuffer == null ? audio::Time() : m_periodTime),
+		                         m_bufferSize,
+		                         status);
+		tickStreamTime();
+		if (ret != 0) {
+			return ret;
+		}
+	}
+	return 0;
+}
+
 void audio::orchestra::Api::tickStreamTime() {
 	//ATA_WARNING("tick : size=" << m_bufferSize << " rate=" << m_sampleRate << " time=" << audio::Duration((int64_t(m_bufferSize) * int64_t(1000000000)) / int64_t(m_sampleRate)).count());
 	//ATA_WARNING("  one element=" << audio::Duration((int64_t(1000000000)) / int64_t(m_sampleRate)).count());
-	m_duration += audio::Duration((int64_t(m_bufferSize) * int64_t(1000000000)) / int64_t(m_sampleRate));
+	audio::Time periodTime = m_periodTime;
+	if (periodTime == audio::Time()) {
+		periodTime = audio::Time::now();
+	}
+	m_periodTime = audio::Time();
+	m_clock.update(periodTime, m_streamFrames, m_bufferSize, m_sampleRate);
+	uint64_t frames = m_streamFrames + m_bufferSize;
+	__atomic_store_n(&m_streamFrames, frames, __ATOMIC_RELEASE);
+	// Compute the duration from the number of frames (no accumulation of the rounding error).
+	m_duration = audio::Duration(int64_t(frames / m_sampleRate), int64_t(frames % m_sampleRate) * 1000000000LL / int64_t(m_sampleRate));
 }
 
 long audio::orchestra::Api::getStreamLatency() {
@@ -223,10 +399,26 @@ audio::Time audio::orchestra::Api::getStreamTime() {
 	return m_startTime + m_duration;
 }
 
+uint32_t audio::orchestra::Api::getStreamMaxChunk() const {
+	uint64_t nbFrames = getBufferSizeMax();
+	if (    m_userSampleRate != 0
+	     && m_sampleRate != 0) {
+		// Same margin as the buffers of the resampling stage.
+		nbFrames = uint64_t(m_resampleMaxChunk) * uint64_t(m_userSampleRate) / uint64_t(m_sampleRate) + 8;
+	}
+	if (m_batchFrames > nbFrames) {
+		nbFrames = m_batchFrames;
+	}
+	return nbFrames;
+}
+
 uint32_t audio::orchestra::Api::getStreamSampleRate() {
 	if (verifyStream() != audio::orchestra::error_none) {
 		return 0;
 	}
+	if (m_userSampleRate != 0) {
+		return m_userSampleRate;
+	}
 	return m_sampleRate;
 }
 
@@ -238,17 +430,56 @@ enum audio::orchestra::error audio::orchestra::Api::verifyStream() {
 	return audio::orchestra::error_none;
 }
 
+void audio::orchestra::Api::configureIoThread() {
+	m_threadConfig.applyCurrentThread();
+	if (m_threadConfig.lockMemory == true) {
+		lockStreamBuffers();
+	}
+}
+
+void audio::orchestra::Api::lockStreamBuffers() {
+	for (int32_t iii=0; iii<2; ++iii) {
+		m_userBuffer[iii].lock();
+		m_resampleUser[iii].lock();
+		m_batchBuffer[iii].lock();
+	}
+	m_deviceBuffer.lock();
+}
+
+void audio::orchestra::Api::configureStreamBuffers() {
+	for (int32_t iii=0; iii<2; ++iii) {
+		m_userBuffer[iii].configure(m_threadConfig.lockMemory, m_threadConfig.hugePages);
+		m_resampleUser[iii].configure(m_threadConfig.lockMemory, m_threadConfig.hugePages);
+		m_batchBuffer[iii].configure(m_threadConfig.lockMemory, m_threadConfig.hugePages);
+	}
+	m_deviceBuffer.configure(m_threadConfig.lockMemory, m_threadConfig.hugePages);
+}
+
 void audio::orchestra::Api::clearStreamInfo() {
 	m_mode = audio::orchestra::mode_unknow;
 	m_state = audio::orchestra::state::closed;
 	m_sampleRate = 0;
 	m_bufferSize = 0;
 	m_nBuffers = 0;
+	m_bufferLatency = 0;
 	m_userFormat = audio::format_unknow;
 	m_startTime = audio::Time();
 	m_duration = audio::Duration(0);
-	m_deviceBuffer = null;
-	m_callback = null;
+	m_streamFrames = 0;
+	m_periodTime = audio::Time();
+	m_clock.reset();
+	m_userSampleRate = 0;
+	m_userCallback.reset();
+	m_resampleFifo.clear();
+	m_resampleFifoFrames = 0;
+	m_resampleMaxChunk = 0;
+	m_batchFrames = 0;
+	m_batchPosition = 0;
+	m_batchCallback.reset();
+	m_batchStatus.clear();
+	m_batchTimeInput = audio::Time();
+	m_deviceBuffer.clear();
+	m_callback.reset();
 	for (int32_t iii=0; iii<2; ++iii) {
 		m_device[iii] = 11111;
 		m_doConvertBuffer[iii] = false;
@@ -267,11 +498,26 @@ void audio::orchestra::Api::clearStreamInfo() {
 		m_convertInfo[iii].outFormat = audio::format_unknow;
 		m_convertInfo[iii].inOffset.clear();
 		m_convertInfo[iii].outOffset.clear();
+		m_convertInfo[iii].planarStride = 0;
+		m_convertInfo[iii].clearOutput = false;
+		m_convertInfo[iii].matrix.clear();
+		m_convertInfo[iii].matrixStride = 0;
+		m_convertInfo[iii].mixSource.clear();
+		m_aggregateDeviceName[iii].clear();
+		m_fallbackDeviceName[iii].clear();
+		m_resampler[iii].reset();
+		m_resampleFloat[iii].clear();
+		m_resampleUser[iii].clear();
+		m_batchBuffer[iii].clear();
 	}
 }
 
-void audio::orchestra::Api::setConvertInfo(audio::orchestra::mode _mode, uint32_t _firstChannel) {
+void audio::orchestra::Api::setConvertInfo(audio::orchestra::mode _mode, uint32_t _firstChannel, uint32_t _planarStride) {
 	int32_t idTable = audio::orchestra::modeToIdTable(_mode);
+	if (_planarStride == 0) {
+		_planarStride = m_bufferSize;
+	}
+	m_convertInfo[idTable].planarStride = _planarStride;
 	if (_mode == audio::orchestra::mode_input) { // convert device to user buffer
 		m_convertInfo[idTable].inJump = m_nDeviceChannels[1];
 		m_convertInfo[idTable].outJump = m_nUserChannels[1];
@@ -292,14 +538,14 @@ void audio::orchestra::Api::setConvertInfo(audio::orchestra::mode _mode, uint32_
 	if (m_deviceInterleaved[idTable] == false) {
 		if (_mode == audio::orchestra::mode_input) {
 			for (int32_t kkk=0; kkk<m_convertInfo[idTable].channels; ++kkk) {
-				m_convertInfo[idTable].inOffset.pushBack(kkk * m_bufferSize);
+				m_convertInfo[idTable].inOffset.pushBack(kkk * _planarStride);
 				m_convertInfo[idTable].outOffset.pushBack(kkk);
 				m_convertInfo[idTable].inJump = 1;
 			}
 		} else {
 			for (int32_t kkk=0; kkk<m_convertInfo[idTable].channels; ++kkk) {
 				m_convertInfo[idTable].inOffset.pushBack(kkk);
-				m_convertInfo[idTable].outOffset.pushBack(kkk * m_bufferSize);
+				m_convertInfo[idTable].outOffset.pushBack(kkk * _planarStride);
 				m_convertInfo[idTable].outJump = 1;
 			}
 		}
@@ -325,27 +571,113 @@ void audio::orchestra::Api::setConvertInfo(audio::orchestra::mode _mode, uint32_
 		} else {
 			if (_mode == audio::orchestra::mode_output) {
 				for (int32_t kkk=0; kkk<m_convertInfo[idTable].channels; ++kkk) {
-					m_convertInfo[idTable].outOffset[kkk] += (_firstChannel * m_bufferSize);
+					m_convertInfo[idTable].outOffset[kkk] += (_firstChannel * _planarStride);
 				}
 			} else {
 				for (int32_t kkk=0; kkk<m_convertInfo[idTable].channels; ++kkk) {
-					m_convertInfo[idTable].inOffset[kkk] += (_firstChannel * m_bufferSize);
+					m_convertInfo[idTable].inOffset[kkk] += (_firstChannel * _planarStride);
 				}
 			}
 		}
 	}
 }
 
+static inline float mixToFloat(int16_t _value) {
+	return float(_value) * (1.0f/32768.0f);
+}
+static inline float mixToFloat(int32_t _value) {
+	return float(double(_value) * (1.0/2147483648.0));
+}
+static inline float mixToFloat(float _value) {
+	return _value;
+}
+static inline float mixToFloat(double _value) {
+	return _value;
+}
+static inline void mixFromFloat(int16_t& _output, float _value) {
+	_value *= 32768.0f;
+	if (_value > 32767.0f) {
+		_value = 32767.0f;
+	} else if (_value < -32768.0f) {
+		_value = -32768.0f;
+	}
+	_output = int16_t(lrintf(_value));
+}
+static inline void mixFromFloat(int32_t& _output, float _value) {
+	double value = double(_value) * 2147483648.0;
+	if (value > 2147483647.0) {
+		value = 2147483647.0;
+	} else if (value < -2147483648.0) {
+		value = -2147483648.0;
+	}
+	_output = int32_t(lrint(value));
+}
+static inline void mixFromFloat(float& _output, float _value) {
+	_output = _value;
+}
+static inline void mixFromFloat(double& _output, float _value) {
+	_output = _value;
+}
+
+/**
+ * @brief Mix the source channels of each frame in the destination channels (one dot product per destination).
+ */
+template<class TYPE>
+static void mixChannels(TYPE* _out, const TYPE* _in, audio::orchestra::ConvertInfo& _info, uint32_t _nbFrames) {
+	size_t nbSources = _info.inOffset.size();
+	size_t nbDestinations = _info.outOffset.size();
+	float* source = &_info.mixSource[0];
+	for (uint32_t iii=0; iii<_nbFrames; ++iii) {
+		for (size_t sss=0; sss<nbSources; ++sss) {
+			source[sss] = mixToFloat(_in[_info.inOffset[sss]]);
+		}
+		for (size_t ddd=0; ddd<nbDestinations; ++ddd) {
+			float value = audio::orchestra::simd::dotProduct(source, &_info.matrix[ddd*_info.matrixStride], _info.matrixStride);
+			mixFromFloat(_out[_info.outOffset[ddd]], value);
+		}
+		_in += _info.inJump;
+		_out += _info.outJump;
+	}
+}
+
 void audio::orchestra::Api::convertBuffer(char *_outBuffer, char *_inBuffer, audio::orchestra::ConvertInfo &_info) {
 	// This function does format conversion, input/output channel compensation, and
 	// data interleaving/deinterleaving.	24-bit integers are assumed to occupy
 	// the lower three bytes of a 32-bit integer.
 
 	// Clear our device buffer when in/out duplex device channels are different
-	if (    _outBuffer == m_deviceBuffer
+	if (    _outBuffer == m_deviceBuffer.dataPointer()
 	     && m_mode == audio::orchestra::mode_duplex
 	     && m_nDeviceChannels[0] < m_nDeviceChannels[1]) {
 		memset(_outBuffer, 0, m_bufferSize * _info.outJump * audio::getFormatBytes(_info.outFormat));
+	} else if (    _outBuffer == m_deviceBuffer.dataPointer()
+	            && m_mode == audio::orchestra::mode_duplex
+	            && _info.clearOutput == true) {
+		// The capture shares this buffer: clear the channels that are not routed.
+		if (_info.outJump == 1) {
+			memset(_outBuffer, 0, _info.planarStride * m_nDeviceChannels[0] * audio::getFormatBytes(_info.outFormat));
+		} else {
+			memset(_outBuffer, 0, m_bufferSize * _info.outJump * audio::getFormatBytes(_info.outFormat));
+		}
+	}
+	if (_info.matrix.size() != 0) {
+		switch (_info.outFormat) {
+			case audio::format_int16:
+				mixChannels(reinterpret_cast<int16_t*>(_outBuffer), reinterpret_cast<const int16_t*>(_inBuffer), _info, m_bufferSize);
+				break;
+			case audio::format_int32:
+				mixChannels(reinterpret_cast<int32_t*>(_outBuffer), reinterpret_cast<const int32_t*>(_inBuffer), _info, m_bufferSize);
+				break;
+			case audio::format_float:
+				mixChannels(reinterpret_cast<float*>(_outBuffer), reinterpret_cast<const float*>(_inBuffer), _info, m_bufferSize);
+				break;
+			case audio::format_double:
+				mixChannels(reinterpret_cast<double*>(_outBuffer), reinterpret_cast<const double*>(_inBuffer), _info, m_bufferSize);
+				break;
+			default:
+				break;
+		}
+		return;
 	}
 	switch (audio::getFormatBytes(_info.outFormat)) {
 		case 1:
@@ -476,3 +808,478 @@ void audio::orchestra::Api::byteSwapBuffer(char *_buffer, uint32_t _samples, aud
 }
 
 
+
+/**
+ * @brief Convert samples of the user format in float.
+ */
+static void resampleToFloat(float* _output, const void* _input, enum audio::format _format, uint32_t _nbSamples) {
+	switch (_format) {
+		case audio::format_int16: {
+				const int16_t* input = static_cast<const int16_t*>(_input);
+				for (uint32_t iii=0; iii<_nbSamples; ++iii) {
+					_output[iii] = float(input[iii]) * (1.0f/32768.0f);
+				}
+			}
+			break;
+		case audio::format_int32: {
+				const int32_t* input = static_cast<const int32_t*>(_input);
+				for (uint32_t iii=0; iii<_nbSamples; ++iii) {
+					_output[iii] = float(double(input[iii]) * (1.0/2147483648.0));
+				}
+			}
+			break;
+		case audio::format_float:
+			memcpy(_output, _input, _nbSamples*sizeof(float));
+			break;
+		case audio::format_double: {
+				const double* input = static_cast<const double*>(_input);
+				for (uint32_t iii=0; iii<_nbSamples; ++iii) {
+					_output[iii] = input[iii];
+				}
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+/**
+ * @brief Convert float samples in the user format (with saturation).
+ */
+static void resampleFromFloat(void* _output, const float* _input, enum audio::format _format, uint32_t _nbSamples) {
+	switch (_format) {
+		case audio::format_int16: {
+				int16_t* output = static_cast<int16_t*>(_output);
+				for (uint32_t iii=0; iii<_nbSamples; ++iii) {
+					float value = _input[iii] * 32768.0f;
+					if (value > 32767.0f) {
+						value = 32767.0f;
+					} else if (value < -32768.0f) {
+						value = -32768.0f;
+					}
+					output[iii] = int16_t(lrintf(value));
+				}
+			}
+			break;
+		case audio::format_int32: {
+				int32_t* output = static_cast<int32_t*>(_output);
+				for (uint32_t iii=0; iii<_nbSamples; ++iii) {
+					double value = double(_input[iii]) * 2147483648.0;
+					if (value > 2147483647.0) {
+						value = 2147483647.0;
+					} else if (value < -2147483648.0) {
+						value = -2147483648.0;
+					}
+					output[iii] = int32_t(lrint(value));
+				}
+			}
+			break;
+		case audio::format_float:
+			memcpy(_output, _input, _nbSamples*sizeof(float));
+			break;
+		case audio::format_double: {
+				double* output = static_cast<double*>(_output);
+				for (uint32_t iii=0; iii<_nbSamples; ++iii) {
+					output[iii] = _input[iii];
+				}
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+bool audio::orchestra::Api::resolveChannelMap(const audio::orchestra::StreamParameters& _params, etk::Vector<uint32_t>& _channelMap) {
+	_channelMap.clear();
+	if (_params.channelMap.size() != 0) {
+		_channelMap = _params.channelMap;
+	} else if (_params.channelPosition.size() != 0) {
+		audio::orchestra::DeviceInfo info;
+		if (_params.deviceId == -1) {
+			if (getNamedDeviceInfo(_params.deviceName, info) == false) {
+				ATA_ERROR("can not get the channels of the device '" << _params.deviceName << "'");
+				return false;
+			}
+		} else {
+			info = getDeviceInfo(_params.deviceId);
+		}
+		for (size_t iii=0; iii<_params.channelPosition.size(); ++iii) {
+			size_t jjj = 0;
+			while (    jjj < info.channels.size()
+			        && info.channels[jjj] != _params.channelPosition[iii]) {
+				++jjj;
+			}
+			if (jjj == info.channels.size()) {
+				ATA_ERROR("channel " << _params.channelPosition[iii] << " not found on the device '" << info.name << "'");
+				return false;
+			}
+			_channelMap.pushBack(jjj);
+		}
+	} else if (_params.mixMatrix.size() != 0) {
+		if (_params.mixMatrix.size() % _params.nChannels != 0) {
+			ATA_ERROR("the mixing matrix size (" << _params.mixMatrix.size() << ") is not a multiple of the number of channels (" << _params.nChannels << ")");
+			return false;
+		}
+		for (uint32_t iii=0; iii<_params.mixMatrix.size()/_params.nChannels; ++iii) {
+			_channelMap.pushBack(_params.firstChannel + iii);
+		}
+	}
+	return true;
+}
+
+bool audio::orchestra::Api::setupRouting(enum audio::orchestra::mode _mode,
+                                         uint32_t _nbUserChannels,
+                                         const etk::Vector<uint32_t>& _channelMap,
+                                         const etk::Vector<float>& _mixMatrix) {
+	int32_t idTable = audio::orchestra::modeToIdTable(_mode);
+	uint32_t nbRouted = _channelMap.size();
+	if (    _mixMatrix.size() == 0
+	     && nbRouted != _nbUserChannels) {
+		ATA_ERROR("the channel map has " << nbRouted << " channels for " << _nbUserChannels << " user channels (set a mixing matrix)");
+		return false;
+	}
+	if (    _mixMatrix.size() != 0
+	     && _mixMatrix.size() != nbRouted * _nbUserChannels) {
+		ATA_ERROR("the mixing matrix must have " << nbRouted * _nbUserChannels << " gains (" << _mixMatrix.size() << " given)");
+		return false;
+	}
+	for (size_t iii=0; iii<nbRouted; ++iii) {
+		if (_channelMap[iii] >= m_nDeviceChannels[idTable]) {
+			ATA_ERROR("channel " << _channelMap[iii] << " is not availlable on the device (" << m_nDeviceChannels[idTable] << " channels)");
+			return false;
+		}
+	}
+	if (_mixMatrix.size() != 0) {
+		if (    m_userFormat != audio::format_int16
+		     && m_userFormat != audio::format_int32
+		     && m_userFormat != audio::format_float
+		     && m_userFormat != audio::format_double) {
+			ATA_ERROR("the mixing matrix does not support the format " << m_userFormat);
+			return false;
+		}
+		if (m_userFormat != m_deviceFormat[idTable]) {
+			ATA_ERROR("the mixing matrix can not be used when the device format (" << m_deviceFormat[idTable] << ") is not the user format");
+			return false;
+		}
+	}
+	uint32_t bytes = audio::getFormatBytes(m_userFormat);
+	// Keep the capacity of the buffers allocated by the backend.
+	uint32_t nbFrames = m_userBuffer[idTable].size() / (m_nUserChannels[idTable] * bytes);
+	audio::orchestra::ConvertInfo& info = m_convertInfo[idTable];
+	if (m_doConvertBuffer[idTable] == false) {
+		// The backend uses the user buffer directly with the device: create the device buffer.
+		int32_t otherId = 1 - idTable;
+		uint64_t bufferBytes = uint64_t(m_nDeviceChannels[idTable]) * audio::getFormatBytes(m_deviceFormat[idTable]) * nbFrames;
+		if (    m_deviceBuffer.size() == 0
+		     || m_doConvertBuffer[otherId] == false
+		     || uint64_t(m_nDeviceChannels[otherId]) * audio::getFormatBytes(m_deviceFormat[otherId]) * nbFrames < bufferBytes) {
+			m_deviceBuffer.clear();
+			m_deviceBuffer.resize(bufferBytes, 0);
+			if (m_deviceBuffer.size() == 0) {
+				ATA_ERROR("error allocating device buffer memory.");
+				return false;
+			}
+		}
+		m_doConvertBuffer[idTable] = true;
+	}
+	if (info.planarStride == 0) {
+		info.planarStride = nbFrames;
+	}
+	m_nUserChannels[idTable] = _nbUserChannels;
+	m_userBuffer[idTable].resize(nbFrames * _nbUserChannels * bytes, 0);
+	uint32_t deviceJump = m_nDeviceChannels[idTable];
+	uint32_t deviceStride = 1;
+	if (m_deviceInterleaved[idTable] == false) {
+		deviceJump = 1;
+		deviceStride = info.planarStride;
+	}
+	info.inOffset.clear();
+	info.outOffset.clear();
+	if (_mode == audio::orchestra::mode_input) {
+		info.inJump = deviceJump;
+		info.outJump = _nbUserChannels;
+		info.inFormat = m_deviceFormat[1];
+		info.outFormat = m_userFormat;
+		for (size_t iii=0; iii<nbRouted; ++iii) {
+			info.inOffset.pushBack(_channelMap[iii] * deviceStride);
+		}
+		for (uint32_t iii=0; iii<_nbUserChannels; ++iii) {
+			info.outOffset.pushBack(iii);
+		}
+	} else {
+		info.inJump = _nbUserChannels;
+		info.outJump = deviceJump;
+		info.inFormat = m_userFormat;
+		info.outFormat = m_deviceFormat[0];
+		for (uint32_t iii=0; iii<_nbUserChannels; ++iii) {
+			info.inOffset.pushBack(iii);
+		}
+		for (size_t iii=0; iii<nbRouted; ++iii) {
+			info.outOffset.pushBack(_channelMap[iii] * deviceStride);
+		}
+	}
+	info.clearOutput = (    _mode == audio::orchestra::mode_output
+	                     && nbRouted < m_nDeviceChannels[0]);
+	info.matrix.clear();
+	info.mixSource.clear();
+	info.matrixStride = 0;
+	if (_mixMatrix.size() == 0) {
+		info.channels = _nbUserChannels;
+	} else {
+		// Rows padded to the size of the vectors (the padding gains are 0).
+		info.channels = 0;
+		uint32_t nbSources = info.inOffset.size();
+		uint32_t nbDestinations = info.outOffset.size();
+		info.matrixStride = audio::orchestra::simd::alignSize(nbSources);
+		info.matrix.resize(nbDestinations * info.matrixStride, 0.0f);
+		for (uint32_t ddd=0; ddd<nbDestinations; ++ddd) {
+			for (uint32_t sss=0; sss<nbSources; ++sss) {
+				info.matrix[ddd*info.matrixStride + sss] = _mixMatrix[ddd*nbSources + sss];
+			}
+		}
+		info.mixSource.resize(info.matrixStride, 0.0f);
+	}
+	ATA_INFO("Channel routing " << _mode << ": " << _nbUserChannels << " user channels on " << nbRouted << " device channels (matrix=" << (_mixMatrix.size() != 0) << ")");
+	return true;
+}
+
+bool audio::orchestra::Api::setupResampling(uint32_t _userSampleRate, const audio::orchestra::StreamOptions& _options) {
+	if (    m_userFormat != audio::format_int16
+	     && m_userFormat != audio::format_int32
+	     && m_userFormat != audio::format_float
+	     && m_userFormat != audio::format_double) {
+		ATA_ERROR("The resampling stage does not support the format: " << m_userFormat);
+		return false;
+	}
+	// The layout of the device does not matter: the user buffers are always interleaved without Flags::m_planar.
+	if (_options.flags.m_planar == true) {
+		ATA_ERROR("The resampling stage does not support the planar buffers");
+		return false;
+	}
+	// The backends that can increase the period (jack) preallocate for their maximum period.
+	m_resampleMaxChunk = getBufferSizeMax();
+	uint32_t maxUserFrames = uint64_t(m_resampleMaxChunk) * uint64_t(_userSampleRate) / uint64_t(m_sampleRate) + 8;
+	uint32_t bytesPerSample = audio::getFormatBytes(m_userFormat);
+	if (m_nUserChannels[0] != 0) {
+		// playback: user rate ==> device rate
+		m_resampler[0] = ememory::makeShared<audio::orchestra::Resampler>();
+		if (m_resampler[0]->init(_userSampleRate, m_sampleRate, m_nUserChannels[0], _options.resampling, maxUserFrames) == false) {
+			return false;
+		}
+		// used for the user samples and for the device samples.
+		uint32_t maxFrames = maxUserFrames;
+		if (maxFrames < m_resampleMaxChunk) {
+			maxFrames = m_resampleMaxChunk;
+		}
+		m_resampleFloat[0].resize(uint64_t(maxFrames) * m_nUserChannels[0], 0.0f);
+		m_resampleUser[0].resize(uint64_t(maxUserFrames) * m_nUserChannels[0] * bytesPerSample, 0);
+	}
+	if (m_nUserChannels[1] != 0) {
+		// record: device rate ==> user rate
+		m_resampler[1] = ememory::makeShared<audio::orchestra::Resampler>();
+		if (m_resampler[1]->init(m_sampleRate, _userSampleRate, m_nUserChannels[1], _options.resampling, m_resampleMaxChunk) == false) {
+			return false;
+		}
+		m_resampleFloat[1].resize(uint64_t(m_resampleMaxChunk) * m_nUserChannels[1], 0.0f);
+		m_resampleUser[1].resize(uint64_t(maxUserFrames) * 2 * m_nUserChannels[1] * bytesPerSample, 0);
+		m_resampleFifo.resize(uint64_t(maxUserFrames) * 2 * m_nUserChannels[1], 0.0f);
+		m_resampleFifoFrames = 0;
+		if (m_nUserChannels[0] != 0) {
+			// duplex: the playback give the number of frames of the callback, keep a margin for the rounding of the ratios.
+			m_resampleFifoFrames = 2;
+		}
+	}
+	m_userSampleRate = _userSampleRate;
+	ATA_INFO("Resampling stage: device=" << m_sampleRate << "Hz user=" << m_userSampleRate << "Hz quality=" << _options.resampling);
+	return true;
+}
+
+int32_t audio::orchestra::Api::resampleCallback(const void* _inputBuffer,
+                                                const audio::Time& _timeInput,
+                                                void* _outputBuffer,
+                                                const audio::Time& _timeOutput,
+                                                uint32_t _nbChunk,
+                                                const etk::Vector<audio::orchestra::status>& _status) {
+	if (_nbChunk > m_resampleMaxChunk) {
+		ATA_ERROR("Resampling stage: period too big: " << _nbChunk << " > " << m_resampleMaxChunk);
+		if (_outputBuffer != null) {
+			memset(_outputBuffer, 0, _nbChunk * m_nUserChannels[0] * audio::getFormatBytes(m_userFormat));
+		}
+		return 0;
+	}
+	uint32_t nbChannelsIn = m_nUserChannels[1];
+	uint32_t nbChannelsOut = m_nUserChannels[0];
+	// Record: resample all the device frames in the FIFO.
+	if (    _inputBuffer != null
+	     && m_resampler[1] != null) {
+		resampleToFloat(&m_resampleFloat[1][0], _inputBuffer, m_userFormat, _nbChunk * nbChannelsIn);
+		m_resampler[1]->push(&m_resampleFloat[1][0], _nbChunk);
+		uint32_t capacity = m_resampleFifo.size() / nbChannelsIn;
+		m_resampleFifoFrames += m_resampler[1]->pull(&m_resampleFifo[m_resampleFifoFrames * nbChannelsIn], capacity - m_resampleFifoFrames);
+	}
+	// Number of frames of the user callback.
+	uint32_t nbUserFrames = m_resampleFifoFrames;
+	if (m_resampler[0] != null) {
+		// The playback need a fixed number of frames at the device rate.
+		nbUserFrames = m_resampler[0]->getInputFrames(_nbChunk);
+	}
+	if (nbUserFrames == 0) {
+		return 0;
+	}
+	const void* userInput = null;
+	if (    _inputBuffer != null
+	     && m_resampler[1] != null) {
+		uint32_t nbFrames = nbUserFrames;
+		if (nbFrames > m_resampleFifoFrames) {
+			// The delay of the filter is not filled: complete with silence.
+			nbFrames = m_resampleFifoFrames;
+			memset(&m_resampleUser[1][0], 0, uint64_t(nbUserFrames) * nbChannelsIn * audio::getFormatBytes(m_userFormat));
+		}
+		uint32_t offset = (nbUserFrames - nbFrames) * nbChannelsIn;
+		resampleFromFloat(&m_resampleUser[1][offset * audio::getFormatBytes(m_userFormat)], &m_resampleFifo[0], m_userFormat, nbFrames * nbChannelsIn);
+		m_resampleFifoFrames -= nbFrames;
+		memmove(&m_resampleFifo[0], &m_resampleFifo[nbFrames * nbChannelsIn], m_resampleFifoFrames * nbChannelsIn * sizeof(float));
+		userInput = &m_resampleUser[1][0];
+	}
+	void* userOutput = null;
+	if (    _outputBuffer != null
+	     && m_resampler[0] != null) {
+		userOutput = &m_resampleUser[0][0];
+	}
+	int32_t ret = m_userCallback(userInput,
+	                             _timeInput,
+	                             userOutput,
+	                             _timeOutput,
+	                             nbUserFrames,
+	                             _status);
+	if (userOutput != null) {
+		resampleToFloat(&m_resampleFloat[0][0], userOutput, m_userFormat, nbUserFrames * nbChannelsOut);
+		m_resampler[0]->push(&m_resampleFloat[0][0], nbUserFrames);
+		// the output is generated in the user buffer of the backend (format of the user at the device rate).
+		float* output = &m_resampleFloat[0][0];
+		uint32_t nbFrames = m_resampler[0]->pull(output, _nbChunk);
+		if (nbFrames < _nbChunk) {
+			memset(&output[nbFrames * nbChannelsOut], 0, (_nbChunk - nbFrames) * nbChannelsOut * sizeof(float));
+		}
+		resampleFromFloat(_outputBuffer, output, m_userFormat, _nbChunk * nbChannelsOut);
+	}
+	return ret;
+}
+
+bool audio::orchestra::Api::setupBatch(uint32_t _nbPeriods) {
+	for (int32_t iii=0; iii<2; ++iii) {
+		if (    m_nUserChannels[iii] != 0
+		     && m_userBuffer[iii].size() == 0) {
+			ATA_ERROR("The batching stage does not support the planar buffers");
+			return false;
+		}
+	}
+	m_batchFrames = _nbPeriods * m_bufferSize;
+	m_batchPosition = 0;
+	m_batchStatus.clear();
+	// Each status is stored once per batch: the IO thread never allocate.
+	m_batchStatus.reserve(audio::orchestra::statusNumber);
+	uint32_t bytesPerSample = audio::getFormatBytes(m_userFormat);
+	for (int32_t iii=0; iii<2; ++iii) {
+		m_batchBuffer[iii].clear();
+		if (m_nUserChannels[iii] != 0) {
+			// The first batch of the playback is silence.
+			m_batchBuffer[iii].resize(uint64_t(m_batchFrames) * m_nUserChannels[iii] * bytesPerSample, 0);
+		}
+	}
+	ATA_INFO("Batching stage: " << _nbPeriods << " periods (" << m_batchFrames << " frames) per call of the callback");
+	return true;
+}
+
+int32_t audio::orchestra::Api::resampleEntry(void* _userData,
+                                             const void* _inputBuffer,
+                                             const audio::Time& _timeInput,
+                                             void* _outputBuffer,
+                                             const audio::Time& _timeOutput,
+                                             uint32_t _nbChunk,
+                                             const etk::Vector<audio::orchestra::status>& _status) {
+	return static_cast<audio::orchestra::Api*>(_userData)->resampleCallback(_inputBuffer, _timeInput, _outputBuffer, _timeOutput, _nbChunk, _status);
+}
+
+int32_t audio::orchestra::Api::batchEntry(void* _userData,
+                                          const void* _inputBuffer,
+                                          const audio::Time& _timeInput,
+                                          void* _outputBuffer,
+                                          const audio::Time& _timeOutput,
+                                          uint32_t _nbChunk,
+                                          const etk::Vector<audio::orchestra::status>& _status) {
+	return static_cast<audio::orchestra::Api*>(_userData)->batchCallback(_inputBuffer, _timeInput, _outputBuffer, _timeOutput, _nbChunk, _status);
+}
+
+int32_t audio::orchestra::Api::batchCallback(const void* _inputBuffer,
+                                             const audio::Time& _timeInput,
+                                             void* _outputBuffer,
+                                             const audio::Time& _timeOutput,
+                                             uint32_t _nbChunk,
+                                             const etk::Vector<audio::orchestra::status>& _status) {
+	uint32_t bytesPerSample = audio::getFormatBytes(m_userFormat);
+	uint32_t frameBytesIn = m_nUserChannels[1] * bytesPerSample;
+	uint32_t frameBytesOut = m_nUserChannels[0] * bytesPerSample;
+	uint32_t sampleRate = m_userSampleRate != 0 ? m_userSampleRate : m_sampleRate;
+	for (size_t iii=0; iii<_status.size(); ++iii) {
+		bool found = false;
+		for (size_t jjj=0; jjj<m_batchStatus.size(); ++jjj) {
+			if (m_batchStatus[jjj] == _status[iii]) {
+				found = true;
+				break;
+			}
+		}
+		if (found == false) {
+			m_batchStatus.pushBack(_status[iii]);
+		}
+	}
+	const char* input = static_cast<const char*>(_inputBuffer);
+	char* output = static_cast<char*>(_outputBuffer);
+	int32_t ret = 0;
+	uint32_t done = 0;
+	while (done < _nbChunk) {
+		uint32_t nbFrames = _nbChunk - done;
+		if (nbFrames > m_batchFrames - m_batchPosition) {
+			nbFrames = m_batchFrames - m_batchPosition;
+		}
+		if (    input != null
+		     && frameBytesIn != 0) {
+			if (m_batchPosition == 0) {
+				m_batchTimeInput = _timeInput + audio::Duration(0, int64_t(done) * 1000000000LL / int64_t(sampleRate));
+			}
+			memcpy(&m_batchBuffer[1][m_batchPosition * frameBytesIn], &input[done * frameBytesIn], nbFrames * frameBytesIn);
+		}
+		if (    output != null
+		     && frameBytesOut != 0) {
+			memcpy(&output[done * frameBytesOut], &m_batchBuffer[0][m_batchPosition * frameBytesOut], nbFrames * frameBytesOut);
+		}
+		m_batchPosition += nbFrames;
+		done += nbFrames;
+		if (m_batchPosition < m_batchFrames) {
+			continue;
+		}
+		// The batch is full (record) and the previous one has been played: the user generate the next one.
+		m_batchPosition = 0;
+		void* userOutput = null;
+		if (    output != null
+		     && frameBytesOut != 0) {
+			userOutput = &m_batchBuffer[0][0];
+		}
+		const void* userInput = null;
+		if (    input != null
+		     && frameBytesIn != 0) {
+			userInput = &m_batchBuffer[1][0];
+		}
+		int32_t retUser = m_batchCallback(userInput,
+		                                  m_batchTimeInput,
+		                                  userOutput,
+		                                  _timeOutput + audio::Duration(0, int64_t(done) * 1000000000LL / int64_t(sampleRate)),
+		                                  m_batchFrames,
+		                                  m_batchStatus);
+		m_batchStatus.clear();
+		if (retUser > ret) {
+			ret = retUser;
+		}
+	}
+	return ret;
+}
@@ -11,6 +11,10 @@
 #include <audio/orchestra/type.hpp>
 #include <audio/orchestra/state.hpp>
 #include <audio/orchestra/mode.hpp>
+#include <audio/orchestra/ClockEstimator.hpp>
+#include <audio/orchestra/Resampler.hpp>
+#include <audio/orchestra/StreamBuffer.hpp>
+#include <audio/orchestra/DeviceEvent.hpp>
 #include <audio/Time.hpp>
 #include <audio/Duration.hpp>
 #include <ememory/memory.hpp>
@@ -31,6 +35,7 @@ namespace audio {
 		 * @param _timeOutput Timestamp of the first buffer sample (playing time).
 		 * @param _nbChunk The number of chunk of input or output chunk in the buffer (same size).
 		 * @param _status List of error that occured in the laps of time.
+		 * @note When the stream is open with Flags::m_planar, the buffers are arrays of one pointer per channel (ex: "float**" for a float stream).
 		 */
 		typedef etk::Function<int32_t (const void* _inputBuffer,
 		                               const audio::Time& _timeInput,
@@ -38,6 +43,70 @@ namespace audio {
 		                               const audio::Time& _timeOutput,
 		                               uint32_t _nbChunk,
 		                               const etk::Vector<audio::orchestra::status>& _status)> AirTAudioCallback;
+		/**
+		 * @brief Raw callback function prototype (same parameters as AirTAudioCallback).
+		 * @param _userData Pointer given at the open of the stream.
+		 * @note No etk::Function indirection: the IO thread call the function directly at each period.
+		 */
+		typedef int32_t (*RawCallback)(void* _userData,
+		                               const void* _inputBuffer,
+		                               const audio::Time& _timeInput,
+		                               void* _outputBuffer,
+		                               const audio::Time& _timeOutput,
+		                               uint32_t _nbChunk,
+		                               const etk::Vector<audio::orchestra::status>& _status);
+		/**
+		 * @brief Callback of a stream: an AirTAudioCallback or a RawCallback with its user data.
+		 */
+		class StreamCallback {
+			private:
+				audio::orchestra::AirTAudioCallback m_function; //!< Generic callback (used when m_raw is null)
+				audio::orchestra::RawCallback m_raw; //!< Raw callback (fast path)
+				void* m_userData; //!< Data given to m_raw
+			public:
+				StreamCallback() :
+				  m_raw(null),
+				  m_userData(null) {
+					
+				}
+				StreamCallback(audio::orchestra::AirTAudioCallback _function) :
+				  m_function(_function),
+				  m_raw(null),
+				  m_userData(null) {
+					
+				}
+				StreamCallback(audio::orchestra::RawCallback _function, void* _userData) :
+				  m_raw(_function),
+				  m_userData(_userData) {
+					
+				}
+				/**
+				 * @brief Remove the callback.
+				 */
+				void reset() {
+					m_function = audio::orchestra::AirTAudioCallback();
+					m_raw = null;
+					m_userData = null;
+				}
+				/**
+				 * @brief Check if a callback is set.
+				 */
+				bool isSet() const {
+					return    m_raw != null
+					       || m_function != null;
+				}
+				int32_t operator()(const void* _inputBuffer,
+				                   const audio::Time& _timeInput,
+				                   void* _outputBuffer,
+				                   const audio::Time& _timeOutput,
+				                   uint32_t _nbChunk,
+				                   const etk::Vector<audio::orchestra::status>& _status) const {
+					if (m_raw != null) {
+						return m_raw(m_userData, _inputBuffer, _timeInput, _outputBuffer, _timeOutput, _nbChunk, _status);
+					}
+					return m_function(_inputBuffer, _timeInput, _outputBuffer, _timeOutput, _nbChunk, _status);
+				}
+		};
 		// A protected structure used for buffer conversion.
 		class ConvertInfo {
 			public:
@@ -48,6 +117,22 @@ namespace audio {
 				enum audio::format outFormat;
 				etk::Vector<int> inOffset;
 				etk::Vector<int> outOffset;
+				uint32_t planarStride; //!< Number of frames between 2 channels in a non-interleaved device buffer
+				bool clearOutput; //!< Some channels of the output are not written (channel routing): clear them before the conversion
+				etk::Vector<float> matrix; //!< Mixing gains: one row of matrixStride sources per destination (empty: copy inOffset[i] to outOffset[i])
+				uint32_t matrixStride; //!< Size of one row of the matrix (number of sources rounded to 4)
+				etk::Vector<float> mixSource; //!< Samples of the sources of the current frame (matrixStride elements)
+				ConvertInfo() :
+				  channels(0),
+				  inJump(0),
+				  outJump(0),
+				  inFormat(audio::format_unknow),
+				  outFormat(audio::format_unknow),
+				  planarStride(0),
+				  clearOutput(false),
+				  matrixStride(0) {
+					
+				}
 		};
 	
 		class Api : public ememory::EnableSharedFromThis<Api>{
@@ -73,15 +158,69 @@ namespace audio {
 				                                        audio::format _format,
 				                                        uint32_t _sampleRate,
 				                                        uint32_t* _nbChunk,
-				                                        audio::orchestra::AirTAudioCallback _callback,
+				                                        audio::orchestra::StreamCallback _callback,
 				                                        const audio::orchestra::StreamOptions& _options);
 				virtual enum audio::orchestra::error closeStream();
 				virtual enum audio::orchestra::error startStream();
 				virtual enum audio::orchestra::error stopStream() = 0;
 				virtual enum audio::orchestra::error abortStream() = 0;
-				long getStreamLatency();
+				virtual long getStreamLatency();
 				uint32_t getStreamSampleRate();
+				/**
+				 * @brief Get the number of frames given to the callback.
+				 */
+				uint32_t getStreamBufferSize() const {
+					return m_bufferSize;
+				}
+				/**
+				 * @brief Get the maximum number of frames given in one call of the callback (period changes of the backend, resampling and batching stages).
+				 */
+				uint32_t getStreamMaxChunk() const;
+				/**
+				 * @brief Get the number of buffers (periods) configured on the device.
+				 */
+				uint32_t getStreamNbBuffers() const {
+					return m_nBuffers;
+				}
+				/**
+				 * @brief Get the latency of the buffering configured on the device (micro-seconds, 0 if unknown).
+				 */
+				uint32_t getStreamBufferLatency() const {
+					return m_bufferLatency;
+				}
 				virtual audio::Time getStreamTime();
+				/**
+				 * @brief Get the filtered time of a frame of the stream (lock-free).
+				 * @param[in] _frame Position of the frame from the start of the stream.
+				 */
+				audio::Time getStreamFrameTime(uint64_t _frame) const {
+					return m_clock.getFrameTime(_frame);
+				}
+				/**
+				 * @brief Get the number of frames processed since the start of the stream (lock-free).
+				 */
+				uint64_t getStreamFramePosition() const {
+					return __atomic_load_n(&m_streamFrames, __ATOMIC_ACQUIRE);
+				}
+				/**
+				 * @brief Get the measured rate of the device relative to the system clock (lock-free).
+				 * @return measured sample rate / nominal sample rate (1.0 if unknown).
+				 */
+				double getStreamRateRatio() const {
+					return m_clock.getRateRatio();
+				}
+				/**
+				 * @brief Get the duration of the last gap of the stream (device lost then reopened: StreamOptions::reconnect).
+				 */
+				audio::Duration getStreamLastGap() const {
+					return audio::Duration(0, __atomic_load_n(&m_lastGap, __ATOMIC_ACQUIRE));
+				}
+				/**
+				 * @brief Get the number of reconnection of the stream since its open.
+				 */
+				uint32_t getStreamReconnectCount() const {
+					return __atomic_load_n(&m_reconnectCount, __ATOMIC_ACQUIRE);
+				}
 				bool isStreamOpen() const {
 					return m_state != audio::orchestra::state::closed;
 				}
@@ -91,18 +230,19 @@ namespace audio {
 				
 			protected:
 				mutable ethread::Mutex m_mutex;
-				audio::orchestra::AirTAudioCallback m_callback;
+				audio::orchestra::StreamCallback m_callback; //!< Callback called by the backend at each period
 				uint32_t m_device[2]; // Playback and record, respectively.
 				enum audio::orchestra::mode m_mode; // audio::orchestra::mode_output, audio::orchestra::mode_input, or audio::orchestra::mode_duplex.
 				enum audio::orchestra::state m_state; // STOPPED, RUNNING, or CLOSED
-				etk::Vector<char> m_userBuffer[2]; // Playback and record, respectively.
-				char *m_deviceBuffer;
+				audio::orchestra::StreamBuffer m_userBuffer[2]; // Playback and record, respectively.
+				audio::orchestra::StreamBuffer m_deviceBuffer; //!< Buffer in the device format (shared by the playback and the record)
 				bool m_doConvertBuffer[2]; // Playback and record, respectively.
 				bool m_deviceInterleaved[2]; // Playback and record, respectively.
 				bool m_doByteSwap[2]; // Playback and record, respectively.
 				uint32_t m_sampleRate; // TODO : Rename frequency
 				uint32_t m_bufferSize;
 				uint32_t m_nBuffers;
+				uint32_t m_bufferLatency; //!< Latency of the buffering configured on the device (micro-seconds).
 				uint32_t m_nUserChannels[2]; // Playback and record, respectively. // TODO : set only one config (open inout with the same number of channels (limitation)
 				uint32_t m_nDeviceChannels[2]; // Playback and record channels, respectively.
 				uint32_t m_channelOffset[2]; // Playback and record, respectively.
@@ -110,10 +250,38 @@ namespace audio {
 				enum audio::format m_userFormat; // TODO : Remove this ==> use can only open in the Harware format ...
 				enum audio::format m_deviceFormat[2]; // Playback and record, respectively.
 				audio::orchestra::ConvertInfo m_convertInfo[2];
+				etk::Vector<etk::String> m_aggregateDeviceName[2]; //!< Devices aggregated after the main device (playback and record).
+				audio::orchestra::ThreadConfig m_threadConfig; //!< Configuration of the IO thread requested by the user.
+				bool m_duplexOpen; //!< The stream open the 2 directions (known before the open of the playback side).
+				// Resampling stage (between the buffers of the backend and the user callback):
+				uint32_t m_userSampleRate; //!< Sample rate of the user callback (0: no resampling)
+				audio::orchestra::StreamCallback m_userCallback; //!< User callback when the resampling stage is used
+				ememory::SharedPtr<audio::orchestra::Resampler> m_resampler[2]; //!< Playback and record, respectively.
+				etk::Vector<float> m_resampleFloat[2]; //!< Float samples at the device rate (playback and record).
+				audio::orchestra::StreamBuffer m_resampleUser[2]; //!< Buffers given to the user callback at the user rate (playback and record).
+				etk::Vector<float> m_resampleFifo; //!< Record samples resampled and not yet given to the user.
+				uint32_t m_resampleFifoFrames; //!< Number of frames in m_resampleFifo.
+				uint32_t m_resampleMaxChunk; //!< Maximum number of device frames of one period.
+				// Batching stage (many periods given in one call of the user callback):
+				uint32_t m_batchFrames; //!< Number of frames of one call of the user callback (0: no batching)
+				uint32_t m_batchPosition; //!< Number of frames stored in the current batch
+				audio::orchestra::StreamCallback m_batchCallback; //!< User callback when the batching stage is used
+				audio::orchestra::StreamBuffer m_batchBuffer[2]; //!< Batch of frames (playback and record, respectively).
+				etk::Vector<audio::orchestra::status> m_batchStatus; //!< Status accumulated during the current batch
+				audio::Time m_batchTimeInput; //!< Record time of the first frame of the current batch
+				// Reconnection when the device is lost:
+				bool m_reconnect; //!< Reopen the device when it is lost (StreamOptions::reconnect)
+				uint32_t m_reconnectTimeout; //!< Maximum time to find a device (ms)
+				etk::Vector<etk::String> m_fallbackDeviceName[2]; //!< Devices used when the device is lost (playback and record).
+				int64_t m_lastGap; //!< Duration of the last gap (ns)
+				uint32_t m_reconnectCount; //!< Number of reconnection since the open
 				
 				//audio::Time
 				audio::Time m_startTime; //!< start time of the stream (restart at every stop, pause ...)
 				audio::Duration m_duration; //!< duration from wich the stream is started
+				uint64_t m_streamFrames; //!< Number of frames processed since the start of the stream
+				audio::Time m_periodTime; //!< Time of the first frame of the current period given by the backend (audio::Time(): wakeup time)
+				audio::orchestra::ClockEstimator m_clock; //!< Filter of the time of the periods
 				
 				/**
 				 * @brief api-specific method that attempts to open a device
@@ -139,7 +307,110 @@ namespace audio {
 				                      uint32_t *_bufferSize,
 				                                 const audio::orchestra::StreamOptions& _options) { return false; }
 				/**
-				 * @brief Increment the stream time.
+				 * @brief Start in background the open of the capture side of a duplex stream (called before the open of the playback side).
+				 * The backend can open the capture device while the playback device is negotiated (the capture side need the
+				 * period size of the playback side, only the slow part that does not depend on it can run in parallel).
+				 * @param[in] _mode Side that is open in second (audio::orchestra::mode_input).
+				 * @param[in] _params Parameters of this side.
+				 */
+				virtual void prepareOpen(enum audio::orchestra::mode _mode, const audio::orchestra::StreamParameters& _params) {}
+				/**
+				 * @brief Wait the end of the work started by prepareOpen and release what is not used by the stream.
+				 */
+				virtual void releasePrepareOpen() {}
+				/**
+				 * @brief Apply the user configuration on the current thread (must be called at the start of the IO thread).
+				 */
+				void configureIoThread();
+				/**
+				 * @brief Lock the buffers of the stream in memory (ThreadConfig::lockMemory).
+				 * @note The buffers allocated after the open of the stream are already locked, this lock the buffers given by the pool before.
+				 */
+				void lockStreamBuffers();
+				/**
+				 * @brief Apply the memory configuration of the user (ThreadConfig::lockMemory and ThreadConfig::hugePages) on the buffers of the stream.
+				 */
+				void configureStreamBuffers();
+				/**
+				 * @brief Get the list of device channels used by a stream (routing of StreamParameters).
+				 * @param[in] _params Parameters of the stream.
+				 * @param[out] _channelMap Device channel of each routed channel (empty: no routing).
+				 * @return false if the routing can not be resolved.
+				 */
+				bool resolveChannelMap(const audio::orchestra::StreamParameters& _params, etk::Vector<uint32_t>& _channelMap);
+				/**
+				 * @brief Route the user channels on some channels of the open device (with an optional mixing matrix).
+				 * @param[in] _mode Direction of the stream.
+				 * @param[in] _nbUserChannels Number of channels of the user buffer.
+				 * @param[in] _channelMap Device channel of each routed channel.
+				 * @param[in] _mixMatrix Mixing gains [destination][source] (empty: direct copy).
+				 * @return false if the routing is not supported by the open stream.
+				 */
+				bool setupRouting(enum audio::orchestra::mode _mode,
+				                  uint32_t _nbUserChannels,
+				                  const etk::Vector<uint32_t>& _channelMap,
+				                  const etk::Vector<float>& _mixMatrix);
+				/**
+				 * @brief Insert a resampling stage between the device rate (m_sampleRate) and the user rate.
+				 * @param[in] _userSampleRate Sample rate requested by the user.
+				 * @param[in] _options Options of the stream (quality of the resampler and layout of the user buffers).
+				 * @return false if the stream configuration can not be resampled.
+				 */
+				bool setupResampling(uint32_t _userSampleRate, const audio::orchestra::StreamOptions& _options);
+				/**
+				 * @brief Callback given to the backend when the resampling stage is used (device rate, fixed period).
+				 */
+				int32_t resampleCallback(const void* _inputBuffer,
+				                         const audio::Time& _timeInput,
+				                         void* _outputBuffer,
+				                         const audio::Time& _timeOutput,
+				                         uint32_t _nbChunk,
+				                         const etk::Vector<audio::orchestra::status>& _status);
+				/**
+				 * @brief RawCallback of the resampling stage (_userData is the Api).
+				 */
+				static int32_t resampleEntry(void* _userData,
+				                             const void* _inputBuffer,
+				                             const audio::Time& _timeInput,
+				                             void* _outputBuffer,
+				                             const audio::Time& _timeOutput,
+				                             uint32_t _nbChunk,
+				                             const etk::Vector<audio::orchestra::status>& _status);
+				/**
+				 * @brief Insert a batching stage: the user callback is called once every _nbPeriods periods.
+				 * @param[in] _nbPeriods Number of periods of one call of the user callback.
+				 * @return false if the stream configuration can not be batched.
+				 */
+				bool setupBatch(uint32_t _nbPeriods);
+				/**
+				 * @brief Callback given to the backend (or to the resampling stage) when the batching stage is used.
+				 */
+				int32_t batchCallback(const void* _inputBuffer,
+				                      const audio::Time& _timeInput,
+				                      void* _outputBuffer,
+				                      const audio::Time& _timeOutput,
+				                      uint32_t _nbChunk,
+				                      const etk::Vector<audio::orchestra::status>& _status);
+				/**
+				 * @brief RawCallback of the batching stage (_userData is the Api).
+				 */
+				static int32_t batchEntry(void* _userData,
+				                          const void* _inputBuffer,
+				                          const audio::Time& _timeInput,
+				                          void* _outputBuffer,
+				                          const audio::Time& _timeOutput,
+				                          uint32_t _nbChunk,
+				                          const etk::Vector<audio::orchestra::status>& _status);
+				/**
+				 * @brief Give the gap of a reconnection to the callback as silent periods (status::reconnect).
+				 * The stream time continue over the gap: the periods after the gap are at their real position.
+				 * @param[in] _gap Time between the loss of the device and the restart of the new one.
+				 * @return The value returned by the callback (1: stop, 2: abort), 0 to continue.
+				 */
+				int32_t fillStreamGap(const audio::Duration& _gap);
+				/**
+				 * @brief Increment the stream time and feed the clock estimator with the current period.
+				 * @note The backends that have a hardware time set m_periodTime before the call.
 				 */
 				void tickStreamTime();
 				/**
@@ -152,7 +423,7 @@ namespace audio {
 				enum audio::orchestra::error verifyStream();
 				/**
 				 * @brief Protected method used to perform format, channel number, and/or interleaving
-				 * conversions between the user and device buffers.
+				 * conversions between the user and device buffers (and the channel mixing when a matrix is set).
 				 */
 				void convertBuffer(char *_outBuffer,
 				                   char *_inBuffer,
@@ -166,14 +437,54 @@ namespace audio {
 				                    enum audio::format _format);
 				/**
 				 * @brief Sets up the parameters for buffer conversion.
+				 * @param[in] _mode Direction of the conversion.
+				 * @param[in] _firstChannel First channel used on the device.
+				 * @param[in] _planarStride Number of frames between 2 channels in a non-interleaved device buffer (0: use m_bufferSize).
 				 */
 				void setConvertInfo(enum audio::orchestra::mode _mode,
-				                    uint32_t _firstChannel);
+				                    uint32_t _firstChannel,
+				                    uint32_t _planarStride = 0);
 				
 			public:
 				virtual bool isMasterOf(ememory::SharedPtr<audio::orchestra::Api> _api) {
 					return false;
 				};
+				/**
+				 * @brief Check if the backend can give planar buffers to the callback (Flags::m_planar).
+				 * @return true if the planar mode is availlable.
+				 */
+				virtual bool isPlanarSupported() {
+					return false;
+				}
+				/**
+				 * @brief Check if the backend can aggregate many devices in one stream (StreamParameters::aggregateDeviceName).
+				 * @return true if the aggregation is availlable.
+				 */
+				virtual bool isAggregateSupported() {
+					return false;
+				}
+				/**
+				 * @brief Get the maximum number of frames of a period (the period of some backends can change while the stream run: jack).
+				 * @return Number of frames preallocated by the backend.
+				 */
+				virtual uint32_t getBufferSizeMax() const {
+					return m_bufferSize;
+				}
+				/**
+				 * @brief Start the notification of the device events (hot-plug).
+				 * @param[in] _callback Function called on each event (on a non real-time thread of the backend).
+				 * @return false if the backend can not report the device events.
+				 */
+				virtual bool startDeviceMonitor(audio::orchestra::DeviceEventCallback _callback) {
+					return false;
+				}
+				/**
+				 * @brief Stop the notification of the device events.
+				 * @note When this function return, the callback is not called anymore.
+				 */
+				virtual void stopDeviceMonitor() {
+					
+				}
 		};
 	}
 }
@@ -0,0 +1,273 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license APACHE v2.0 (see license file)
+ */
+
+#include <audio/orchestra/BlockReader.hpp>
+#include <audio/orchestra/Interface.hpp>
+#include <audio/orchestra/debug.hpp>
+#include <ethread/tools.hpp>
+#include <string.h>
+
+audio::orchestra::BlockRef::BlockRef(const audio::orchestra::BlockRef& _obj) :
+  m_slot(_obj.m_slot) {
+	if (m_slot != null) {
+		__atomic_add_fetch(&m_slot->refCount, 1, __ATOMIC_RELAXED);
+	}
+}
+
+audio::orchestra::BlockRef::BlockRef(audio::orchestra::BlockRef&& _obj) :
+  m_slot(_obj.m_slot) {
+	_obj.m_slot = null;
+}
+
+audio::orchestra::BlockRef::~BlockRef() {
+	reset();
+}
+
+audio::orchestra::BlockRef& audio::orchestra::BlockRef::operator=(const audio::orchestra::BlockRef& _obj) {
+	if (this == &_obj) {
+		return *this;
+	}
+	reset();
+	m_slot = _obj.m_slot;
+	if (m_slot != null) {
+		__atomic_add_fetch(&m_slot->refCount, 1, __ATOMIC_RELAXED);
+	}
+	return *this;
+}
+
+audio::orchestra::BlockRef& audio::orchestra::BlockRef::operator=(audio::orchestra::BlockRef&& _obj) {
+	if (this == &_obj) {
+		return *this;
+	}
+	reset();
+	m_slot = _obj.m_slot;
+	_obj.m_slot = null;
+	return *this;
+}
+
+void audio::orchestra::BlockRef::reset() {
+	if (m_slot == null) {
+		return;
+	}
+	// Release: the consumer has finished to read the block before the IO thread write it again.
+	__atomic_sub_fetch(&m_slot->refCount, 1, __ATOMIC_RELEASE);
+	m_slot = null;
+}
+
+audio::orchestra::BlockReader::BlockReader(uint32_t _nbBlocks) :
+  m_frameBytes(0),
+  m_writeIndex(0),
+  m_readIndex(0),
+  m_lostPending(0),
+  m_position(0),
+  m_overrunCount(0),
+  m_closed(false),
+  m_waiter(null),
+  m_wakerRunning(false) {
+	if (_nbBlocks < 2) {
+		_nbBlocks = 2;
+	}
+	for (uint32_t iii=0; iii<_nbBlocks; ++iii) {
+		m_slots.pushBack(ememory::makeShared<audio::orchestra::BlockReaderSlot>());
+	}
+}
+
+audio::orchestra::BlockReader::~BlockReader() {
+	close();
+	if (m_waker != null) {
+		__atomic_store_n(&m_wakerRunning, false, __ATOMIC_RELEASE);
+		m_event.post();
+		m_waker->join();
+		m_waker.reset();
+	}
+}
+
+enum audio::orchestra::error audio::orchestra::BlockReader::openStream(audio::orchestra::Interface& _interface,
+                                                                       audio::orchestra::StreamParameters* _inputParameters,
+                                                                       enum audio::format _format,
+                                                                       uint32_t _sampleRate,
+                                                                       uint32_t* _bufferFrames,
+                                                                       const audio::orchestra::StreamOptions& _options) {
+	if (_inputParameters == null) {
+		ATA_ERROR("the block reader need an input stream");
+		return audio::orchestra::error_invalidUse;
+	}
+	audio::orchestra::StreamOptions options = _options;
+	options.flags.m_planar = false;
+	// The stream is not running: the ring can be reset without synchronisation.
+	m_frameBytes = _inputParameters->nChannels * audio::getFormatBytes(_format);
+	m_writeIndex = 0;
+	m_readIndex = 0;
+	m_lostPending = 0;
+	m_position = 0;
+	m_overrunCount = 0;
+	m_closed = false;
+	enum audio::orchestra::error ret = _interface.openStream(null,
+	                                                         _inputParameters,
+	                                                         _format,
+	                                                         _sampleRate,
+	                                                         _bufferFrames,
+	                                                         &audio::orchestra::BlockReader::callbackEntry,
+	                                                         this,
+	                                                         options);
+	if (ret != audio::orchestra::error_none) {
+		return ret;
+	}
+	// The blocks are allocated before the start for the maximum period (jack can increase it): the IO thread only copy the samples.
+	uint32_t nbFrames = _interface.getStreamMaxChunk();
+	for (size_t iii=0; iii<m_slots.size(); ++iii) {
+		m_slots[iii]->buffer.configure(options.thread.lockMemory, options.thread.hugePages);
+		m_slots[iii]->buffer.resize(nbFrames * m_frameBytes);
+	}
+	ATA_INFO("Block reader: " << m_slots.size() << " blocks of " << nbFrames << " frames");
+	return audio::orchestra::error_none;
+}
+
+void audio::orchestra::BlockReader::close() {
+	__atomic_store_n(&m_closed, true, __ATOMIC_RELEASE);
+	m_event.post();
+}
+
+bool audio::orchestra::BlockReader::tryNextBlock(audio::orchestra::BlockRef& _block) {
+	uint32_t readIndex = __atomic_load_n(&m_readIndex, __ATOMIC_RELAXED);
+	if (readIndex == __atomic_load_n(&m_writeIndex, __ATOMIC_ACQUIRE)) {
+		return false;
+	}
+	audio::orchestra::BlockReaderSlot* slot = m_slots[readIndex % m_slots.size()].get();
+	// The reference is counted before the block is given back to the IO thread.
+	__atomic_store_n(&slot->refCount, 1, __ATOMIC_RELAXED);
+	__atomic_store_n(&m_readIndex, readIndex + 1, __ATOMIC_RELEASE);
+	_block = audio::orchestra::BlockRef(slot);
+	return true;
+}
+
+bool audio::orchestra::BlockReader::waitNextBlock(audio::orchestra::BlockRef& _block, const audio::Duration& _timeout) {
+	audio::Time start = audio::Time::now();
+	while (true) {
+		uint32_t event = m_event.get();
+		if (tryNextBlock(_block) == true) {
+			return true;
+		}
+		if (__atomic_load_n(&m_closed, __ATOMIC_ACQUIRE) == true) {
+			return false;
+		}
+		audio::Duration timeout = _timeout;
+		if (_timeout.get() >= 0) {
+			audio::Duration elapsed = audio::Time::now() - start;
+			if (_timeout <= elapsed) {
+				return false;
+			}
+			timeout = _timeout - elapsed;
+		}
+		m_event.wait(event, timeout);
+	}
+}
+
+bool audio::orchestra::BlockReader::isClosed() const {
+	return    __atomic_load_n(&m_closed, __ATOMIC_ACQUIRE) == true
+	       && __atomic_load_n(&m_readIndex, __ATOMIC_RELAXED) == __atomic_load_n(&m_writeIndex, __ATOMIC_ACQUIRE);
+}
+
+bool audio::orchestra::BlockReader::isReady() const {
+	return    __atomic_load_n(&m_closed, __ATOMIC_ACQUIRE) == true
+	       || __atomic_load_n(&m_readIndex, __ATOMIC_ACQUIRE) != __atomic_load_n(&m_writeIndex, __ATOMIC_ACQUIRE);
+}
+
+bool audio::orchestra::BlockReader::suspendWaiter(void* _handle) {
+	if (m_waker == null) {
+		m_wakerRunning = true;
+		m_waker = ememory::makeShared<ethread::Thread>([&](){wakerThread();}, "orchestra reader");
+		if (m_waker == null) {
+			ATA_ERROR("can not create the reader thread");
+			m_wakerRunning = false;
+			return false;
+		}
+	}
+	__atomic_store_n(&m_waiter, _handle, __ATOMIC_RELEASE);
+	// A block written before the registration does not wake up the reader thread: check again.
+	if (    isReady() == true
+	     && __atomic_exchange_n(&m_waiter, null, __ATOMIC_ACQ_REL) != null) {
+		return false;
+	}
+	return true;
+}
+
+void audio::orchestra::BlockReader::wakerThread() {
+	ethread::setName("orchestra reader");
+	while (__atomic_load_n(&m_wakerRunning, __ATOMIC_ACQUIRE) == true) {
+		uint32_t event = m_event.get();
+		if (isReady() == true) {
+			void* waiter = __atomic_exchange_n(&m_waiter, null, __ATOMIC_ACQ_REL);
+			if (waiter != null) {
+				#if defined(__cpp_impl_coroutine)
+					std::coroutine_handle<> handle = std::coroutine_handle<>::from_address(waiter);
+					if (m_executor != null) {
+						m_executor([=](){handle.resume();});
+					} else {
+						handle.resume();
+					}
+				#endif
+				continue;
+			}
+		}
+		m_event.wait(event, audio::Duration(-1));
+	}
+	// The reader is destroyed after the close: a coroutine still suspended get its empty block before the destruction
+	// (resumed here, not on the executor that can run it after the end of the reader).
+	void* waiter = __atomic_exchange_n(&m_waiter, null, __ATOMIC_ACQ_REL);
+	if (waiter != null) {
+		#if defined(__cpp_impl_coroutine)
+			std::coroutine_handle<>::from_address(waiter).resume();
+		#endif
+	}
+}
+
+int32_t audio::orchestra::BlockReader::callbackEntry(void* _userData,
+                                                     const void* _inputBuffer,
+                                                     const audio::Time& _timeInput,
+                                                     void* _outputBuffer,
+                                                     const audio::Time& _timeOutput,
+                                                     uint32_t _nbChunk,
+                                                     const etk::Vector<audio::orchestra::status>& _status) {
+	static_cast<audio::orchestra::BlockReader*>(_userData)->writeBlock(_inputBuffer, _timeInput, _nbChunk, _status);
+	return 0;
+}
+
+void audio::orchestra::BlockReader::writeBlock(const void* _inputBuffer,
+                                               const audio::Time& _timeInput,
+                                               uint32_t _nbChunk,
+                                               const etk::Vector<audio::orchestra::status>& _status) {
+	uint64_t position = m_position;
+	m_position += _nbChunk;
+	if (_inputBuffer == null) {
+		return;
+	}
+	uint32_t writeIndex = m_writeIndex;
+	audio::orchestra::BlockReaderSlot* slot = m_slots[writeIndex % m_slots.size()].get();
+	if (    writeIndex - __atomic_load_n(&m_readIndex, __ATOMIC_ACQUIRE) >= m_slots.size()
+	     || __atomic_load_n(&slot->refCount, __ATOMIC_ACQUIRE) != 0
+	     || _nbChunk * m_frameBytes > slot->buffer.size()) {
+		// The consumer is late (or still use the block): drop the period, never wait.
+		m_lostPending++;
+		__atomic_add_fetch(&m_overrunCount, 1, __ATOMIC_ACQ_REL);
+		return;
+	}
+	memcpy(slot->buffer.dataPointer(), _inputBuffer, _nbChunk * m_frameBytes);
+	slot->nbFrames = _nbChunk;
+	slot->time = _timeInput;
+	slot->position = position;
+	slot->lost = m_lostPending;
+	slot->overflow = false;
+	for (size_t iii=0; iii<_status.size(); ++iii) {
+		if (_status[iii] == audio::orchestra::status::overflow) {
+			slot->overflow = true;
+		}
+	}
+	m_lostPending = 0;
+	__atomic_store_n(&m_writeIndex, writeIndex + 1, __ATOMIC_RELEASE);
+	m_event.post();
+}
+
@@ -0,0 +1,272 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license APACHE v2.0 (see license file)
+ */
+#pragma once
+
+#include <etk/types.hpp>
+#include <etk/Vector.hpp>
+#include <etk/Function.hpp>
+#include <ememory/memory.hpp>
+#include <ethread/Thread.hpp>
+#include <audio/Time.hpp>
+#include <audio/Duration.hpp>
+#include <audio/format.hpp>
+#include <audio/orchestra/error.hpp>
+#include <audio/orchestra/status.hpp>
+#include <audio/orchestra/Futex.hpp>
+#include <audio/orchestra/StreamBuffer.hpp>
+#include <audio/orchestra/StreamOptions.hpp>
+#include <audio/orchestra/StreamParameters.hpp>
+#if defined(__cpp_impl_coroutine)
+	#include <coroutine>
+#endif
+
+namespace audio {
+	namespace orchestra {
+		class Interface;
+		/**
+		 * @brief Block of record samples stored in a BlockReader.
+		 */
+		class BlockReaderSlot {
+			public:
+				audio::orchestra::StreamBuffer buffer; //!< Interleaved samples
+				uint32_t nbFrames; //!< Number of frames in the buffer
+				audio::Time time; //!< Record time of the first frame
+				uint64_t position; //!< Position of the first frame from the start of the stream
+				uint32_t lost; //!< Number of blocks lost just before this one
+				bool overflow; //!< The backend reported an overflow in this block
+				int32_t refCount; //!< Number of BlockRef on the block (0: the IO thread can write it)
+				BlockReaderSlot() :
+				  nbFrames(0),
+				  position(0),
+				  lost(0),
+				  overflow(false),
+				  refCount(0) {
+
+				}
+		};
+		/**
+		 * @brief Reference on a block given by a BlockReader.
+		 * The samples are not copied: the IO thread does not write the block again until its last reference is released
+		 * (the blocks recorded meanwhile are lost and reported as an overrun).
+		 */
+		class BlockRef {
+			private:
+				audio::orchestra::BlockReaderSlot* m_slot; //!< Referenced block (null if empty)
+			public:
+				BlockRef() :
+				  m_slot(null) {
+
+				}
+				/**
+				 * @brief Take a reference already counted on the block.
+				 */
+				explicit BlockRef(audio::orchestra::BlockReaderSlot* _slot) :
+				  m_slot(_slot) {
+
+				}
+				BlockRef(const BlockRef& _obj);
+				BlockRef(BlockRef&& _obj);
+				~BlockRef();
+				BlockRef& operator=(const BlockRef& _obj);
+				BlockRef& operator=(BlockRef&& _obj);
+				/**
+				 * @brief Release the block.
+				 */
+				void reset();
+				bool empty() const {
+					return m_slot == null;
+				}
+				/**
+				 * @brief Get the interleaved samples (in the format of the stream).
+				 */
+				const void* data() const {
+					return m_slot->buffer.dataPointer();
+				}
+				/**
+				 * @brief Get the number of frames.
+				 */
+				uint32_t size() const {
+					return m_slot->nbFrames;
+				}
+				/**
+				 * @brief Get the record time of the first frame.
+				 */
+				const audio::Time& getTime() const {
+					return m_slot->time;
+				}
+				/**
+				 * @brief Get the position of the first frame from the start of the stream.
+				 */
+				uint64_t getPosition() const {
+					return m_slot->position;
+				}
+				/**
+				 * @brief Get the number of blocks lost just before this one (the consumer is too slow).
+				 */
+				uint32_t getLostBlocks() const {
+					return m_slot->lost;
+				}
+				/**
+				 * @brief Check if the backend reported an overflow during this block.
+				 */
+				bool getOverflow() const {
+					return m_slot->overflow;
+				}
+		};
+		/**
+		 * @brief Pull interface on an input stream for the consumers that are not real-time (analyse, network...).
+		 * The callback of the stream copy each period in a ring of blocks without lock and without allocation, the consumer
+		 * get the blocks with tryNextBlock, waitNextBlock or "co_await reader.nextBlock()" (C++20).
+		 * When the ring is full, the new periods are dropped (the IO thread never wait the consumer) and counted in
+		 * getOverrunCount.
+		 * @note Only one consumer thread (or coroutine) can get the blocks. The stream must be closed before the reader is
+		 *       destroyed.
+		 */
+		class BlockReader {
+			public:
+				/**
+				 * @brief Function that run a job on the executor of the application (resume of a coroutine).
+				 */
+				typedef etk::Function<void (etk::Function<void ()> _job)> Executor;
+			private:
+				etk::Vector<ememory::SharedPtr<audio::orchestra::BlockReaderSlot>> m_slots; //!< Ring of blocks
+				uint32_t m_frameBytes; //!< Size of one frame
+				uint32_t m_writeIndex; //!< Number of blocks written by the IO thread (wrap around)
+				uint32_t m_readIndex; //!< Number of blocks taken by the consumer (wrap around)
+				uint32_t m_lostPending; //!< Blocks lost since the last written block (IO thread)
+				uint64_t m_position; //!< Position of the next period (IO thread)
+				uint64_t m_overrunCount; //!< Number of blocks lost since the open
+				bool m_closed; //!< No more block will be written
+				audio::orchestra::Futex m_event; //!< Signaled at each written block and at the close
+				// Resume of the coroutines (the members are always present: the layout does not depend on the C++ version).
+				void* m_waiter; //!< Address of the coroutine waiting a block (null if none)
+				Executor m_executor; //!< Executor of the coroutines (null: resumed on the reader thread)
+				bool m_wakerRunning; //!< The reader thread must continue
+				ememory::SharedPtr<ethread::Thread> m_waker; //!< Thread that resume the coroutines (started by the first wait)
+			public:
+				/**
+				 * @brief Constructor.
+				 * @param[in] _nbBlocks Number of blocks of the ring (maximum delay of the consumer in periods).
+				 */
+				BlockReader(uint32_t _nbBlocks = 8);
+				~BlockReader();
+				BlockReader(const BlockReader&) = delete;
+				BlockReader& operator=(const BlockReader&) = delete;
+				/**
+				 * @brief Open an input stream that fill the reader (same parameters as Interface::openStream).
+				 * @param[in] _interface Interface used to open the stream (start, stop and close it as usual).
+				 * @return The result of Interface::openStream.
+				 * @note The buffers are always interleaved (Flags::m_planar is ignored).
+				 */
+				enum audio::orchestra::error openStream(audio::orchestra::Interface& _interface,
+				                                        audio::orchestra::StreamParameters* _inputParameters,
+				                                        enum audio::format _format,
+				                                        uint32_t _sampleRate,
+				                                        uint32_t* _bufferFrames,
+				                                        const audio::orchestra::StreamOptions& _options = audio::orchestra::StreamOptions());
+				/**
+				 * @brief Wake up the consumer: no more block will be written (call it when the stream is stopped or closed).
+				 */
+				void close();
+				/**
+				 * @brief Get the next block if it is available (never wait).
+				 * @param[out] _block Reference on the block.
+				 * @return true if a block is given.
+				 */
+				bool tryNextBlock(audio::orchestra::BlockRef& _block);
+				/**
+				 * @brief Wait the next block.
+				 * @param[out] _block Reference on the block.
+				 * @param[in] _timeout Maximum time to wait (negative: no timeout).
+				 * @return false on timeout or when the reader is closed and empty.
+				 */
+				bool waitNextBlock(audio::orchestra::BlockRef& _block, const audio::Duration& _timeout = audio::Duration(-1));
+				/**
+				 * @brief Get the number of blocks lost since the open (the consumer did not take them in time).
+				 */
+				uint64_t getOverrunCount() const {
+					return __atomic_load_n(&m_overrunCount, __ATOMIC_ACQUIRE);
+				}
+				/**
+				 * @brief Set the executor of the coroutines waiting a block (null: resumed on the reader thread).
+				 */
+				void setExecutor(Executor _executor) {
+					m_executor = _executor;
+				}
+			#if defined(__cpp_impl_coroutine)
+				/**
+				 * @brief Awaitable of nextBlock: the result is the block, empty when the reader is closed.
+				 */
+				class NextBlockAwaiter {
+					private:
+						audio::orchestra::BlockReader* m_reader;
+						audio::orchestra::BlockRef m_block;
+					public:
+						NextBlockAwaiter(audio::orchestra::BlockReader* _reader) :
+						  m_reader(_reader) {
+
+						}
+						bool await_ready() {
+							return    m_reader->tryNextBlock(m_block) == true
+							       || m_reader->isClosed() == true;
+						}
+						bool await_suspend(std::coroutine_handle<> _handle) {
+							return m_reader->suspendWaiter(_handle.address());
+						}
+						audio::orchestra::BlockRef await_resume() {
+							if (m_block.empty() == true) {
+								m_reader->tryNextBlock(m_block);
+							}
+							return etk::move(m_block);
+						}
+				};
+				/**
+				 * @brief Get the next block from a coroutine: "BlockRef block = co_await reader.nextBlock();"
+				 */
+				NextBlockAwaiter nextBlock() {
+					return NextBlockAwaiter(this);
+				}
+			#endif
+			private:
+				/**
+				 * @brief Check if the reader is closed and empty.
+				 */
+				bool isClosed() const;
+				/**
+				 * @brief Check if a block is available or the reader is closed.
+				 */
+				bool isReady() const;
+				/**
+				 * @brief Register a suspended coroutine.
+				 * @param[in] _handle Address of the coroutine.
+				 * @return false if the coroutine must not be suspended (a block is available).
+				 */
+				bool suspendWaiter(void* _handle);
+				/**
+				 * @brief Loop of the thread that resume the coroutines.
+				 */
+				void wakerThread();
+				/**
+				 * @brief RawCallback of the stream (_userData is the reader).
+				 */
+				static int32_t callbackEntry(void* _userData,
+				                             const void* _inputBuffer,
+				                             const audio::Time& _timeInput,
+				                             void* _outputBuffer,
+				                             const audio::Time& _timeOutput,
+				                             uint32_t _nbChunk,
+				                             const etk::Vector<audio::orchestra::status>& _status);
+				/**
+				 * @brief Store a period in the ring (IO thread: no lock, no allocation).
+				 */
+				void writeBlock(const void* _inputBuffer,
+				                const audio::Time& _timeInput,
+				                uint32_t _nbChunk,
+				                const etk::Vector<audio::orchestra::status>& _status);
+		};
+	}
+}
+
@@ -0,0 +1,109 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license APACHE v2.0 (see license file)
+ */
+
+#include <audio/orchestra/ClockEstimator.hpp>
+#include <audio/orchestra/debug.hpp>
+#include <math.h>
+
+static const double maxPeriodError = 4.0; //!< Error (in periods) that restart the loop (discontinuity of the stream)
+
+audio::orchestra::ClockEstimator::ClockEstimator(double _bandwidth) :
+  m_bandwidth(_bandwidth),
+  m_sampleRate(0),
+  m_nbFrames(0),
+  m_baseTime(0),
+  m_time0(0.0),
+  m_time1(0.0),
+  m_period(0.0),
+  m_coefB(0.0),
+  m_coefC(0.0),
+  m_frame(0) {
+
+}
+
+void audio::orchestra::ClockEstimator::reset() {
+	m_nbFrames = 0;
+	m_state.reset();
+}
+
+void audio::orchestra::ClockEstimator::update(const audio::Time& _time, uint64_t _frame, uint32_t _nbFrames, uint32_t _sampleRate) {
+	if (    _nbFrames == 0
+	     || _sampleRate == 0) {
+		return;
+	}
+	int64_t timeNs = _time.get();
+	if (    m_nbFrames != 0
+	     && (    _nbFrames != m_nbFrames
+	          || _sampleRate != m_sampleRate
+	          || _frame != m_frame + m_nbFrames)) {
+		// The period or the position changed: restart from the current measure, keep the measured rate.
+		double ratio = double(m_nbFrames) / (m_period * double(m_sampleRate));
+		m_nbFrames = _nbFrames;
+		m_sampleRate = _sampleRate;
+		m_period = double(_nbFrames) / (double(_sampleRate) * ratio);
+		m_time0 = double(timeNs - m_baseTime) * 1.0e-9;
+		m_time1 = m_time0 + m_period;
+		m_frame = _frame;
+	} else if (m_nbFrames == 0) {
+		// first period: init the loop on the nominal rate.
+		m_nbFrames = _nbFrames;
+		m_sampleRate = _sampleRate;
+		m_baseTime = timeNs;
+		m_period = double(_nbFrames) / double(_sampleRate);
+		m_time0 = 0.0;
+		m_time1 = m_period;
+		m_frame = _frame;
+	} else {
+		double error = double(timeNs - m_baseTime) * 1.0e-9 - m_time1;
+		if (fabs(error) > maxPeriodError * m_period) {
+			ATA_WARNING("Clock estimator: discontinuity of " << int64_t(error*1.0e6) << "us ==> restart");
+			m_time0 = double(timeNs - m_baseTime) * 1.0e-9;
+			m_time1 = m_time0 + m_period;
+		} else {
+			m_time0 = m_time1;
+			m_time1 += m_coefB * error + m_period;
+			m_period += m_coefC * error;
+		}
+		m_frame = _frame;
+	}
+	// The coefficients depend on the duration of the period.
+	double omega = 2.0 * M_PI * m_bandwidth * double(m_nbFrames) / double(m_sampleRate);
+	m_coefB = sqrt(2.0) * omega;
+	m_coefC = omega * omega;
+	// Keep the precision of the double (rebase the times every 1000 s).
+	if (m_time0 > 1000.0) {
+		m_baseTime += 1000000000000LL;
+		m_time0 -= 1000.0;
+		m_time1 -= 1000.0;
+	}
+	State state;
+	state.baseTime = m_baseTime;
+	state.time = m_time0;
+	state.period = m_time1 - m_time0;
+	state.frame = m_frame;
+	state.nbFrames = m_nbFrames;
+	state.ratio = double(m_nbFrames) / (m_period * double(m_sampleRate));
+	m_state.write(state);
+}
+
+audio::Time audio::orchestra::ClockEstimator::getFrameTime(uint64_t _frame) const {
+	State state;
+	if (m_state.read(state) == false) {
+		return audio::Time();
+	}
+	double time = state.time + (double(int64_t(_frame - state.frame)) * state.period) / double(state.nbFrames);
+	int64_t timeNs = state.baseTime + int64_t(time * 1.0e9);
+	return audio::Time(timeNs / 1000000000LL, timeNs % 1000000000LL);
+}
+
+double audio::orchestra::ClockEstimator::getRateRatio() const {
+	State state;
+	if (m_state.read(state) == false) {
+		return 1.0;
+	}
+	return state.ratio;
+}
+
@@ -0,0 +1,95 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license APACHE v2.0 (see license file)
+ */
+#pragma once
+
+#include <etk/types.hpp>
+#include <audio/Time.hpp>
+#include <audio/orchestra/SeqLock.hpp>
+
+namespace audio {
+	namespace orchestra {
+		/**
+		 * @brief Delay locked loop that filter the time of the periods of a stream (F. Adriaensen, "Using a DLL to
+		 * filter time"). It gives a smoothed mapping frame -> system time and the measured rate of the device
+		 * relative to the system clock.
+		 * @note The update is done by the IO thread, all the getters are lock-free and can be called from any thread.
+		 */
+		class ClockEstimator {
+			public:
+				/**
+				 * @brief State of the loop published for the readers.
+				 */
+				class State {
+					public:
+						int64_t baseTime; //!< Reference of the times (ns)
+						double time; //!< Filtered time of the frame 'frame' (s from baseTime)
+						double period; //!< Filtered duration of one period (s)
+						uint64_t frame; //!< Frame position of the last period
+						uint32_t nbFrames; //!< Number of frames of one period
+						double ratio; //!< Measured rate / nominal rate
+						State() :
+						  baseTime(0),
+						  time(0.0),
+						  period(0.0),
+						  frame(0),
+						  nbFrames(0),
+						  ratio(1.0) {
+
+						}
+				};
+			private:
+				double m_bandwidth; //!< Bandwidth of the loop (Hz)
+				uint32_t m_sampleRate; //!< Nominal sample rate
+				uint32_t m_nbFrames; //!< Number of frames of the periods (0: loop not initialized)
+				int64_t m_baseTime; //!< Reference of the times (ns)
+				double m_time0; //!< Filtered time of the current period
+				double m_time1; //!< Predicted time of the next period
+				double m_period; //!< Filtered duration of one period
+				double m_coefB; //!< Loop coefficient: 2nd order
+				double m_coefC; //!< Loop coefficient: integrator
+				uint64_t m_frame; //!< Frame position of m_time0
+				audio::orchestra::SeqLock<State> m_state;
+			public:
+				/**
+				 * @brief Constructor
+				 * @param[in] _bandwidth Bandwidth of the loop in Hz (low: smooth, high: follow faster the rate changes).
+				 */
+				ClockEstimator(double _bandwidth = 0.5);
+				/**
+				 * @brief Restart the estimation (stream start, discontinuity...).
+				 */
+				void reset();
+				/**
+				 * @brief Give the time of a period to the loop (IO thread only).
+				 * @param[in] _time System time of the frame _frame (hardware timestamp if available, wakeup time otherwise).
+				 * @param[in] _frame Position of the first frame of the period.
+				 * @param[in] _nbFrames Number of frames of the period.
+				 * @param[in] _sampleRate Nominal sample rate.
+				 */
+				void update(const audio::Time& _time, uint64_t _frame, uint32_t _nbFrames, uint32_t _sampleRate);
+				/**
+				 * @brief Get the filtered system time of a frame.
+				 * @param[in] _frame Position of the frame in the stream.
+				 * @return The time (audio::Time() if the loop has not received any period).
+				 */
+				audio::Time getFrameTime(uint64_t _frame) const;
+				/**
+				 * @brief Get the measured rate of the device relative to the system clock.
+				 * @return measured sample rate / nominal sample rate (1.0 if unknown).
+				 */
+				double getRateRatio() const;
+				/**
+				 * @brief Get a coherent copy of the state of the loop.
+				 * @param[out] _state State of the loop.
+				 * @return false if the loop has not received any period.
+				 */
+				bool getState(State& _state) const {
+					return m_state.read(_state);
+				}
+		};
+	}
+}
+
@@ -0,0 +1,34 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license APACHE v2.0 (see license file)
+ */
+
+#include <audio/orchestra/DeviceEvent.hpp>
+#include <audio/orchestra/debug.hpp>
+
+static const char* listValueDeviceEvent[] = {
+	"added",
+	"removed",
+	"defaultChanged"
+};
+
+etk::Stream& audio::orchestra::operator <<(etk::Stream& _os, enum audio::orchestra::deviceEvent _obj) {
+	_os << listValueDeviceEvent[_obj];
+	return _os;
+}
+
+namespace etk {
+	template <> bool from_string<enum audio::orchestra::deviceEvent>(enum audio::orchestra::deviceEvent& _variableRet, const etk::String& _value) {
+		for (int32_t iii=0; iii<3; ++iii) {
+			if (_value == listValueDeviceEvent[iii]) {
+				_variableRet = audio::orchestra::deviceEvent(iii);
+				return true;
+			}
+		}
+		return false;
+	}
+	template <enum audio::orchestra::deviceEvent> etk::String toString(const enum audio::orchestra::deviceEvent& _variable) {
+		return listValueDeviceEvent[_variable];
+	}
+}
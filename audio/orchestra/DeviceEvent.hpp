@@ -0,0 +1,34 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license APACHE v2.0 (see license file)
+ */
+#pragma once
+
+#include <etk/types.hpp>
+#include <etk/String.hpp>
+#include <etk/Stream.hpp>
+#include <etk/Function.hpp>
+#include <audio/orchestra/mode.hpp>
+
+namespace audio {
+	namespace orchestra {
+		enum deviceEvent {
+			deviceEvent_added, //!< A device is plugged
+			deviceEvent_removed, //!< A device is unplugged
+			deviceEvent_defaultChanged, //!< The device is the new default device
+		};
+		etk::Stream& operator <<(etk::Stream& _os, enum audio::orchestra::deviceEvent _obj);
+		/**
+		 * @brief Callback of the device events (hot-plug).
+		 * @param _event Type of the event.
+		 * @param _deviceName Name of the device (name used to open a stream with StreamParameters::deviceName).
+		 * @param _mode audio::orchestra::mode_input for a capture device, audio::orchestra::mode_output for a playback device.
+		 * @note Called on a non real-time thread of the backend.
+		 */
+		typedef etk::Function<void (enum audio::orchestra::deviceEvent _event,
+		                            const etk::String& _deviceName,
+		                            enum audio::orchestra::mode _mode)> DeviceEventCallback;
+	}
+}
+
@@ -13,8 +13,14 @@ namespace audio {
 		class Flags {
 			public:
 				bool m_minimizeLatency; // Simple example ==> TODO ...
+				bool m_planar; //!< The callback buffers are arrays of one pointer per channel (no interleaving, zero-copy when the backend support it)
+				bool m_timerScheduling; //!< Large hardware buffer and timer wakeups instead of period interrupts (low CPU, high latency: background/recording streams, ALSA only)
+				bool m_catchUp; //!< Process all the periods availlable at each wakeup: the stream catch up a scheduling delay instead of going to an xrun (ALSA only)
 				Flags() :
-				  m_minimizeLatency(false) {
+				  m_minimizeLatency(false),
+				  m_planar(false),
+				  m_timerScheduling(false),
+				  m_catchUp(false) {
 					// nothing to do ...
 				}
 		};
@@ -0,0 +1,84 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license APACHE v2.0 (see license file)
+ */
+
+#include <audio/orchestra/FrameRing.hpp>
+#include <string.h>
+
+audio::orchestra::FrameRing::FrameRing() :
+  m_frameBytes(0),
+  m_size(0),
+  m_mask(0),
+  m_writePos(0),
+  m_readPos(0),
+  m_lostFrames(0) {
+
+}
+
+bool audio::orchestra::FrameRing::init(uint32_t _nbFrames, uint32_t _frameBytes, bool _lockMemory, bool _hugePages) {
+	m_frameBytes = _frameBytes;
+	m_writePos = 0;
+	m_readPos = 0;
+	m_lostFrames = 0;
+	m_buffer.clear();
+	m_buffer.configure(_lockMemory, _hugePages);
+	m_size = 0;
+	m_mask = 0;
+	if (_nbFrames == 0) {
+		return false;
+	}
+	uint32_t capacity = 1;
+	while (capacity < _nbFrames) {
+		capacity <<= 1;
+	}
+	m_buffer.resize(uint64_t(capacity) * _frameBytes, 0);
+	if (m_buffer.size() == 0) {
+		return false;
+	}
+	m_size = _nbFrames;
+	m_mask = capacity - 1;
+	return true;
+}
+
+uint32_t audio::orchestra::FrameRing::push(const void* _data, uint32_t _nbFrames) {
+	uint32_t writePos = __atomic_load_n(&m_writePos, __ATOMIC_RELAXED);
+	uint32_t space = m_size - (writePos - __atomic_load_n(&m_readPos, __ATOMIC_ACQUIRE));
+	if (_nbFrames > space) {
+		_nbFrames = space;
+	}
+	const char* data = static_cast<const char*>(_data);
+	uint32_t offset = writePos & m_mask;
+	uint32_t first = m_mask + 1 - offset;
+	if (first > _nbFrames) {
+		first = _nbFrames;
+	}
+	memcpy(&m_buffer[uint64_t(offset) * m_frameBytes], data, uint64_t(first) * m_frameBytes);
+	if (_nbFrames > first) {
+		memcpy(&m_buffer[0], data + uint64_t(first) * m_frameBytes, uint64_t(_nbFrames - first) * m_frameBytes);
+	}
+	__atomic_store_n(&m_writePos, writePos + _nbFrames, __ATOMIC_RELEASE);
+	return _nbFrames;
+}
+
+uint32_t audio::orchestra::FrameRing::pop(void* _data, uint32_t _nbFrames) {
+	uint32_t readPos = __atomic_load_n(&m_readPos, __ATOMIC_RELAXED);
+	uint32_t fill = __atomic_load_n(&m_writePos, __ATOMIC_ACQUIRE) - readPos;
+	if (_nbFrames > fill) {
+		_nbFrames = fill;
+	}
+	char* data = static_cast<char*>(_data);
+	uint32_t offset = readPos & m_mask;
+	uint32_t first = m_mask + 1 - offset;
+	if (first > _nbFrames) {
+		first = _nbFrames;
+	}
+	memcpy(data, &m_buffer[uint64_t(offset) * m_frameBytes], uint64_t(first) * m_frameBytes);
+	if (_nbFrames > first) {
+		memcpy(data + uint64_t(first) * m_frameBytes, &m_buffer[0], uint64_t(_nbFrames - first) * m_frameBytes);
+	}
+	__atomic_store_n(&m_readPos, readPos + _nbFrames, __ATOMIC_RELEASE);
+	return _nbFrames;
+}
+
@@ -0,0 +1,89 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license APACHE v2.0 (see license file)
+ */
+#pragma once
+
+#include <etk/types.hpp>
+#include <audio/orchestra/Futex.hpp>
+#include <audio/orchestra/StreamBuffer.hpp>
+
+namespace audio {
+	namespace orchestra {
+		/**
+		 * @brief Lock-free ring of frames with one producer and one consumer (blocking read/write mode of the Interface).
+		 * The IO thread side never wait: it signal the other side with getEvent() after each push or pop.
+		 */
+		class FrameRing {
+			private:
+				audio::orchestra::StreamBuffer m_buffer; //!< Samples of the ring
+				uint32_t m_frameBytes; //!< Size of one frame
+				uint32_t m_size; //!< Capacity of the ring (frames)
+				uint32_t m_mask; //!< Size of the buffer - 1 (power of 2: the positions can wrap around)
+				uint32_t m_writePos; //!< Number of frames pushed (wrap around)
+				uint32_t m_readPos; //!< Number of frames popped (wrap around)
+				uint64_t m_lostFrames; //!< Frames lost by the IO thread (ring empty on playback, full on record)
+				audio::orchestra::Futex m_event; //!< Signaled by the IO thread after each period
+			public:
+				FrameRing();
+				/**
+				 * @brief Allocate the ring (the ring must not be in use).
+				 * @param[in] _nbFrames Capacity of the ring (frames).
+				 * @param[in] _frameBytes Size of one frame.
+				 * @param[in] _lockMemory Lock the ring in memory (ThreadConfig::lockMemory).
+				 * @param[in] _hugePages Back the ring with huge pages (ThreadConfig::hugePages).
+				 * @return false if the ring can not be allocated.
+				 */
+				bool init(uint32_t _nbFrames, uint32_t _frameBytes, bool _lockMemory, bool _hugePages);
+				/**
+				 * @brief Copy frames in the ring (producer side, never wait).
+				 * @param[in] _data Interleaved frames.
+				 * @param[in] _nbFrames Number of frames to copy.
+				 * @return Number of frames copied (limited by the free space).
+				 */
+				uint32_t push(const void* _data, uint32_t _nbFrames);
+				/**
+				 * @brief Copy frames from the ring (consumer side, never wait).
+				 * @param[out] _data Interleaved frames.
+				 * @param[in] _nbFrames Number of frames requested.
+				 * @return Number of frames copied (limited by the filling).
+				 */
+				uint32_t pop(void* _data, uint32_t _nbFrames);
+				/**
+				 * @brief Get the number of frames that can be popped.
+				 */
+				uint32_t getFill() const {
+					return __atomic_load_n(&m_writePos, __ATOMIC_ACQUIRE) - __atomic_load_n(&m_readPos, __ATOMIC_ACQUIRE);
+				}
+				/**
+				 * @brief Get the number of frames that can be pushed.
+				 */
+				uint32_t getSpace() const {
+					return m_size - getFill();
+				}
+				uint32_t getFrameBytes() const {
+					return m_frameBytes;
+				}
+				/**
+				 * @brief Get the capacity of the ring (frames).
+				 */
+				uint32_t getSize() const {
+					return m_size;
+				}
+				/**
+				 * @brief Count frames lost by the IO thread.
+				 */
+				void addLostFrames(uint32_t _nbFrames) {
+					__atomic_add_fetch(&m_lostFrames, _nbFrames, __ATOMIC_ACQ_REL);
+				}
+				uint64_t getLostFrames() const {
+					return __atomic_load_n(&m_lostFrames, __ATOMIC_ACQUIRE);
+				}
+				audio::orchestra::Futex& getEvent() {
+					return m_event;
+				}
+		};
+	}
+}
+
@@ -0,0 +1,67 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license APACHE v2.0 (see license file)
+ */
+
+#include <audio/orchestra/Futex.hpp>
+#include <audio/Time.hpp>
+#if defined(__linux__)
+	extern "C" {
+		#include <errno.h>
+		#include <limits.h>
+		#include <time.h>
+		#include <unistd.h>
+		#include <sys/syscall.h>
+		#include <linux/futex.h>
+	}
+#else
+	#include <ethread/tools.hpp>
+#endif
+
+void audio::orchestra::Futex::post() {
+	// Sequentially consistent: the increment of the value and of the waiters can not be both missed.
+	__atomic_add_fetch(&m_value, 1, __ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&m_waiters, __ATOMIC_SEQ_CST) == 0) {
+		return;
+	}
+	#if defined(__linux__)
+		syscall(SYS_futex, &m_value, FUTEX_WAKE_PRIVATE, INT_MAX, null, null, 0);
+	#endif
+}
+
+bool audio::orchestra::Futex::wait(uint32_t _value, const audio::Duration& _timeout) {
+	if (get() != _value) {
+		return true;
+	}
+	__atomic_add_fetch(&m_waiters, 1, __ATOMIC_SEQ_CST);
+	bool ret = true;
+	#if defined(__linux__)
+		struct timespec* timeout = null;
+		struct timespec delay;
+		if (_timeout.get() >= 0) {
+			delay.tv_sec = _timeout.get() / 1000000000LL;
+			delay.tv_nsec = _timeout.get() % 1000000000LL;
+			timeout = &delay;
+		}
+		// The kernel check the value before sleeping: a post() between get() and here is not lost.
+		if (    syscall(SYS_futex, &m_value, FUTEX_WAIT_PRIVATE, _value, timeout, null, 0) < 0
+		     && errno == ETIMEDOUT) {
+			ret = false;
+		}
+	#else
+		// No futex: poll the counter.
+		audio::Time start = audio::Time::now();
+		while (get() == _value) {
+			if (    _timeout.get() >= 0
+			     && _timeout <= audio::Time::now() - start) {
+				ret = false;
+				break;
+			}
+			ethread::sleepMilliSeconds(1);
+		}
+	#endif
+	__atomic_sub_fetch(&m_waiters, 1, __ATOMIC_ACQ_REL);
+	return ret;
+}
+
@@ -0,0 +1,48 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license APACHE v2.0 (see license file)
+ */
+#pragma once
+
+#include <etk/types.hpp>
+#include <audio/Duration.hpp>
+
+namespace audio {
+	namespace orchestra {
+		/**
+		 * @brief Event counter: the IO thread signal an event without lock and without blocking, the application threads
+		 * wait for the next event (futex on Linux).
+		 * @note post() does a system call only when a thread is waiting.
+		 */
+		class Futex {
+			private:
+				uint32_t m_value; //!< Number of events (wrap around)
+				uint32_t m_waiters; //!< Number of threads blocked in wait()
+			public:
+				Futex() :
+				  m_value(0),
+				  m_waiters(0) {
+
+				}
+				/**
+				 * @brief Get the current value of the counter (give it to wait()).
+				 */
+				uint32_t get() const {
+					return __atomic_load_n(&m_value, __ATOMIC_ACQUIRE);
+				}
+				/**
+				 * @brief Signal an event and wake up the waiting threads (real-time safe).
+				 */
+				void post();
+				/**
+				 * @brief Wait an event.
+				 * @param[in] _value Value of the counter read before checking the waited condition.
+				 * @param[in] _timeout Maximum time to wait (negative: no timeout).
+				 * @return false on timeout, true if the counter is not _value anymore (or a spurious wake up).
+				 */
+				bool wait(uint32_t _value, const audio::Duration& _timeout);
+		};
+	}
+}
+
@@ -17,6 +17,36 @@
 #include <audio/orchestra/api/Dummy.hpp>
 #include <audio/orchestra/api/Jack.hpp>
 #include <audio/orchestra/api/Pulse.hpp>
+#include <ethread/Mutex.hpp>
+#include <ethread/Semaphore.hpp>
+#include <string.h>
+
+static const int64_t apiProbeTimeoutMs = 1000; //!< Maximum time to wait the answer of the backends (automatic choice)
+
+/**
+ * @brief API selected by the automatic choice (shared by all the Interface of the process, empty: not selected).
+ */
+static etk::String& getApiCache() {
+	static etk::String api;
+	return api;
+}
+
+static ethread::Mutex& getApiCacheMutex() {
+	static ethread::Mutex mutex;
+	return mutex;
+}
+
+/**
+ * @brief Result of the probe of the backends (shared with the probe threads that end after the deadline).
+ */
+class ApiProbe {
+	public:
+		ethread::Mutex mutex;
+		ethread::Semaphore semaphore;
+		etk::Vector<ememory::SharedPtr<audio::orchestra::Api>> api; //!< Instance of each backend
+		etk::Vector<uint32_t> nbDevices; //!< Number of devices of each backend
+		etk::Vector<bool> done; //!< The backend has answered
+};
 
 etk::Vector<etk::String> audio::orchestra::Interface::getListApi() {
 	etk::Vector<etk::String> apis;
@@ -48,7 +78,9 @@ void audio::orchestra::Interface::openApi(const etk::String& _api) {
 
 
 audio::orchestra::Interface::Interface() :
-  m_api(null) {
+  m_api(null),
+  m_openBufferFrames(0),
+  m_openError(audio::orchestra::error_none) {
 	ATA_DEBUG("Add interface:");
 #if defined(ORCHESTRA_BUILD_JACK)
 	addInterface(audio::orchestra::typeJack, audio::orchestra::api::Jack::create);
@@ -85,6 +117,9 @@ void audio::orchestra::Interface::addInterface(const etk::String& _api, ememory:
 
 enum audio::orchestra::error audio::orchestra::Interface::clear() {
 	ATA_INFO("Clear API ...");
+	if (m_openThread != null) {
+		waitStreamOpen();
+	}
 	if (m_api == null) {
 		ATA_WARNING("Interface NOT started!");
 		return audio::orchestra::error_none;
@@ -104,9 +139,8 @@ enum audio::orchestra::error audio::orchestra::Interface::instanciate(const etk:
 		// Attempt to open the specified API.
 		openApi(_api);
 		if (m_api != null) {
-			if (m_api->getDeviceCount() != 0) {
-				ATA_INFO("    ==> api open");
-			}
+			// The devices are enumerated when the user request them.
+			ATA_INFO("    ==> api open");
 			return audio::orchestra::error_none;
 		}
 		// No compiled support for specified API value.	Issue a debug
@@ -115,33 +149,127 @@ enum audio::orchestra::error audio::orchestra::Interface::instanciate(const etk:
 		return audio::orchestra::error_fail;
 	}
 	ATA_INFO("Auto choice API :");
-	// Iterate through the compiled APIs and return as soon as we find
-	// one with at least one device or we reach the end of the list.
+	{
+		ethread::UniqueLock lock(getApiCacheMutex());
+		if (getApiCache().size() != 0) {
+			openApi(getApiCache());
+			if (m_api != null) {
+				ATA_INFO("    ==> api open (previous choice): " << getApiCache());
+				return audio::orchestra::error_none;
+			}
+		}
+	}
+	// Probe all the compiled APIs in parallel (a server that does not answer does not delay the others), and keep the
+	// first API of the list that have at least one device.
 	etk::Vector<etk::String> apis = getListApi();
 	ATA_INFO(" find : " << apis.size() << " apis.");
+	ememory::SharedPtr<ApiProbe> probe = ememory::makeShared<ApiProbe>();
+	probe->api.resize(apis.size());
+	probe->nbDevices.resize(apis.size(), 0);
+	probe->done.resize(apis.size(), false);
+	etk::Vector<ememory::SharedPtr<ethread::Thread>> threads;
 	for (size_t iii=0; iii<apis.size(); ++iii) {
-		ATA_INFO("try open ...");
-		openApi(apis[iii]);
-		if(m_api == null) {
-			ATA_ERROR("    ==> can not create ...");
-			continue;
+		ememory::SharedPtr<audio::orchestra::Api> (*create)() = m_apiAvaillable[iii].second;
+		threads.pushBack(ememory::makeShared<ethread::Thread>([=](){
+			ememory::SharedPtr<audio::orchestra::Api> api = create();
+			uint32_t nbDevices = 0;
+			if (api != null) {
+				nbDevices = api->getDeviceCount();
+			}
+			{
+				ethread::UniqueLock lock(probe->mutex);
+				probe->api[iii] = api;
+				probe->nbDevices[iii] = nbDevices;
+				probe->done[iii] = true;
+			}
+			probe->semaphore.post();
+		}, "orchestra probe"));
+	}
+	audio::Time deadline = audio::Time::now() + audio::Duration(0, apiProbeTimeoutMs*1000000);
+	int32_t selected = -1;
+	while (true) {
+		bool waitHigherPriority = false;
+		{
+			ethread::UniqueLock lock(probe->mutex);
+			for (size_t iii=0; iii<apis.size(); ++iii) {
+				if (probe->done[iii] == false) {
+					waitHigherPriority = true;
+					continue;
+				}
+				if (probe->nbDevices[iii] != 0) {
+					selected = iii;
+					break;
+				}
+			}
 		}
-		if (m_api->getDeviceCount() != 0) {
-			ATA_INFO("    ==> api open");
+		if (    selected != -1
+		     && waitHigherPriority == false) {
+			break;
+		}
+		if (    selected == -1
+		     && waitHigherPriority == false) {
+			// all the APIs answered, none have a device.
+			break;
+		}
+		audio::Duration remaining = deadline - audio::Time::now();
+		if (remaining <= audio::Duration(0)) {
+			ATA_WARNING("Some APIs do not answer after " << apiProbeTimeoutMs << "ms: ignore them");
 			break;
+		}
+		probe->semaphore.wait(remaining.get()/1000);
+		selected = -1;
+	}
+	{
+		ethread::UniqueLock lock(probe->mutex);
+		for (size_t iii=0; iii<apis.size(); ++iii) {
+			if (probe->done[iii] == true) {
+				threads[iii]->join();
+			} else {
+				// It end alone (the probe state is kept alive by the thread).
+				threads[iii]->detach();
+			}
+			if (probe->done[iii] == false) {
+				ATA_INFO("    " << apis[iii] << " ==> no answer");
+			} else if (probe->api[iii] == null) {
+				ATA_ERROR("    " << apis[iii] << " ==> can not create ...");
+			} else {
+				ATA_INFO("    " << apis[iii] << " ==> " << probe->nbDevices[iii] << " devices");
+			}
+		}
+		if (selected != -1) {
+			m_api = probe->api[selected];
 		} else {
-			ATA_INFO("    ==> Interface exist, but have no devices: " << m_api->getDeviceCount());
+			// No device: keep the last API that answer (as before: the dummy interface).
+			for (size_t iii=0; iii<apis.size(); ++iii) {
+				if (    probe->done[iii] == true
+				     && probe->api[iii] != null) {
+					m_api = probe->api[iii];
+				}
+			}
 		}
 	}
 	if (m_api != null) {
+		if (selected != -1) {
+			ATA_INFO("    ==> api open: " << apis[selected]);
+			ethread::UniqueLock lock(getApiCacheMutex());
+			getApiCache() = apis[selected];
+		}
 		return audio::orchestra::error_none;
 	}
 	ATA_ERROR("API NOT Supported '" << _api << "' not in " << getListApi());
 	return audio::orchestra::error_fail;
 }
 
+void audio::orchestra::Interface::resetApiCache() {
+	ethread::UniqueLock lock(getApiCacheMutex());
+	getApiCache().clear();
+}
+
 audio::orchestra::Interface::~Interface() {
 	ATA_INFO("Remove interface");
+	if (m_openThread != null) {
+		waitStreamOpen();
+	}
 	m_api.reset();
 }
 
@@ -164,6 +292,282 @@ enum audio::orchestra::error audio::orchestra::Interface::openStream(audio::orch
 	                           _options);
 }
 
+enum audio::orchestra::error audio::orchestra::Interface::openStream(audio::orchestra::StreamParameters* _outputParameters,
+                                                                     audio::orchestra::StreamParameters* _inputParameters,
+                                                                     audio::format _format,
+                                                                     uint32_t _sampleRate,
+                                                                     uint32_t* _bufferFrames,
+                                                                     audio::orchestra::RawCallback _callback,
+                                                                     void* _userData,
+                                                                     const audio::orchestra::StreamOptions& _options) {
+	if (m_api == null) {
+		return audio::orchestra::error_inputNull;
+	}
+	if (_callback == null) {
+		ATA_ERROR("the raw callback is null");
+		return audio::orchestra::error_invalidUse;
+	}
+	return m_api->openStream(_outputParameters,
+	                         _inputParameters,
+	                         _format,
+	                         _sampleRate,
+	                         _bufferFrames,
+	                         audio::orchestra::StreamCallback(_callback, _userData),
+	                         _options);
+}
+
+enum audio::orchestra::error audio::orchestra::Interface::openStreamAsync(audio::orchestra::StreamParameters* _outputParameters,
+                                                                          audio::orchestra::StreamParameters* _inputParameters,
+                                                                          audio::format _format,
+                                                                          uint32_t _sampleRate,
+                                                                          uint32_t _bufferFrames,
+                                                                          audio::orchestra::AirTAudioCallback _callback,
+                                                                          const audio::orchestra::StreamOptions& _options,
+                                                                          audio::orchestra::OpenStreamCallback _openCallback) {
+	if (m_api == null) {
+		return audio::orchestra::error_inputNull;
+	}
+	if (m_openThread != null) {
+		ATA_ERROR("an open of the stream is already in progress (call waitStreamOpen)");
+		return audio::orchestra::error_invalidUse;
+	}
+	bool hasOutput = _outputParameters != null;
+	bool hasInput = _inputParameters != null;
+	m_openParameters[0] = audio::orchestra::StreamParameters();
+	m_openParameters[1] = audio::orchestra::StreamParameters();
+	if (hasOutput == true) {
+		m_openParameters[0] = *_outputParameters;
+	}
+	if (hasInput == true) {
+		m_openParameters[1] = *_inputParameters;
+	}
+	m_openBufferFrames = _bufferFrames;
+	m_openError = audio::orchestra::error_none;
+	audio::orchestra::StreamOptions options = _options;
+	m_openThread = ememory::makeShared<ethread::Thread>([=](){
+		audio::orchestra::StreamParameters* outputParameters = null;
+		audio::orchestra::StreamParameters* inputParameters = null;
+		if (hasOutput == true) {
+			outputParameters = &m_openParameters[0];
+		}
+		if (hasInput == true) {
+			inputParameters = &m_openParameters[1];
+		}
+		m_openError = m_api->openStream(outputParameters,
+		                                inputParameters,
+		                                _format,
+		                                _sampleRate,
+		                                &m_openBufferFrames,
+		                                _callback,
+		                                options);
+		if (_openCallback != null) {
+			_openCallback(m_openError, m_openBufferFrames);
+		}
+	}, "orchestra open");
+	if (m_openThread == null) {
+		ATA_ERROR("can not create the open thread");
+		return audio::orchestra::error_fail;
+	}
+	return audio::orchestra::error_none;
+}
+
+enum audio::orchestra::error audio::orchestra::Interface::waitStreamOpen(uint32_t* _bufferFrames) {
+	if (m_openThread == null) {
+		ATA_ERROR("no open of stream in progress");
+		return audio::orchestra::error_invalidUse;
+	}
+	m_openThread->join();
+	m_openThread.reset();
+	if (_bufferFrames != null) {
+		*_bufferFrames = m_openBufferFrames;
+	}
+	return m_openError;
+}
+
+enum audio::orchestra::error audio::orchestra::Interface::waitStreamOpen(const etk::Vector<audio::orchestra::Interface*>& _list) {
+	enum audio::orchestra::error ret = audio::orchestra::error_none;
+	for (size_t iii=0; iii<_list.size(); ++iii) {
+		if (_list[iii] == null) {
+			continue;
+		}
+		enum audio::orchestra::error result = _list[iii]->waitStreamOpen();
+		if (    result != audio::orchestra::error_none
+		     && ret == audio::orchestra::error_none) {
+			ret = result;
+		}
+	}
+	return ret;
+}
+
+enum audio::orchestra::error audio::orchestra::Interface::openStreamBlocking(audio::orchestra::StreamParameters* _outputParameters,
+                                                                             audio::orchestra::StreamParameters* _inputParameters,
+                                                                             audio::format _format,
+                                                                             uint32_t _sampleRate,
+                                                                             uint32_t* _bufferFrames,
+                                                                             uint32_t _ringFrames,
+                                                                             const audio::orchestra::StreamOptions& _options) {
+	if (m_api == null) {
+		return audio::orchestra::error_inputNull;
+	}
+	audio::orchestra::StreamOptions options = _options;
+	options.flags.m_planar = false;
+	enum audio::orchestra::error ret = m_api->openStream(_outputParameters,
+	                                                     _inputParameters,
+	                                                     _format,
+	                                                     _sampleRate,
+	                                                     _bufferFrames,
+	                                                     audio::orchestra::StreamCallback(&audio::orchestra::Interface::blockingEntry, this),
+	                                                     options);
+	if (ret != audio::orchestra::error_none) {
+		return ret;
+	}
+	// The rings are allocated before the start: the IO thread only copy the samples.
+	// The depth follow the maximum period of the backend (jack can increase the period while the stream run).
+	uint32_t maxChunk = m_api->getStreamMaxChunk();
+	if (_ringFrames == 0) {
+		_ringFrames = maxChunk * 4;
+	} else if (_ringFrames < maxChunk) {
+		ATA_WARNING("The ring of the blocking mode can not be smaller than a callback period: " << _ringFrames << " ==> " << maxChunk << " frames");
+		_ringFrames = maxChunk;
+	}
+	audio::orchestra::StreamParameters* parameters[2] = {_outputParameters, _inputParameters};
+	for (int32_t iii=0; iii<2; ++iii) {
+		m_ring[iii].reset();
+		if (parameters[iii] == null) {
+			continue;
+		}
+		m_ring[iii] = ememory::makeShared<audio::orchestra::FrameRing>();
+		if (    m_ring[iii] == null
+		     || m_ring[iii]->init(_ringFrames,
+		                          parameters[iii]->nChannels * audio::getFormatBytes(_format),
+		                          options.thread.lockMemory,
+		                          options.thread.hugePages) == false) {
+			ATA_ERROR("can not allocate the ring of the blocking mode (" << _ringFrames << " frames)");
+			closeStream();
+			return audio::orchestra::error_fail;
+		}
+	}
+	ATA_INFO("Blocking mode: rings of " << _ringFrames << " frames");
+	return audio::orchestra::error_none;
+}
+
+/**
+ * @brief Get the time remaining before a timeout.
+ * @return false if the timeout is reached.
+ */
+static bool getRemainingTime(const audio::Time& _start, const audio::Duration& _timeout, audio::Duration& _remaining) {
+	_remaining = _timeout;
+	if (_timeout.get() < 0) {
+		return true;
+	}
+	audio::Duration elapsed = audio::Time::now() - _start;
+	if (_timeout <= elapsed) {
+		return false;
+	}
+	_remaining = _timeout - elapsed;
+	return true;
+}
+
+uint32_t audio::orchestra::Interface::write(const void* _data, uint32_t _nbFrames, const audio::Duration& _timeout) {
+	ememory::SharedPtr<audio::orchestra::FrameRing> ring = m_ring[0];
+	if (ring == null) {
+		ATA_ERROR("the stream is not open in blocking mode with a playback");
+		return 0;
+	}
+	const char* data = static_cast<const char*>(_data);
+	audio::Time start = audio::Time::now();
+	uint32_t nbDone = 0;
+	while (true) {
+		uint32_t event = ring->getEvent().get();
+		nbDone += ring->push(data + uint64_t(nbDone) * ring->getFrameBytes(), _nbFrames - nbDone);
+		if (nbDone == _nbFrames) {
+			break;
+		}
+		// Nobody drain the ring when the stream is not running.
+		if (isStreamRunning() == false) {
+			break;
+		}
+		audio::Duration remaining;
+		if (getRemainingTime(start, _timeout, remaining) == false) {
+			break;
+		}
+		ring->getEvent().wait(event, remaining);
+	}
+	return nbDone;
+}
+
+uint32_t audio::orchestra::Interface::read(void* _data, uint32_t _nbFrames, const audio::Duration& _timeout) {
+	ememory::SharedPtr<audio::orchestra::FrameRing> ring = m_ring[1];
+	if (ring == null) {
+		ATA_ERROR("the stream is not open in blocking mode with a record");
+		return 0;
+	}
+	char* data = static_cast<char*>(_data);
+	audio::Time start = audio::Time::now();
+	uint32_t nbDone = 0;
+	while (true) {
+		uint32_t event = ring->getEvent().get();
+		nbDone += ring->pop(data + uint64_t(nbDone) * ring->getFrameBytes(), _nbFrames - nbDone);
+		if (nbDone == _nbFrames) {
+			break;
+		}
+		// Nobody fill the ring when the stream is not running.
+		if (isStreamRunning() == false) {
+			break;
+		}
+		audio::Duration remaining;
+		if (getRemainingTime(start, _timeout, remaining) == false) {
+			break;
+		}
+		ring->getEvent().wait(event, remaining);
+	}
+	return nbDone;
+}
+
+uint64_t audio::orchestra::Interface::getStreamLostFrames() const {
+	uint64_t ret = 0;
+	for (int32_t iii=0; iii<2; ++iii) {
+		if (m_ring[iii] != null) {
+			ret += m_ring[iii]->getLostFrames();
+		}
+	}
+	return ret;
+}
+
+int32_t audio::orchestra::Interface::blockingEntry(void* _userData,
+                                                   const void* _inputBuffer,
+                                                   const audio::Time& _timeInput,
+                                                   void* _outputBuffer,
+                                                   const audio::Time& _timeOutput,
+                                                   uint32_t _nbChunk,
+                                                   const etk::Vector<audio::orchestra::status>& _status) {
+	audio::orchestra::Interface* interface = static_cast<audio::orchestra::Interface*>(_userData);
+	audio::orchestra::FrameRing* ring = interface->m_ring[0].get();
+	if (    _outputBuffer != null
+	     && ring != null) {
+		uint32_t nbFrames = ring->pop(_outputBuffer, _nbChunk);
+		if (nbFrames < _nbChunk) {
+			// Underflow: play silence.
+			memset(static_cast<char*>(_outputBuffer) + uint64_t(nbFrames) * ring->getFrameBytes(),
+			       0,
+			       uint64_t(_nbChunk - nbFrames) * ring->getFrameBytes());
+			ring->addLostFrames(_nbChunk - nbFrames);
+		}
+		ring->getEvent().post();
+	}
+	ring = interface->m_ring[1].get();
+	if (    _inputBuffer != null
+	     && ring != null) {
+		uint32_t nbFrames = ring->push(_inputBuffer, _nbChunk);
+		if (nbFrames < _nbChunk) {
+			// Overflow: the application does not read fast enough.
+			ring->addLostFrames(_nbChunk - nbFrames);
+		}
+		ring->getEvent().post();
+	}
+	return 0;
+}
+
 bool audio::orchestra::Interface::isMasterOf(audio::orchestra::Interface& _interface) {
 	if (m_api == null) {
 		ATA_ERROR("Current Master API is null ...");
@@ -184,3 +588,17 @@ bool audio::orchestra::Interface::isMasterOf(audio::orchestra::Interface& _inter
 	return m_api->isMasterOf(_interface.m_api);
 }
 
+enum audio::orchestra::error audio::orchestra::Interface::setDeviceEventCallback(audio::orchestra::DeviceEventCallback _callback) {
+	if (m_api == null) {
+		return audio::orchestra::error_inputNull;
+	}
+	m_api->stopDeviceMonitor();
+	if (_callback == null) {
+		return audio::orchestra::error_none;
+	}
+	if (m_api->startDeviceMonitor(_callback) == false) {
+		ATA_WARNING("The API '" << m_api->getCurrentApi() << "' can not report the device events");
+		return audio::orchestra::error_fail;
+	}
+	return audio::orchestra::error_none;
+}
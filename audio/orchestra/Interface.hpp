@@ -12,9 +12,19 @@
 #include <audio/orchestra/base.hpp>
 #include <audio/orchestra/CallbackInfo.hpp>
 #include <audio/orchestra/Api.hpp>
+#include <audio/orchestra/TypedCallback.hpp>
+#include <audio/orchestra/FrameRing.hpp>
+#include <ethread/Thread.hpp>
 
 namespace audio {
 	namespace orchestra {
+		/**
+		 * @brief Callback of the end of an asynchronous open of a stream (openStreamAsync).
+		 * @param _error Result of the open.
+		 * @param _bufferFrames Number of frames of the callback buffers selected by the device.
+		 */
+		typedef etk::Function<void (enum audio::orchestra::error _error,
+		                            uint32_t _bufferFrames)> OpenStreamCallback;
 		/**
 		 * @brief audio::orchestra::Interface class declaration.
 		 *
@@ -30,6 +40,13 @@ namespace audio {
 				etk::Vector<etk::Pair<etk::String, ememory::SharedPtr<Api> (*)()> > m_apiAvaillable;
 			protected:
 				ememory::SharedPtr<audio::orchestra::Api> m_api;
+				// Asynchronous open of the stream:
+				ememory::SharedPtr<ethread::Thread> m_openThread; //!< Thread that open the stream (openStreamAsync)
+				audio::orchestra::StreamParameters m_openParameters[2]; //!< Copy of the parameters of the stream (playback and record)
+				uint32_t m_openBufferFrames; //!< Number of frames requested, then selected by the device
+				enum audio::orchestra::error m_openError; //!< Result of the open
+				// Blocking read/write mode:
+				ememory::SharedPtr<audio::orchestra::FrameRing> m_ring[2]; //!< Rings of the playback and the record (null: callback mode)
 			public:
 				void setName(const etk::String& _name) {
 					if (m_api == null) {
@@ -66,8 +83,15 @@ namespace audio {
 				enum audio::orchestra::error clear();
 				/**
 				 * @brief Create an interface instance
+				 * @param[in] _api Type of the API (typeUndefined: automatic choice).
+				 * @note The automatic choice probe all the APIs in parallel (with a deadline) and keep the first API of the list
+				 *       that have a device. The choice is kept for the next Interface of the process (see resetApiCache).
 				 */
 				enum audio::orchestra::error instanciate(const etk::String& _api = audio::orchestra::typeUndefined);
+				/**
+				 * @brief Forget the API selected by the automatic choice (the next instanciate probe the APIs again).
+				 */
+				static void resetApiCache();
 				/**
 				 * @return the audio API specifier for the current instance of airtaudio.
 				 */
@@ -190,6 +214,138 @@ namespace audio {
 				                                        uint32_t* _bufferFrames,
 				                                        audio::orchestra::AirTAudioCallback _callback,
 				                                        const audio::orchestra::StreamOptions& _options = audio::orchestra::StreamOptions());
+				/**
+				 * @brief Open a stream with a raw callback (same parameters as openStream).
+				 * The IO thread call _callback directly with _userData (no etk::Function indirection at each period).
+				 * @param[in] _callback Function called at each period.
+				 * @param[in] _userData Pointer given to _callback (must live until the stream is closed).
+				 */
+				enum audio::orchestra::error openStream(audio::orchestra::StreamParameters *_outputParameters,
+				                                        audio::orchestra::StreamParameters *_inputParameters,
+				                                        enum audio::format _format,
+				                                        uint32_t _sampleRate,
+				                                        uint32_t* _bufferFrames,
+				                                        audio::orchestra::RawCallback _callback,
+				                                        void* _userData,
+				                                        const audio::orchestra::StreamOptions& _options = audio::orchestra::StreamOptions());
+				/**
+				 * @brief Open a stream with a typed callback (same parameters as openStream).
+				 * The format of the stream is SampleT (int8_t, int16_t, int32_t, float or double) and the buffers are given as
+				 * audio::orchestra::FrameSpan (layout_interleaved) or audio::orchestra::ChannelArray (layout_planar): the
+				 * type is checked at compile time instead of casting the void* buffers in the callback.
+				 * @code
+				 * interface.openStream<float, audio::orchestra::layout_planar>(&params, null, 48000, &nbFrames,
+				 *     [&](const audio::orchestra::ChannelArray<const float>& _input,
+				 *         const audio::Time& _timeInput,
+				 *         const audio::orchestra::ChannelArray<float>& _output,
+				 *         const audio::Time& _timeOutput,
+				 *         const etk::Vector<audio::orchestra::status>& _status) {
+				 *         ...
+				 *         return 0;
+				 *     });
+				 * @endcode
+				 */
+				template<typename SampleT, enum audio::orchestra::layout Layout>
+				enum audio::orchestra::error openStream(audio::orchestra::StreamParameters *_outputParameters,
+				                                        audio::orchestra::StreamParameters *_inputParameters,
+				                                        uint32_t _sampleRate,
+				                                        uint32_t* _bufferFrames,
+				                                        audio::orchestra::TypedCallback<SampleT, Layout> _callback,
+				                                        const audio::orchestra::StreamOptions& _options = audio::orchestra::StreamOptions()) {
+					audio::orchestra::StreamOptions options = _options;
+					options.flags.m_planar = (Layout == audio::orchestra::layout_planar);
+					uint32_t nbOutput = 0;
+					if (_outputParameters != null) {
+						nbOutput = _outputParameters->nChannels;
+					}
+					uint32_t nbInput = 0;
+					if (_inputParameters != null) {
+						nbInput = _inputParameters->nChannels;
+					}
+					return openStream(_outputParameters,
+					                  _inputParameters,
+					                  audio::orchestra::SampleFormat<SampleT>::value,
+					                  _sampleRate,
+					                  _bufferFrames,
+					                  [=](const void* _inputBuffer,
+					                      const audio::Time& _timeInput,
+					                      void* _outputBuffer,
+					                      const audio::Time& _timeOutput,
+					                      uint32_t _nbChunk,
+					                      const etk::Vector<audio::orchestra::status>& _status) {
+					                      	return _callback(audio::orchestra::BlockView<const SampleT, Layout>::create(_inputBuffer, _nbChunk, nbInput),
+					                      	                 _timeInput,
+					                      	                 audio::orchestra::BlockView<SampleT, Layout>::create(_outputBuffer, _nbChunk, nbOutput),
+					                      	                 _timeOutput,
+					                      	                 _status);
+					                  },
+					                  options);
+				}
+				/**
+				 * @brief Open a stream on a background thread (same parameters as openStream).
+				 * Many streams (on many Interface) can be open in parallel: call openStreamAsync on each of them, then
+				 * waitStreamOpen. The parameters are copied, they do not need to live until the end of the open.
+				 * @param[in] _bufferFrames Desired number of frames of the callback buffers (0: lowest value).
+				 * @param[in] _openCallback Function called on the open thread at the end of the open (can be null).
+				 * @return error_none if the open is started.
+				 * @note The stream can not be used before the end of the open: waitStreamOpen must be called before the other
+				 *       functions of the Interface (it must not be called from _openCallback).
+				 */
+				enum audio::orchestra::error openStreamAsync(audio::orchestra::StreamParameters *_outputParameters,
+				                                             audio::orchestra::StreamParameters *_inputParameters,
+				                                             enum audio::format _format,
+				                                             uint32_t _sampleRate,
+				                                             uint32_t _bufferFrames,
+				                                             audio::orchestra::AirTAudioCallback _callback,
+				                                             const audio::orchestra::StreamOptions& _options = audio::orchestra::StreamOptions(),
+				                                             audio::orchestra::OpenStreamCallback _openCallback = null);
+				/**
+				 * @brief Open a stream in blocking mode (same parameters as openStream, without callback).
+				 * The playback is given with write() and the record is taken with read(): the callback of the stream drain or
+				 * fill a lock-free ring and the IO thread never wait. When the playback ring is empty the device play silence,
+				 * when the record ring is full the record is dropped (getStreamLostFrames).
+				 * @param[in] _ringFrames Depth of each ring in frames (0: 4 maximum callback periods, see getStreamMaxChunk).
+				 * @note Fill the playback ring with write() before startStream to start without silence.
+				 */
+				enum audio::orchestra::error openStreamBlocking(audio::orchestra::StreamParameters *_outputParameters,
+				                                                audio::orchestra::StreamParameters *_inputParameters,
+				                                                enum audio::format _format,
+				                                                uint32_t _sampleRate,
+				                                                uint32_t* _bufferFrames,
+				                                                uint32_t _ringFrames = 0,
+				                                                const audio::orchestra::StreamOptions& _options = audio::orchestra::StreamOptions());
+				/**
+				 * @brief Write interleaved frames to play (blocking mode), wait while the ring is full.
+				 * @param[in] _data Frames in the format of the stream.
+				 * @param[in] _nbFrames Number of frames.
+				 * @param[in] _timeout Maximum time to wait (negative: no timeout).
+				 * @return Number of frames written: less than _nbFrames on timeout or when the stream is stopped.
+				 */
+				uint32_t write(const void* _data, uint32_t _nbFrames, const audio::Duration& _timeout = audio::Duration(-1));
+				/**
+				 * @brief Read interleaved recorded frames (blocking mode), wait while the ring is empty.
+				 * @param[out] _data Frames in the format of the stream.
+				 * @param[in] _nbFrames Number of frames.
+				 * @param[in] _timeout Maximum time to wait (negative: no timeout).
+				 * @return Number of frames read: less than _nbFrames on timeout or when the stream is stopped.
+				 */
+				uint32_t read(void* _data, uint32_t _nbFrames, const audio::Duration& _timeout = audio::Duration(-1));
+				/**
+				 * @brief Get the number of frames lost in blocking mode (silence played on an empty ring, record dropped on a full ring).
+				 */
+				uint64_t getStreamLostFrames() const;
+				/**
+				 * @brief Wait the end of the open started by openStreamAsync.
+				 * @param[out] _bufferFrames Number of frames of the callback buffers selected by the device (can be null).
+				 * @return The result of the open.
+				 */
+				enum audio::orchestra::error waitStreamOpen(uint32_t* _bufferFrames = null);
+				/**
+				 * @brief Wait the end of the open of a batch of streams (started with openStreamAsync).
+				 * @param[in] _list List of the Interface that open a stream.
+				 * @return error_none if all the streams are open, else the error of the first stream that fail.
+				 */
+				static enum audio::orchestra::error waitStreamOpen(const etk::Vector<audio::orchestra::Interface*>& _list);
 				
 				/**
 				 * @brief A function that closes a stream and frees any associated stream memory.
@@ -201,7 +357,11 @@ namespace audio {
 					if (m_api == null) {
 						return audio::orchestra::error_inputNull;
 					}
-					return m_api->closeStream();
+					enum audio::orchestra::error ret = m_api->closeStream();
+					wakeUpBlocking();
+					m_ring[0].reset();
+					m_ring[1].reset();
+					return ret;
 				}
 				/**
 				 * @brief A function that starts a stream.
@@ -229,7 +389,9 @@ namespace audio {
 					if (m_api == null) {
 						return audio::orchestra::error_inputNull;
 					}
-					return m_api->stopStream();
+					enum audio::orchestra::error ret = m_api->stopStream();
+					wakeUpBlocking();
+					return ret;
 				}
 				/**
 				 * @brief Stop a stream, discarding any samples remaining in the input/output queue.
@@ -242,7 +404,9 @@ namespace audio {
 					if (m_api == null) {
 						return audio::orchestra::error_inputNull;
 					}
-					return m_api->abortStream();
+					enum audio::orchestra::error ret = m_api->abortStream();
+					wakeUpBlocking();
+					return ret;
 				}
 				/**
 				 * @return true if a stream is open and false if not.
@@ -287,6 +451,59 @@ namespace audio {
 					}
 					return m_api->getStreamLatency();
 				}
+				/**
+				 * @brief Get the filtered time of a frame of the stream (delay locked loop on the time of the periods).
+				 * @note Lock-free: can be called from any thread.
+				 * @param[in] _frame Position of the frame from the start of the stream.
+				 * @return The system time of the frame (audio::Time() if unknown).
+				 */
+				audio::Time getStreamFrameTime(uint64_t _frame) {
+					if (m_api == null) {
+						return audio::Time();
+					}
+					return m_api->getStreamFrameTime(_frame);
+				}
+				/**
+				 * @brief Get the number of frames processed since the start of the stream.
+				 * @note Lock-free: can be called from any thread.
+				 */
+				uint64_t getStreamFramePosition() {
+					if (m_api == null) {
+						return 0;
+					}
+					return m_api->getStreamFramePosition();
+				}
+				/**
+				 * @brief Get the measured rate of the device relative to the system clock (A/V synchronisation, resampling between devices).
+				 * @note Lock-free: can be called from any thread.
+				 * @return measured sample rate / nominal sample rate (1.0 if unknown).
+				 */
+				double getStreamRateRatio() {
+					if (m_api == null) {
+						return 1.0;
+					}
+					return m_api->getStreamRateRatio();
+				}
+				/**
+				 * @brief Get the duration of the last gap of the stream (the device has been lost and reopened: StreamOptions::reconnect).
+				 * @note Lock-free: can be called from any thread.
+				 */
+				audio::Duration getStreamLastGap() {
+					if (m_api == null) {
+						return audio::Duration(0);
+					}
+					return m_api->getStreamLastGap();
+				}
+				/**
+				 * @brief Get the number of reconnection of the stream since its open (StreamOptions::reconnect).
+				 * @note Lock-free: can be called from any thread.
+				 */
+				uint32_t getStreamReconnectCount() {
+					if (m_api == null) {
+						return 0;
+					}
+					return m_api->getStreamReconnectCount();
+				}
 				/**
 				 * @brief On some systems, the sample rate used may be slightly different
 				 * than that specified in the stream parameters. If a stream is not
@@ -299,9 +516,75 @@ namespace audio {
 					}
 					return m_api->getStreamSampleRate();
 				}
+				/**
+				 * @brief Get the number of frames given to the callback (can be different of the requested one).
+				 * @return Number of frames of the callback buffers.
+				 */
+				uint32_t getStreamBufferSize() {
+					if (m_api == null) {
+						return 0;
+					}
+					return m_api->getStreamBufferSize();
+				}
+				/**
+				 * @brief Get the maximum number of frames given in one call of the callback (period changes of the backend, resampling and batching stages).
+				 */
+				uint32_t getStreamMaxChunk() {
+					if (m_api == null) {
+						return 0;
+					}
+					return m_api->getStreamMaxChunk();
+				}
+				/**
+				 * @brief Get the number of buffers configured on the device (StreamOptions::numberOfBuffers and latency class).
+				 * @return Number of periods of the device.
+				 */
+				uint32_t getStreamNbBuffers() {
+					if (m_api == null) {
+						return 0;
+					}
+					return m_api->getStreamNbBuffers();
+				}
+				/**
+				 * @brief Get the latency achieved for the buffering of the device (StreamOptions::targetLatency and latency class).
+				 * @return The buffering latency in micro-seconds (0 if the API does not report it).
+				 */
+				uint32_t getStreamBufferLatency() {
+					if (m_api == null) {
+						return 0;
+					}
+					return m_api->getStreamBufferLatency();
+				}
 				bool isMasterOf(audio::orchestra::Interface& _interface);
+				/**
+				 * @brief Set the callback of the device events (device plugged or unplugged, new default device).
+				 * The events come from the system notifications (no polling of getDeviceCount and getDeviceInfo).
+				 * @param[in] _callback Function called on a non real-time thread (null: stop the notifications).
+				 * @return error_fail if the API can not report the device events.
+				 */
+				enum audio::orchestra::error setDeviceEventCallback(audio::orchestra::DeviceEventCallback _callback);
 			protected:
 				void openApi(const etk::String& _api);
+				/**
+				 * @brief Wake up the threads blocked in read() or write().
+				 */
+				void wakeUpBlocking() {
+					for (int32_t iii=0; iii<2; ++iii) {
+						if (m_ring[iii] != null) {
+							m_ring[iii]->getEvent().post();
+						}
+					}
+				}
+				/**
+				 * @brief RawCallback of the blocking mode (_userData is the Interface).
+				 */
+				static int32_t blockingEntry(void* _userData,
+				                             const void* _inputBuffer,
+				                             const audio::Time& _timeInput,
+				                             void* _outputBuffer,
+				                             const audio::Time& _timeOutput,
+				                             uint32_t _nbChunk,
+				                             const etk::Vector<audio::orchestra::status>& _status);
 		};
 	}
 }
@@ -0,0 +1,246 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license APACHE v2.0 (see license file)
+ */
+
+#include <audio/orchestra/Resampler.hpp>
+#include <audio/orchestra/debug.hpp>
+#include <audio/orchestra/simd.hpp>
+#include <math.h>
+#include <string.h>
+
+static const uint32_t maxNbPhases = 1024; //!< Above, the ratio is approximated
+
+static const char* listValueResamplerQuality[] = {
+	"none",
+	"low",
+	"medium",
+	"high"
+};
+
+etk::Stream& audio::orchestra::operator <<(etk::Stream& _os, enum audio::orchestra::resamplerQuality _obj) {
+	_os << listValueResamplerQuality[_obj];
+	return _os;
+}
+
+namespace etk {
+	template <> bool from_string<enum audio::orchestra::resamplerQuality>(enum audio::orchestra::resamplerQuality& _variableRet, const etk::String& _value) {
+		for (int32_t iii=0; iii<4; ++iii) {
+			if (_value == listValueResamplerQuality[iii]) {
+				_variableRet = audio::orchestra::resamplerQuality(iii);
+				return true;
+			}
+		}
+		return false;
+	}
+	template <enum audio::orchestra::resamplerQuality> etk::String toString(const enum audio::orchestra::resamplerQuality& _variable) {
+		return listValueResamplerQuality[_variable];
+	}
+}
+
+/**
+ * @brief Modified Bessel function of the first kind (order 0).
+ */
+static double besselI0(double _value) {
+	double sum = 1.0;
+	double term = 1.0;
+	double half = _value * 0.5;
+	for (int32_t iii=1; iii<50; ++iii) {
+		term *= half / double(iii);
+		sum += term * term;
+		if (term * term < sum * 1.0e-12) {
+			break;
+		}
+	}
+	return sum;
+}
+
+static uint32_t gcd(uint32_t _aaa, uint32_t _bbb) {
+	while (_bbb != 0) {
+		uint32_t tmp = _aaa % _bbb;
+		_aaa = _bbb;
+		_bbb = tmp;
+	}
+	return _aaa;
+}
+
+audio::orchestra::Resampler::Resampler() :
+  m_inputRate(0),
+  m_outputRate(0),
+  m_nbChannels(0),
+  m_nbTaps(0),
+  m_nbPhases(1),
+  m_step(1),
+  m_bufferCapacity(0),
+  m_bufferFrames(0),
+  m_position(0),
+  m_phase(0) {
+
+}
+
+bool audio::orchestra::Resampler::init(uint32_t _inputRate,
+                                       uint32_t _outputRate,
+                                       uint32_t _nbChannels,
+                                       enum audio::orchestra::resamplerQuality _quality,
+                                       uint32_t _maxInputFrames) {
+	if (    _inputRate == 0
+	     || _outputRate == 0
+	     || _nbChannels == 0) {
+		ATA_ERROR("Can not resample: rate=" << _inputRate << " -> " << _outputRate << " channels=" << _nbChannels);
+		return false;
+	}
+	double cutoffFactor = 0.0;
+	double beta = 0.0;
+	switch (_quality) {
+		case audio::orchestra::resamplerQuality_none:
+			ATA_ERROR("Resampler quality 'none' can not be used");
+			return false;
+		case audio::orchestra::resamplerQuality_low:
+			m_nbTaps = 16;
+			cutoffFactor = 0.85;
+			beta = 5.0;
+			break;
+		case audio::orchestra::resamplerQuality_medium:
+			m_nbTaps = 32;
+			cutoffFactor = 0.90;
+			beta = 7.5;
+			break;
+		case audio::orchestra::resamplerQuality_high:
+			m_nbTaps = 64;
+			cutoffFactor = 0.94;
+			beta = 10.0;
+			break;
+	}
+	m_inputRate = _inputRate;
+	m_outputRate = _outputRate;
+	m_nbChannels = _nbChannels;
+	uint32_t divisor = gcd(_inputRate, _outputRate);
+	m_nbPhases = _outputRate / divisor;
+	m_step = _inputRate / divisor;
+	if (m_nbPhases > maxNbPhases) {
+		m_step = uint32_t(double(_inputRate) * double(maxNbPhases) / double(_outputRate) + 0.5);
+		m_nbPhases = maxNbPhases;
+		ATA_WARNING("Resampling ratio " << _inputRate << "/" << _outputRate << " approximated with " << m_step << "/" << m_nbPhases);
+	}
+	// Low-pass at the lowest Nyquist frequency.
+	double cutoff = cutoffFactor;
+	if (_outputRate < _inputRate) {
+		cutoff *= double(_outputRate) / double(_inputRate);
+	}
+	generateFilter(cutoff, beta);
+	m_bufferCapacity = _maxInputFrames + 2*m_nbTaps;
+	m_buffer.resize(m_bufferCapacity * m_nbChannels, 0.0f);
+	reset();
+	ATA_INFO("Resampler " << _inputRate << " -> " << _outputRate << " phases=" << m_nbPhases << " step=" << m_step << " taps=" << m_nbTaps << " quality=" << _quality);
+	return true;
+}
+
+void audio::orchestra::Resampler::generateFilter(double _cutoff, double _beta) {
+	m_coefficients.resize(m_nbPhases * m_nbTaps, 0.0f);
+	double halfLength = double(m_nbTaps) * 0.5;
+	double normWindow = 1.0 / besselI0(_beta);
+	for (uint32_t ppp=0; ppp<m_nbPhases; ++ppp) {
+		double sum = 0.0;
+		float* coef = &m_coefficients[ppp * m_nbTaps];
+		for (uint32_t kkk=0; kkk<m_nbTaps; ++kkk) {
+			// distance (in input frames) between the tap and the output sample
+			double xxx = double(kkk) - (halfLength - 1.0) - double(ppp) / double(m_nbPhases);
+			double sinc = 1.0;
+			if (fabs(xxx) > 1.0e-9) {
+				sinc = sin(M_PI * _cutoff * xxx) / (M_PI * _cutoff * xxx);
+			}
+			double ratio = xxx / halfLength;
+			double window = 0.0;
+			if (fabs(ratio) < 1.0) {
+				window = besselI0(_beta * sqrt(1.0 - ratio * ratio)) * normWindow;
+			}
+			double value = sinc * window;
+			coef[kkk] = value;
+			sum += value;
+		}
+		// unity gain on each phase (no modulation of the DC)
+		for (uint32_t kkk=0; kkk<m_nbTaps; ++kkk) {
+			coef[kkk] = double(coef[kkk]) / sum;
+		}
+	}
+}
+
+void audio::orchestra::Resampler::reset() {
+	for (size_t iii=0; iii<m_buffer.size(); ++iii) {
+		m_buffer[iii] = 0.0f;
+	}
+	// The first output sample is aligned on the first input sample.
+	m_bufferFrames = m_nbTaps/2 - 1;
+	m_position = 0;
+	m_phase = 0;
+}
+
+uint32_t audio::orchestra::Resampler::getInputFrames(uint32_t _nbOutputFrames) const {
+	if (_nbOutputFrames == 0) {
+		return 0;
+	}
+	uint64_t lastPosition = uint64_t(m_position) + (uint64_t(m_phase) + uint64_t(_nbOutputFrames-1) * uint64_t(m_step)) / uint64_t(m_nbPhases);
+	uint64_t needed = lastPosition + m_nbTaps;
+	if (needed <= m_bufferFrames) {
+		return 0;
+	}
+	return needed - m_bufferFrames;
+}
+
+uint32_t audio::orchestra::Resampler::getOutputFrames() const {
+	if (m_position + m_nbTaps > m_bufferFrames) {
+		return 0;
+	}
+	uint64_t margin = m_bufferFrames - m_nbTaps - m_position;
+	return ((margin + 1) * uint64_t(m_nbPhases) - 1 - m_phase) / uint64_t(m_step) + 1;
+}
+
+uint32_t audio::orchestra::Resampler::push(const float* _input, uint32_t _nbFrames) {
+	if (m_bufferFrames + _nbFrames > m_bufferCapacity) {
+		// Remove the frames that are not used anymore.
+		uint32_t nbKeep = m_bufferFrames - m_position;
+		for (uint32_t ccc=0; ccc<m_nbChannels; ++ccc) {
+			float* channel = &m_buffer[ccc * m_bufferCapacity];
+			memmove(channel, channel + m_position, nbKeep * sizeof(float));
+		}
+		m_bufferFrames = nbKeep;
+		m_position = 0;
+	}
+	uint32_t nbFrames = _nbFrames;
+	if (m_bufferFrames + nbFrames > m_bufferCapacity) {
+		nbFrames = m_bufferCapacity - m_bufferFrames;
+		ATA_WARNING("Resampler overflow: drop " << _nbFrames - nbFrames << " frames");
+	}
+	for (uint32_t ccc=0; ccc<m_nbChannels; ++ccc) {
+		float* channel = &m_buffer[ccc * m_bufferCapacity + m_bufferFrames];
+		if (_input == null) {
+			memset(channel, 0, nbFrames * sizeof(float));
+			continue;
+		}
+		const float* input = _input + ccc;
+		for (uint32_t iii=0; iii<nbFrames; ++iii) {
+			channel[iii] = *input;
+			input += m_nbChannels;
+		}
+	}
+	m_bufferFrames += nbFrames;
+	return nbFrames;
+}
+
+uint32_t audio::orchestra::Resampler::pull(float* _output, uint32_t _nbFrames) {
+	uint32_t nbFrames = 0;
+	while (    nbFrames < _nbFrames
+	        && m_position + m_nbTaps <= m_bufferFrames) {
+		const float* coef = &m_coefficients[m_phase * m_nbTaps];
+		for (uint32_t ccc=0; ccc<m_nbChannels; ++ccc) {
+			*_output++ = audio::orchestra::simd::dotProduct(&m_buffer[ccc * m_bufferCapacity + m_position], coef, m_nbTaps);
+		}
+		m_phase += m_step;
+		m_position += m_phase / m_nbPhases;
+		m_phase %= m_nbPhases;
+		++nbFrames;
+	}
+	return nbFrames;
+}
+
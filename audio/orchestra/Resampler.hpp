@@ -0,0 +1,95 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license APACHE v2.0 (see license file)
+ */
+#pragma once
+
+#include <etk/types.hpp>
+#include <etk/Vector.hpp>
+#include <etk/Stream.hpp>
+
+namespace audio {
+	namespace orchestra {
+		enum resamplerQuality {
+			resamplerQuality_none, //!< No resampling: the stream is open only if the device support the sample rate
+			resamplerQuality_low, //!< 16 taps per phase (low CPU)
+			resamplerQuality_medium, //!< 32 taps per phase
+			resamplerQuality_high, //!< 64 taps per phase (-100dB stop band)
+		};
+		etk::Stream& operator <<(etk::Stream& _os, enum audio::orchestra::resamplerQuality _obj);
+		/**
+		 * @brief Polyphase sample rate converter (windowed sinc, interleaved float samples).
+		 * The ratio is reduced to L/M (L phases). The input is stored per channel to compute each output sample with
+		 * one vectorized dot product (SSE or NEON when availlable).
+		 */
+		class Resampler {
+			private:
+				uint32_t m_inputRate;
+				uint32_t m_outputRate;
+				uint32_t m_nbChannels;
+				uint32_t m_nbTaps; //!< Number of taps of one phase (multiple of 4)
+				uint32_t m_nbPhases; //!< L: number of phases of the filter
+				uint32_t m_step; //!< M: input step for one output sample (in phase unit)
+				etk::Vector<float> m_coefficients; //!< m_nbPhases * m_nbTaps coefficients
+				etk::Vector<float> m_buffer; //!< Input samples: m_nbChannels blocks of m_bufferCapacity frames
+				uint32_t m_bufferCapacity; //!< Number of frames that can be stored per channel
+				uint32_t m_bufferFrames; //!< Number of frames stored per channel
+				uint32_t m_position; //!< Index in m_buffer of the first input frame of the next output
+				uint32_t m_phase; //!< Phase of the next output
+			public:
+				Resampler();
+				/**
+				 * @brief Configure the converter (allocate all the buffers: no allocation in process).
+				 * @param[in] _inputRate Sample rate of the input.
+				 * @param[in] _outputRate Sample rate of the output.
+				 * @param[in] _nbChannels Number of interleaved channels.
+				 * @param[in] _quality Length of the filter.
+				 * @param[in] _maxInputFrames Maximum number of frames given in one call of push.
+				 * @return false if the configuration is not supported.
+				 */
+				bool init(uint32_t _inputRate,
+				          uint32_t _outputRate,
+				          uint32_t _nbChannels,
+				          enum audio::orchestra::resamplerQuality _quality,
+				          uint32_t _maxInputFrames);
+				/**
+				 * @brief Remove all the stored samples.
+				 */
+				void reset();
+				/**
+				 * @brief Get the number of input frames to push to get exactly _nbOutputFrames with pull.
+				 * @param[in] _nbOutputFrames Number of frames requested at the output.
+				 */
+				uint32_t getInputFrames(uint32_t _nbOutputFrames) const;
+				/**
+				 * @brief Get the number of output frames availlable with the stored input.
+				 */
+				uint32_t getOutputFrames() const;
+				/**
+				 * @brief Get the delay of the filter.
+				 * @return Number of input frames.
+				 */
+				uint32_t getDelay() const {
+					return m_nbTaps/2;
+				}
+				/**
+				 * @brief Store input samples.
+				 * @param[in] _input Interleaved input samples (null: push silence).
+				 * @param[in] _nbFrames Number of frames.
+				 * @return Number of frames stored (lower than _nbFrames if the internal buffer is full).
+				 */
+				uint32_t push(const float* _input, uint32_t _nbFrames);
+				/**
+				 * @brief Generate output samples.
+				 * @param[out] _output Interleaved output samples.
+				 * @param[in] _nbFrames Maximum number of frames to generate.
+				 * @return Number of frames generated.
+				 */
+				uint32_t pull(float* _output, uint32_t _nbFrames);
+			private:
+				void generateFilter(double _cutoff, double _beta);
+		};
+	}
+}
+
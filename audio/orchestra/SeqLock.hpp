@@ -0,0 +1,70 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license APACHE v2.0 (see license file)
+ */
+#pragma once
+
+#include <etk/types.hpp>
+
+namespace audio {
+	namespace orchestra {
+		/**
+		 * @brief Sequence lock: one writer (the IO thread) publish a small value, the readers copy it without lock and
+		 * without system call (they retry if the value changed during the copy).
+		 * @note TYPE must be a trivially copyable structure.
+		 */
+		template<class TYPE>
+		class SeqLock {
+			private:
+				uint32_t m_sequence; //!< odd while the writer update the value, 0 if never written
+				TYPE m_value;
+			public:
+				SeqLock() :
+				  m_sequence(0),
+				  m_value() {
+
+				}
+				/**
+				 * @brief Publish a new value (only one thread can write).
+				 * @param[in] _value New value.
+				 */
+				void write(const TYPE& _value) {
+					uint32_t sequence = __atomic_load_n(&m_sequence, __ATOMIC_RELAXED);
+					__atomic_store_n(&m_sequence, sequence + 1, __ATOMIC_RELAXED);
+					__atomic_thread_fence(__ATOMIC_RELEASE);
+					m_value = _value;
+					__atomic_store_n(&m_sequence, sequence + 2, __ATOMIC_RELEASE);
+				}
+				/**
+				 * @brief Get a coherent copy of the last published value.
+				 * @param[out] _value Copy of the value.
+				 * @return false if no value has been published.
+				 */
+				bool read(TYPE& _value) const {
+					while (true) {
+						uint32_t sequence = __atomic_load_n(&m_sequence, __ATOMIC_ACQUIRE);
+						if (sequence == 0) {
+							return false;
+						}
+						if ((sequence & 1) != 0) {
+							// write in progress
+							continue;
+						}
+						_value = m_value;
+						__atomic_thread_fence(__ATOMIC_ACQUIRE);
+						if (__atomic_load_n(&m_sequence, __ATOMIC_RELAXED) == sequence) {
+							return true;
+						}
+					}
+				}
+				/**
+				 * @brief Forget the published value (must not be called concurrently with write).
+				 */
+				void reset() {
+					__atomic_store_n(&m_sequence, 0, __ATOMIC_RELEASE);
+				}
+		};
+	}
+}
+
@@ -0,0 +1,227 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license APACHE v2.0 (see license file)
+ */
+
+#include <audio/orchestra/StreamBuffer.hpp>
+#include <audio/orchestra/ThreadConfig.hpp>
+#include <audio/orchestra/debug.hpp>
+#include <etk/Vector.hpp>
+#include <ethread/Mutex.hpp>
+#include <stdlib.h>
+#include <string.h>
+#if defined(_WIN32)
+	#include <malloc.h>
+#else
+	#include <errno.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+#endif
+
+static const size_t hugePageSize = 2*1024*1024; //!< Size of a transparent huge page (x86-64 and arm64 with 4k pages)
+static const size_t poolMaxBytes = 32*1024*1024; //!< Maximum size of the free blocks kept in the pool
+
+/**
+ * @brief Block of memory stored in the pool.
+ */
+class StreamBufferBlock {
+	public:
+		char* data;
+		size_t capacity;
+		bool locked; //!< The block is locked in memory (it stay locked in the pool)
+		bool hugePages;
+};
+
+// The pool is never destroyed: a stream can be closed in the destructor of a static object.
+static ethread::Mutex& getPoolMutex() {
+	static ethread::Mutex* mutex = new ethread::Mutex();
+	return *mutex;
+}
+
+static etk::Vector<StreamBufferBlock>& getPool() {
+	static etk::Vector<StreamBufferBlock>* pool = new etk::Vector<StreamBufferBlock>();
+	return *pool;
+}
+
+static size_t g_poolBytes = 0; //!< Size of the free blocks stored in the pool (protected by the pool mutex)
+
+static size_t getPageSize() {
+	#if defined(_WIN32)
+		return 4096;
+	#else
+		static size_t pageSize = sysconf(_SC_PAGESIZE);
+		return pageSize;
+	#endif
+}
+
+static char* allocateBlock(size_t _capacity, bool _hugePages) {
+	#if defined(_WIN32)
+		return static_cast<char*>(_aligned_malloc(_capacity, getPageSize()));
+	#else
+		size_t align = getPageSize();
+		if (_hugePages == true) {
+			align = hugePageSize;
+		}
+		void* data = null;
+		if (posix_memalign(&data, align, _capacity) != 0) {
+			return null;
+		}
+		#if defined(MADV_HUGEPAGE)
+			if (    _hugePages == true
+			     && madvise(data, _capacity, MADV_HUGEPAGE) != 0) {
+				ATA_WARNING("Transparent huge pages are not available: " << strerror(errno));
+			}
+		#endif
+		return static_cast<char*>(data);
+	#endif
+}
+
+static void freeBlock(StreamBufferBlock& _block) {
+	if (_block.locked == true) {
+		audio::orchestra::ThreadConfig::unlockBuffer(_block.data, _block.capacity);
+	}
+	#if defined(_WIN32)
+		_aligned_free(_block.data);
+	#else
+		free(_block.data);
+	#endif
+	_block.data = null;
+}
+
+/**
+ * @brief Get a block of at least _size bytes (the smallest free block of the pool, or a new block).
+ */
+static bool takeBlock(size_t _size, bool _hugePages, StreamBufferBlock& _block) {
+	#if !defined(__linux__)
+		_hugePages = false;
+	#endif
+	size_t granularity = getPageSize();
+	if (_hugePages == true) {
+		granularity = hugePageSize;
+	}
+	size_t capacity = (_size + granularity - 1) / granularity * granularity;
+	{
+		ethread::UniqueLock lock(getPoolMutex());
+		etk::Vector<StreamBufferBlock>& pool = getPool();
+		size_t best = pool.size();
+		for (size_t iii=0; iii<pool.size(); ++iii) {
+			if (    pool[iii].hugePages == _hugePages
+			     && pool[iii].capacity >= capacity
+			     && (    best == pool.size()
+			          || pool[iii].capacity < pool[best].capacity)) {
+				best = iii;
+			}
+		}
+		if (best != pool.size()) {
+			_block = pool[best];
+			g_poolBytes -= _block.capacity;
+			pool.erase(pool.begin() + best);
+			return true;
+		}
+	}
+	_block.data = allocateBlock(capacity, _hugePages);
+	_block.capacity = capacity;
+	_block.locked = false;
+	_block.hugePages = _hugePages;
+	return _block.data != null;
+}
+
+static void giveBlock(StreamBufferBlock& _block) {
+	{
+		ethread::UniqueLock lock(getPoolMutex());
+		if (g_poolBytes + _block.capacity <= poolMaxBytes) {
+			g_poolBytes += _block.capacity;
+			getPool().pushBack(_block);
+			return;
+		}
+	}
+	freeBlock(_block);
+}
+
+audio::orchestra::StreamBuffer::StreamBuffer() :
+  m_data(null),
+  m_size(0),
+  m_capacity(0),
+  m_locked(false),
+  m_hugeBlock(false),
+  m_lockMemory(false),
+  m_hugePages(false) {
+
+}
+
+audio::orchestra::StreamBuffer::~StreamBuffer() {
+	clear();
+}
+
+void audio::orchestra::StreamBuffer::configure(bool _lockMemory, bool _hugePages) {
+	m_lockMemory = _lockMemory;
+	m_hugePages = _hugePages;
+}
+
+void audio::orchestra::StreamBuffer::resize(size_t _size, char _value) {
+	if (_size > m_capacity) {
+		StreamBufferBlock block;
+		if (takeBlock(_size, m_hugePages, block) == false) {
+			ATA_ERROR("Can not allocate a stream buffer of " << int64_t(_size) << " bytes");
+			clear();
+			return;
+		}
+		if (m_size != 0) {
+			memcpy(block.data, m_data, m_size);
+		}
+		size_t size = m_size;
+		clear();
+		m_data = block.data;
+		m_size = size;
+		m_capacity = block.capacity;
+		m_locked = block.locked;
+		m_hugeBlock = block.hugePages;
+		if (m_lockMemory == true) {
+			lock();
+		}
+	}
+	if (_size > m_size) {
+		memset(m_data + m_size, _value, _size - m_size);
+	}
+	m_size = _size;
+}
+
+void audio::orchestra::StreamBuffer::clear() {
+	if (m_data != null) {
+		StreamBufferBlock block;
+		block.data = m_data;
+		block.capacity = m_capacity;
+		block.locked = m_locked;
+		block.hugePages = m_hugeBlock;
+		giveBlock(block);
+	}
+	m_data = null;
+	m_size = 0;
+	m_capacity = 0;
+	m_locked = false;
+	m_hugeBlock = false;
+}
+
+bool audio::orchestra::StreamBuffer::lock() {
+	if (    m_data == null
+	     || m_locked == true) {
+		return true;
+	}
+	m_locked = audio::orchestra::ThreadConfig::lockBuffer(m_data, m_capacity);
+	return m_locked;
+}
+
+void audio::orchestra::StreamBuffer::purgePool() {
+	etk::Vector<StreamBufferBlock> pool;
+	{
+		ethread::UniqueLock lock(getPoolMutex());
+		pool = getPool();
+		getPool().clear();
+		g_poolBytes = 0;
+	}
+	for (size_t iii=0; iii<pool.size(); ++iii) {
+		freeBlock(pool[iii]);
+	}
+}
+
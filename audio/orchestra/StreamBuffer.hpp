@@ -0,0 +1,79 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license APACHE v2.0 (see license file)
+ */
+#pragma once
+
+#include <etk/types.hpp>
+
+namespace audio {
+	namespace orchestra {
+		/**
+		 * @brief Audio buffer of a stream (subset of the interface of etk::Vector<char>).
+		 * The memory is taken in a pool shared by all the streams: a stream that is closed give back its blocks, and the
+		 * next opened stream reuse them (already allocated, locked and faulted) without calling the system allocator.
+		 * @note The blocks are aligned on a page (at least alignment bytes): the SIMD loops can use aligned accesses on
+		 *       the start of the buffers, and a locked block does not share its pages with other data.
+		 */
+		class StreamBuffer {
+			public:
+				static const size_t alignment = 64; //!< Minimum alignment of the data (cache line and largest SIMD register).
+			private:
+				char* m_data; //!< Start of the block (null if no block)
+				size_t m_size; //!< Number of bytes used
+				size_t m_capacity; //!< Size of the block
+				bool m_locked; //!< The block is locked in memory
+				bool m_hugeBlock; //!< The block is backed by huge pages
+				bool m_lockMemory; //!< Lock and pre-fault the next blocks (ThreadConfig::lockMemory)
+				bool m_hugePages; //!< Request huge pages for the next blocks (ThreadConfig::hugePages)
+			public:
+				StreamBuffer();
+				~StreamBuffer();
+				StreamBuffer(const StreamBuffer&) = delete;
+				StreamBuffer& operator=(const StreamBuffer&) = delete;
+				/**
+				 * @brief Set the properties of the blocks taken in the pool (apply at the next allocation).
+				 * @param[in] _lockMemory Lock the block in memory and touch all its pages (no page fault in the callback).
+				 * @param[in] _hugePages Back the block with transparent huge pages (the size is rounded to a huge page).
+				 */
+				void configure(bool _lockMemory, bool _hugePages);
+				/**
+				 * @brief Change the size of the buffer (the content is kept).
+				 * @param[in] _size New size in bytes.
+				 * @param[in] _value Value of the added bytes.
+				 * @note On allocation error the buffer is empty (size() == 0).
+				 */
+				void resize(size_t _size, char _value=0);
+				/**
+				 * @brief Give the block back to the pool.
+				 */
+				void clear();
+				/**
+				 * @brief Lock the current block in memory (no effect if it is already locked).
+				 * @return false if the block can not be locked (RLIMIT_MEMLOCK).
+				 */
+				bool lock();
+				size_t size() const {
+					return m_size;
+				}
+				char* dataPointer() {
+					return m_data;
+				}
+				const char* dataPointer() const {
+					return m_data;
+				}
+				char& operator[](size_t _pos) {
+					return m_data[_pos];
+				}
+				const char& operator[](size_t _pos) const {
+					return m_data[_pos];
+				}
+				/**
+				 * @brief Free the blocks stored in the pool (they are allocated again by the next streams).
+				 */
+				static void purgePool();
+		};
+	}
+}
+
@@ -15,11 +15,40 @@ static const char* listValue[] = {
 	"soft"
 };
 
+static const char* listValueLatencyClass[] = {
+	"default",
+	"ultraLow",
+	"low",
+	"powerSaving"
+};
+
 etk::Stream& audio::orchestra::operator <<(etk::Stream& _os, enum audio::orchestra::timestampMode _obj) {
 	_os << listValue[_obj];
 	return _os;
 }
 
+etk::Stream& audio::orchestra::operator <<(etk::Stream& _os, enum audio::orchestra::latencyClass _obj) {
+	_os << listValueLatencyClass[_obj];
+	return _os;
+}
+
+uint32_t audio::orchestra::StreamOptions::getTargetLatency() const {
+	if (targetLatency != 0) {
+		return targetLatency;
+	}
+	switch (latency) {
+		case audio::orchestra::latencyClass_default:
+			return 0;
+		case audio::orchestra::latencyClass_ultraLow:
+			return 3000;
+		case audio::orchestra::latencyClass_low:
+			return 10000;
+		case audio::orchestra::latencyClass_powerSaving:
+			return 500000;
+	}
+	return 0;
+}
+
 namespace etk {
 	template <> bool from_string<enum audio::orchestra::timestampMode>(enum audio::orchestra::timestampMode& _variableRet, const etk::String& _value) {
 		if (_value == "hardware") {
@@ -40,6 +69,20 @@ namespace etk {
 	template <enum audio::orchestra::timestampMode> etk::String toString(const enum audio::orchestra::timestampMode& _variable) {
 		return listValue[_variable];
 	}
+	
+	template <> bool from_string<enum audio::orchestra::latencyClass>(enum audio::orchestra::latencyClass& _variableRet, const etk::String& _value) {
+		for (int32_t iii=0; iii<4; ++iii) {
+			if (_value == listValueLatencyClass[iii]) {
+				_variableRet = audio::orchestra::latencyClass(iii);
+				return true;
+			}
+		}
+		return false;
+	}
+	
+	template <enum audio::orchestra::latencyClass> etk::String toString(const enum audio::orchestra::latencyClass& _variable) {
+		return listValueLatencyClass[_variable];
+	}
 }
 
 
@@ -7,6 +7,8 @@
 #pragma once
 
 #include <audio/orchestra/Flags.hpp>
+#include <audio/orchestra/ThreadConfig.hpp>
+#include <audio/orchestra/Resampler.hpp>
 #include <etk/String.hpp>
 
 namespace audio {
@@ -17,6 +19,13 @@ namespace audio {
 			timestampMode_soft, //!< Simulate all timestamp.
 		};
 		etk::Stream& operator <<(etk::Stream& _os, enum audio::orchestra::timestampMode _obj);
+		enum latencyClass {
+			latencyClass_default, //!< Default configuration of the backend.
+			latencyClass_ultraLow, //!< Monitoring: smallest buffering, wakeup on each period (high CPU load, xrun risk).
+			latencyClass_low, //!< Interactive streams.
+			latencyClass_powerSaving, //!< Background/recording streams: large buffering, few wakeups.
+		};
+		etk::Stream& operator <<(etk::Stream& _os, enum audio::orchestra::latencyClass _obj);
 		
 		class StreamOptions {
 			public:
@@ -24,11 +33,30 @@ namespace audio {
 				uint32_t numberOfBuffers; //!< Number of stream buffers.
 				etk::String streamName; //!< A stream name (currently used only in Jack).
 				enum timestampMode mode; //!< mode of timestamping data...
+				enum latencyClass latency; //!< Class of latency of the stream.
+				uint32_t targetLatency; //!< Target latency of the stream buffering in micro-seconds (0: defined by the latency class).
+				audio::orchestra::ThreadConfig thread; //!< Configuration of the IO thread (scheduling, affinity, memory lock).
+				enum resamplerQuality resampling; //!< Resampling stage used when the device does not support the sample rate (the device keep a fixed period, the number of frames of the callback can change of +/-1 frame between 2 calls).
+				uint32_t callbackBatch; //!< Number of periods given in one call of the callback (0 or 1: one call per period). The record is given one batch late and the latency of the playback increase of the same duration.
+				bool reconnect; //!< Reopen the device with the same parameters when it is lost (unplugged), or a StreamParameters::fallbackDeviceName. The IO thread and the buffers are kept, the gap is given to the callback as silence (status::reconnect). Not supported by Jack (a warning is displayed at the open).
+				uint32_t reconnectTimeout; //!< Maximum time to find a device after a loss (ms): the stream is dead after it.
 				// Default constructor.
 				StreamOptions() :
 				  flags(),
 				  numberOfBuffers(0),
-				  mode(timestampMode_Hardware) {}
+				  mode(timestampMode_Hardware),
+				  latency(latencyClass_default),
+				  targetLatency(0),
+				  thread(),
+				  resampling(resamplerQuality_none),
+				  callbackBatch(0),
+				  reconnect(false),
+				  reconnectTimeout(5000) {}
+				/**
+				 * @brief Get the latency requested for the buffering of the stream.
+				 * @return The target latency in micro-seconds (0 if the backend choose).
+				 */
+				uint32_t getTargetLatency() const;
 		};
 	}
 }
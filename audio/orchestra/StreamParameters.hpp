@@ -6,6 +6,9 @@
  */
 #pragma once
 
+#include <etk/Vector.hpp>
+#include <audio/channel.hpp>
+
 namespace audio {
 	namespace orchestra {
 		/**
@@ -17,6 +20,22 @@ namespace audio {
 				etk::String deviceName; //!< name of the device (if deviceId==-1 this must not be == "", and the oposite ...)
 				uint32_t nChannels; //!< Number of channels.
 				uint32_t firstChannel; //!< First channel index on device (default = 0).
+				etk::Vector<etk::String> aggregateDeviceName; //!< Devices aggregated after the main one: their channels are appended to the stream and drift compensated on the main device clock (only ALSA).
+				/**
+				 * @brief Routing of the user channels on the device: user channel i <=> device channel channelMap[i] (replace firstChannel).
+				 * @note The device is open with all the channels up to the highest one of the map, the others are kept silent.
+				 */
+				etk::Vector<uint32_t> channelMap;
+				etk::Vector<audio::channel> channelPosition; //!< Routing by position: the device channels are found with DeviceInfo::channels (if channelMap is empty).
+				/**
+				 * @brief Mixing matrix between the user channels and the routed device channels (channelMap, or the channels
+				 * from firstChannel if no map), row-major [destination][source]:
+				 *  - output: device routed channel k = sum(mixMatrix[k*nChannels + i] * user channel i)
+				 *  - input: user channel i = sum(mixMatrix[i*nbRouted + k] * device routed channel k)
+				 * The number of routed channels is mixMatrix.size()/nChannels (empty: direct copy of the channels).
+				 */
+				etk::Vector<float> mixMatrix;
+				etk::Vector<etk::String> fallbackDeviceName; //!< Devices used when the device is lost (StreamOptions::reconnect), tried in order after the device itself.
 				// Default constructor.
 				StreamParameters() :
 				  deviceId(-1),
@@ -0,0 +1,217 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license APACHE v2.0 (see license file)
+ */
+
+#include <audio/orchestra/ThreadConfig.hpp>
+#include <audio/orchestra/debug.hpp>
+
+#if !defined(_WIN32)
+	#include <pthread.h>
+	#include <sched.h>
+	#include <errno.h>
+	#include <string.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/resource.h>
+#endif
+#if defined(__linux__)
+	#include <sys/syscall.h>
+#endif
+#if defined(__SSE__) || defined(__x86_64__)
+	#include <xmmintrin.h>
+#endif
+
+static const int32_t defaultRealTimePriority = 70; //!< Priority used when the user does not set it (over the IRQ threads default: 50)
+static const int32_t fallbackNiceValue = -11; //!< Nice value when the real-time scheduling is refused (rtkit default)
+static const size_t prefaultStackSize = 64*1024;
+
+static const char* listValueSchedulerPolicy[] = {
+	"default",
+	"fifo",
+	"roundRobin"
+};
+
+etk::Stream& audio::orchestra::operator <<(etk::Stream& _os, enum audio::orchestra::schedulerPolicy _obj) {
+	_os << listValueSchedulerPolicy[_obj];
+	return _os;
+}
+
+namespace etk {
+	template <> bool from_string<enum audio::orchestra::schedulerPolicy>(enum audio::orchestra::schedulerPolicy& _variableRet, const etk::String& _value) {
+		for (int32_t iii=0; iii<3; ++iii) {
+			if (_value == listValueSchedulerPolicy[iii]) {
+				_variableRet = audio::orchestra::schedulerPolicy(iii);
+				return true;
+			}
+		}
+		return false;
+	}
+	template <enum audio::orchestra::schedulerPolicy> etk::String toString(const enum audio::orchestra::schedulerPolicy& _variable) {
+		return listValueSchedulerPolicy[_variable];
+	}
+}
+
+static void flushDenormals() {
+	#if defined(__SSE__) || defined(__x86_64__)
+		// FTZ (bit 15) and DAZ (bit 6)
+		_mm_setcsr(_mm_getcsr() | 0x8040);
+	#elif defined(__aarch64__)
+		// FZ (bit 24)
+		uint64_t fpcr;
+		__asm__ __volatile__("mrs %0, fpcr" : "=r"(fpcr));
+		fpcr |= (1 << 24);
+		__asm__ __volatile__("msr fpcr, %0" : : "r"(fpcr));
+	#elif defined(__arm__) && defined(__ARM_FP)
+		// FZ (bit 24)
+		uint32_t fpscr;
+		__asm__ __volatile__("vmrs %0, fpscr" : "=r"(fpscr));
+		fpscr |= (1 << 24);
+		__asm__ __volatile__("vmsr fpscr, %0" : : "r"(fpscr));
+	#else
+		ATA_DEBUG("Flush denormals is not supported on this architecture");
+	#endif
+}
+
+#if !defined(_WIN32)
+static bool setRealTime(int32_t _policy, int32_t _priority) {
+	struct sched_param param;
+	memset(&param, 0, sizeof(param));
+	param.sched_priority = _priority;
+	int32_t ret = pthread_setschedparam(pthread_self(), _policy, &param);
+	if (ret == 0) {
+		return true;
+	}
+	if (ret != EPERM) {
+		ATA_ERROR("Can not set the real-time scheduling: " << strerror(ret));
+		return false;
+	}
+	#if defined(__linux__)
+		// Not privileged: use the real-time budget given by the limits (as done by rtkit).
+		struct rlimit limit;
+		if (getrlimit(RLIMIT_RTPRIO, &limit) == 0) {
+			if (limit.rlim_cur < limit.rlim_max) {
+				limit.rlim_cur = limit.rlim_max;
+				setrlimit(RLIMIT_RTPRIO, &limit);
+			}
+			if (limit.rlim_cur > 0) {
+				if (param.sched_priority > int32_t(limit.rlim_cur)) {
+					ATA_WARNING("Real-time priority " << _priority << " clamped to RLIMIT_RTPRIO=" << int32_t(limit.rlim_cur));
+					param.sched_priority = limit.rlim_cur;
+				}
+				ret = pthread_setschedparam(pthread_self(), _policy, &param);
+				if (ret == 0) {
+					return true;
+				}
+			}
+		}
+		// Last chance: high priority in the normal scheduler.
+		if (setpriority(PRIO_PROCESS, syscall(SYS_gettid), fallbackNiceValue) == 0) {
+			ATA_WARNING("Real-time scheduling refused ==> fall back on nice=" << fallbackNiceValue);
+			return false;
+		}
+	#endif
+	ATA_WARNING("Real-time scheduling refused (no permission)");
+	return false;
+}
+#endif
+
+bool audio::orchestra::ThreadConfig::applyCurrentThread() const {
+	bool ret = true;
+	if (flushDenormals == true) {
+		::flushDenormals();
+	}
+	#if defined(__linux__)
+		if (cpuAffinity != 0) {
+			cpu_set_t cpuSet;
+			CPU_ZERO(&cpuSet);
+			for (int32_t iii=0; iii<64 && iii<CPU_SETSIZE; ++iii) {
+				if ((cpuAffinity & (uint64_t(1) << iii)) != 0) {
+					CPU_SET(iii, &cpuSet);
+				}
+			}
+			int32_t err = pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+			if (err != 0) {
+				ATA_ERROR("Can not set the CPU affinity of the IO thread: " << strerror(err));
+				ret = false;
+			}
+		}
+	#else
+		if (cpuAffinity != 0) {
+			ATA_WARNING("CPU affinity is not supported on this platform");
+		}
+	#endif
+	if (policy != audio::orchestra::schedulerPolicy_default) {
+		#if !defined(_WIN32)
+			int32_t prio = priority;
+			if (prio <= 0) {
+				prio = defaultRealTimePriority;
+			}
+			int32_t schedPolicy = SCHED_FIFO;
+			if (policy == audio::orchestra::schedulerPolicy_roundRobin) {
+				schedPolicy = SCHED_RR;
+			}
+			if (prio < sched_get_priority_min(schedPolicy)) {
+				prio = sched_get_priority_min(schedPolicy);
+			}
+			if (prio > sched_get_priority_max(schedPolicy)) {
+				prio = sched_get_priority_max(schedPolicy);
+			}
+			if (setRealTime(schedPolicy, prio) == false) {
+				ret = false;
+			} else {
+				ATA_INFO("IO thread scheduling: " << policy << " priority=" << prio);
+			}
+		#else
+			ATA_WARNING("Real-time scheduling is not supported on this platform");
+			ret = false;
+		#endif
+	}
+	if (lockMemory == true) {
+		prefaultStack();
+	}
+	return ret;
+}
+
+bool audio::orchestra::ThreadConfig::lockBuffer(void* _data, size_t _size) {
+	if (    _data == null
+	     || _size == 0) {
+		return true;
+	}
+	bool ret = true;
+	#if !defined(_WIN32)
+		if (mlock(_data, _size) != 0) {
+			ATA_WARNING("Can not lock " << int64_t(_size) << " bytes in memory: " << strerror(errno) << " (RLIMIT_MEMLOCK)");
+			ret = false;
+		}
+		// Touch all the pages (no page fault in the first callback).
+		size_t pageSize = sysconf(_SC_PAGESIZE);
+		volatile char* data = static_cast<volatile char*>(_data);
+		for (size_t iii=0; iii<_size; iii+=pageSize) {
+			data[iii] = data[iii];
+		}
+		data[_size-1] = data[_size-1];
+	#endif
+	return ret;
+}
+
+void audio::orchestra::ThreadConfig::unlockBuffer(void* _data, size_t _size) {
+	if (    _data == null
+	     || _size == 0) {
+		return;
+	}
+	#if !defined(_WIN32)
+		munlock(_data, _size);
+	#endif
+}
+
+void audio::orchestra::ThreadConfig::prefaultStack() {
+	volatile char stack[prefaultStackSize];
+	for (size_t iii=0; iii<prefaultStackSize; iii+=256) {
+		stack[iii] = 0;
+	}
+	// The array is used after the writes: the compiler can not remove the touch of the pages.
+	__asm__ __volatile__("" : : "r"(stack) : "memory");
+}
+
@@ -0,0 +1,68 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license APACHE v2.0 (see license file)
+ */
+#pragma once
+
+#include <etk/types.hpp>
+#include <etk/Stream.hpp>
+
+namespace audio {
+	namespace orchestra {
+		enum schedulerPolicy {
+			schedulerPolicy_default, //!< Keep the scheduling of the backend (nice value)
+			schedulerPolicy_fifo, //!< Real-time SCHED_FIFO
+			schedulerPolicy_roundRobin, //!< Real-time SCHED_RR
+		};
+		etk::Stream& operator <<(etk::Stream& _os, enum audio::orchestra::schedulerPolicy _obj);
+		/**
+		 * @brief Configuration of the IO thread that call the user callback.
+		 */
+		class ThreadConfig {
+			public:
+				enum schedulerPolicy policy; //!< Scheduling policy of the IO thread.
+				int32_t priority; //!< Real-time priority [1..99] (0: default value)
+				uint64_t cpuAffinity; //!< Bit-mask of the CPU where the IO thread can run (0: no constraint)
+				bool lockMemory; //!< Lock in memory and pre-fault the stream buffers and the stack of the IO thread (no page fault in the callback)
+				bool hugePages; //!< Linux: back the stream buffers with transparent huge pages (each buffer use at least 2 MiB)
+				bool flushDenormals; //!< Set the flush-to-zero and denormals-are-zero mode of the FPU of the IO thread
+				int32_t sharedThread; //!< ALSA: index of a shared IO thread that drive many streams (-1: one IO thread per stream)
+				ThreadConfig() :
+				  policy(schedulerPolicy_default),
+				  priority(0),
+				  cpuAffinity(0),
+				  lockMemory(false),
+				  hugePages(false),
+				  flushDenormals(true),
+				  sharedThread(-1) {
+					// nothing to do ...
+				}
+				/**
+				 * @brief Apply the scheduling policy, the affinity and the FPU mode on the current thread.
+				 * @note When the real-time scheduling is refused, the priority is clamped to RLIMIT_RTPRIO, and the
+				 *       thread fall back on a high nice value (as done by rtkit).
+				 * @return false if the thread does not run with the requested policy.
+				 */
+				bool applyCurrentThread() const;
+				/**
+				 * @brief Lock a buffer in memory and touch all its pages.
+				 * @param[in] _data Pointer on the buffer.
+				 * @param[in] _size Size of the buffer in bytes.
+				 * @return false if the buffer can not be locked (RLIMIT_MEMLOCK).
+				 */
+				static bool lockBuffer(void* _data, size_t _size);
+				/**
+				 * @brief Unlock a buffer locked with lockBuffer.
+				 * @param[in] _data Pointer on the buffer.
+				 * @param[in] _size Size of the buffer in bytes.
+				 */
+				static void unlockBuffer(void* _data, size_t _size);
+				/**
+				 * @brief Pre-fault the stack of the current thread.
+				 */
+				static void prefaultStack();
+		};
+	}
+}
+
@@ -0,0 +1,156 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license APACHE v2.0 (see license file)
+ */
+#pragma once
+
+#include <etk/types.hpp>
+#include <etk/Vector.hpp>
+#include <etk/Function.hpp>
+#include <audio/format.hpp>
+#include <audio/Time.hpp>
+#include <audio/orchestra/status.hpp>
+
+namespace audio {
+	namespace orchestra {
+		/**
+		 * @brief Organisation of the samples in the buffers of a typed callback.
+		 */
+		enum layout {
+			layout_interleaved, //!< One buffer, the samples of a frame are contiguous (audio::orchestra::FrameSpan)
+			layout_planar, //!< One buffer per channel (audio::orchestra::ChannelArray), the stream is open with Flags::m_planar
+		};
+		/**
+		 * @brief Format of the stream for a sample type (only the specialized types can be used).
+		 */
+		template<typename SampleT> class SampleFormat;
+		template<> class SampleFormat<int8_t> {
+			public:
+				static const enum audio::format value = audio::format_int8;
+		};
+		template<> class SampleFormat<int16_t> {
+			public:
+				static const enum audio::format value = audio::format_int16;
+		};
+		template<> class SampleFormat<int32_t> {
+			public:
+				static const enum audio::format value = audio::format_int32;
+		};
+		template<> class SampleFormat<float> {
+			public:
+				static const enum audio::format value = audio::format_float;
+		};
+		template<> class SampleFormat<double> {
+			public:
+				static const enum audio::format value = audio::format_double;
+		};
+		/**
+		 * @brief View on the interleaved frames of a callback buffer.
+		 */
+		template<typename SampleT> class FrameSpan {
+			private:
+				SampleT* m_data; //!< First sample (null if the stream has no buffer in this direction)
+				uint32_t m_nbFrames; //!< Number of frames
+				uint32_t m_nbChannels; //!< Number of samples in one frame
+			public:
+				FrameSpan(SampleT* _data, uint32_t _nbFrames, uint32_t _nbChannels) :
+				  m_data(_data),
+				  m_nbFrames(_nbFrames),
+				  m_nbChannels(_nbChannels) {
+
+				}
+				SampleT* data() const {
+					return m_data;
+				}
+				/**
+				 * @brief Get the number of frames.
+				 */
+				uint32_t size() const {
+					return m_nbFrames;
+				}
+				uint32_t channels() const {
+					return m_nbChannels;
+				}
+				bool empty() const {
+					return m_data == null;
+				}
+				/**
+				 * @brief Get the first sample of a frame.
+				 * @param[in] _frame Index of the frame.
+				 */
+				SampleT* operator[](size_t _frame) const {
+					return m_data + _frame*m_nbChannels;
+				}
+		};
+		/**
+		 * @brief View on the channels of a planar callback buffer.
+		 */
+		template<typename SampleT> class ChannelArray {
+			private:
+				SampleT* const* m_channels; //!< One pointer per channel (null if the stream has no buffer in this direction)
+				uint32_t m_nbFrames; //!< Number of frames of each channel
+				uint32_t m_nbChannels; //!< Number of channels
+			public:
+				ChannelArray(SampleT* const* _channels, uint32_t _nbFrames, uint32_t _nbChannels) :
+				  m_channels(_channels),
+				  m_nbFrames(_nbFrames),
+				  m_nbChannels(_nbChannels) {
+
+				}
+				/**
+				 * @brief Get the number of frames.
+				 */
+				uint32_t size() const {
+					return m_nbFrames;
+				}
+				uint32_t channels() const {
+					return m_nbChannels;
+				}
+				bool empty() const {
+					return m_channels == null;
+				}
+				/**
+				 * @brief Get the samples of a channel.
+				 * @param[in] _channel Index of the channel.
+				 */
+				SampleT* operator[](size_t _channel) const {
+					return m_channels[_channel];
+				}
+		};
+		/**
+		 * @brief Typed view of a callback buffer (selected at compile time from the layout).
+		 */
+		template<typename SampleT, enum audio::orchestra::layout Layout> class BlockView;
+		template<typename SampleT> class BlockView<SampleT, audio::orchestra::layout_interleaved> {
+			public:
+				typedef audio::orchestra::FrameSpan<SampleT> type;
+				template<typename VoidT> static type create(VoidT* _buffer, uint32_t _nbFrames, uint32_t _nbChannels) {
+					return type(static_cast<SampleT*>(_buffer), _nbFrames, _nbChannels);
+				}
+		};
+		template<typename SampleT> class BlockView<SampleT, audio::orchestra::layout_planar> {
+			public:
+				typedef audio::orchestra::ChannelArray<SampleT> type;
+				template<typename VoidT> static type create(VoidT* _buffer, uint32_t _nbFrames, uint32_t _nbChannels) {
+					return type(static_cast<SampleT* const*>(_buffer), _nbFrames, _nbChannels);
+				}
+		};
+		/**
+		 * @brief Typed callback function prototype (Interface::openStream<SampleT, Layout>).
+		 * @param _input Record samples (empty() for an output stream).
+		 * @param _timeInput Timestamp of the first record sample.
+		 * @param _output Samples to play, to be written by the client (empty() for an input stream).
+		 * @param _timeOutput Timestamp of the first played sample.
+		 * @param _status List of error that occured in the laps of time.
+		 * @return 0 to continue, 1 to stop the stream, 2 to abort it.
+		 */
+		template<typename SampleT, enum audio::orchestra::layout Layout>
+		using TypedCallback = etk::Function<int32_t (const typename audio::orchestra::BlockView<const SampleT, Layout>::type& _input,
+		                                             const audio::Time& _timeInput,
+		                                             const typename audio::orchestra::BlockView<SampleT, Layout>::type& _output,
+		                                             const audio::Time& _timeOutput,
+		                                             const etk::Vector<audio::orchestra::status>& _status)>;
+	}
+}
+
@@ -15,6 +15,10 @@
 #include <etk/stdTools.hpp>
 #include <ethread/tools.hpp>
 #include <audio/orchestra/api/Alsa.hpp>
+#include <audio/orchestra/api/AlsaAggregate.hpp>
+#include <audio/orchestra/api/AlsaEngine.hpp>
+#include <audio/orchestra/api/AlsaMonitor.hpp>
+#include <audio/orchestra/SeqLock.hpp>
 extern "C" {
 	#include <sched.h>
 	#include <getopt.h>
@@ -26,8 +30,20 @@ extern "C" {
 	#include <string.h>
 	#include <math.h>
 	#include <limits.h>
+	#include <unistd.h>
+	#include <sys/timerfd.h>
+	#include <sys/eventfd.h>
 }
 
+// Timer scheduling mode:
+static const uint32_t tschedBufferTimeMs = 500; //!< Size of the hardware buffer
+static const uint32_t tschedWatermarkMs = 20; //!< Initial safety margin before an xrun
+static const int64_t tschedWatermarkDecreaseSecond = 10; //!< Time without xrun before decreasing the margin
+static const uint32_t watchdogBufferCount = 4; //!< Number of hardware buffer duration without period before the device is declared stalled
+static const uint32_t watchdogMinimumMs = 200; //!< Minimum timeout of the watchdog
+static const uint32_t watchdogMaxRestart = 3; //!< Number of consecutive restart before the device is declared dead
+static const int32_t reconnectRetryMs = 5; //!< Delay between 2 tries to reopen a lost device
+
 ememory::SharedPtr<audio::orchestra::Api> audio::orchestra::api::Alsa::create() {
 	return ememory::SharedPtr<audio::orchestra::api::Alsa>(ETK_NEW(audio::orchestra::api::Alsa));
 }
@@ -35,28 +51,102 @@ ememory::SharedPtr<audio::orchestra::Api> audio::orchestra::api::Alsa::create()
 namespace audio {
 	namespace orchestra {
 		namespace api {
+			/**
+			 * @brief Time of the stream published by the IO thread.
+			 */
+			class AlsaTimestamp {
+				public:
+					int64_t sec;
+					int64_t nsec;
+					AlsaTimestamp() :
+					  sec(0),
+					  nsec(0) {
+						
+					}
+			};
 			class AlsaPrivate {
 				public:
-					snd_pcm_t *handle;
+					snd_pcm_t *handle[2]; //!< PCM handles: [0] playback, [1] capture (both in duplex mode)
+					bool linked; //!< The capture and playback handles are linked (started/stopped together)
+					bool prefill; //!< duplex: the playback buffer need to be filled with silence before the next cycle
 					bool xrun[2];
 					ethread::Semaphore m_semaphore;
 					bool runnable;
 					ethread::Thread* thread;
 					bool threadRunning;
-					bool mmapInterface; //!< enable or disable mmap mode...
+					bool mmapInterface[2]; //!< enable or disable mmap mode...
 					enum timestampMode timeMode; //!< the timestamp of the flow came from the harware.
 					etk::Vector<snd_pcm_channel_area_t> areas;
+					etk::Vector<ememory::SharedPtr<audio::orchestra::api::AlsaAggregate>> aggregate; //!< secondary devices (clock slaves)
+					bool aggregateXrun; //!< An aggregated device had an xrun
+					bool timerScheduling; //!< Wakeup on timer instead of period interrupts
+					bool catchUp; //!< Process all the availlable periods at each wakeup
+					snd_pcm_uframes_t hwBufferSize; //!< Size of the hardware buffer (frames)
+					snd_pcm_uframes_t watermark; //!< timer scheduling: frames kept in the hardware buffer before an xrun
+					snd_pcm_uframes_t watermarkMin; //!< timer scheduling: minimum value of the watermark
+					audio::Time watermarkTime; //!< timer scheduling: last change of the watermark
+					int32_t eventFd; //!< eventfd in the poll set of the IO thread to wake it up (start, stop, close)
+					int32_t watchdogTimeout; //!< Maximum time in the poll before the device is declared stalled (ms)
+					uint32_t watchdogCount; //!< Number of consecutive watchdog timeout
+					bool stalled; //!< The device does not produce periods anymore
+					audio::orchestra::SeqLock<audio::orchestra::api::AlsaTimestamp> clock; //!< Time of the stream at the last period
+					ememory::SharedPtr<audio::orchestra::api::AlsaEngine> engine; //!< Shared IO thread (null: the stream has its own thread)
+					bool engineStarted; //!< The shared engine has started the stream
+					audio::Time lastPeriod; //!< Time of the last period processed by the shared engine (watchdog)
+					ememory::SharedPtr<ethread::Thread> prepareThread; //!< Open the capture device while the playback device is negotiated (duplex)
+					snd_pcm_t* prepareHandle; //!< Capture handle open by prepareThread
+					etk::String prepareName; //!< Name of the device open by prepareThread
+					bool deviceInfoSaved; //!< The devices are already probed for the current open (prepareOpen)
+					ememory::SharedPtr<audio::orchestra::api::AlsaMonitor> monitor; //!< Hot-plug monitor (null if not requested)
+					etk::String deviceName[2]; //!< Name of the open devices (playback, capture)
+					snd_pcm_hw_params_t* hwParams[2]; //!< Hardware configuration of the open devices (reopen on the same configuration)
+					snd_pcm_sw_params_t* swParams[2]; //!< Software configuration of the open devices
+					bool deviceLost; //!< A device is unplugged: the IO thread must reopen it (StreamOptions::reconnect)
+					bool stopPending; //!< The callback request a stop: the shared engine must drain the stream out of the IO thread
 					AlsaPrivate() :
-					  handle(null),
+					  linked(false),
+					  prefill(false),
 					  runnable(false),
 					  thread(null),
 					  threadRunning(false),
-					  mmapInterface(false),
-					  timeMode(timestampMode_soft) {
+					  timeMode(timestampMode_soft),
+					  aggregateXrun(false),
+					  timerScheduling(false),
+					  catchUp(false),
+					  hwBufferSize(0),
+					  watermark(0),
+					  watermarkMin(0),
+					  eventFd(-1),
+					  watchdogTimeout(-1),
+					  watchdogCount(0),
+					  stalled(false),
+					  engineStarted(false),
+					  prepareHandle(null),
+					  deviceInfoSaved(false),
+					  deviceLost(false),
+					  stopPending(false) {
+						handle[0] = null;
+						handle[1] = null;
 						xrun[0] = false;
 						xrun[1] = false;
+						mmapInterface[0] = false;
+						mmapInterface[1] = false;
+						hwParams[0] = null;
+						hwParams[1] = null;
+						swParams[0] = null;
+						swParams[1] = null;
 						// TODO : Wait thread ...
 					}
+					~AlsaPrivate() {
+						for (int32_t iii=0; iii<2; ++iii) {
+							if (hwParams[iii] != null) {
+								snd_pcm_hw_params_free(hwParams[iii]);
+							}
+							if (swParams[iii] != null) {
+								snd_pcm_sw_params_free(swParams[iii]);
+							}
+						}
+					}
 			};
 		}
 	}
@@ -68,6 +158,8 @@ audio::orchestra::api::Alsa::Alsa() :
 }
 
 audio::orchestra::api::Alsa::~Alsa() {
+	stopDeviceMonitor();
+	releasePrepareOpen();
 	if (m_state != audio::orchestra::state::closed) {
 		closeStream();
 	}
@@ -112,6 +204,35 @@ nextcard:
 	return nDevices;
 }
 
+/**
+ * @brief Convert an ALSA channel position (SND_CHMAP_*) in audio::channel.
+ */
+static enum audio::channel convertChannelPosition(unsigned int _position) {
+	switch (_position) {
+		case SND_CHMAP_MONO:
+		case SND_CHMAP_FC:
+			return audio::channel_frontCenter;
+		case SND_CHMAP_FL:
+			return audio::channel_frontLeft;
+		case SND_CHMAP_FR:
+			return audio::channel_frontRight;
+		case SND_CHMAP_RL:
+			return audio::channel_rearLeft;
+		case SND_CHMAP_RR:
+			return audio::channel_rearRight;
+		case SND_CHMAP_RC:
+			return audio::channel_rearCenter;
+		case SND_CHMAP_SL:
+			return audio::channel_surroundLeft;
+		case SND_CHMAP_SR:
+			return audio::channel_surroundRight;
+		case SND_CHMAP_LFE:
+			return audio::channel_lfe;
+		default:
+			return audio::channel_unknow;
+	}
+}
+
 bool audio::orchestra::api::Alsa::getNamedDeviceInfoLocal(const etk::String& _deviceName, audio::orchestra::DeviceInfo& _info, int32_t _cardId, int32_t _subdevice, int32_t _localDeviceId, bool _input) {
 	int32_t result;
 	snd_ctl_t *chandle;
@@ -192,6 +313,23 @@ bool audio::orchestra::api::Alsa::getNamedDeviceInfoLocal(const etk::String& _de
 	for (int32_t iii=0; iii<value; ++iii) {
 		_info.channels.pushBack(audio::channel_unknow);
 	}
+	// Position of the channels: use the map of the highest number of channels.
+	snd_pcm_chmap_query_t** chmaps = snd_pcm_query_chmaps(phandle);
+	if (chmaps != null) {
+		const snd_pcm_chmap_t* chmap = null;
+		for (int32_t iii=0; chmaps[iii] != null; ++iii) {
+			if (    chmap == null
+			     || chmaps[iii]->map.channels > chmap->channels) {
+				chmap = &chmaps[iii]->map;
+			}
+		}
+		if (chmap != null) {
+			for (uint32_t iii=0; iii<chmap->channels && iii<_info.channels.size(); ++iii) {
+				_info.channels[iii] = convertChannelPosition(chmap->pos[iii]);
+			}
+		}
+		snd_pcm_free_chmaps(chmaps);
+	}
 	// Test our discrete set of sample rate values.
 	_info.sampleRates.clear();
 	for (auto &it: audio::orchestra::genericSampleRate()) {
@@ -349,26 +487,23 @@ void audio::orchestra::api::Alsa::saveDeviceInfo() {
 	}
 }
 
-bool audio::orchestra::api::Alsa::open(uint32_t _device,
-                                       audio::orchestra::mode _mode,
-                                       uint32_t _channels,
-                                       uint32_t _firstChannel,
-                                       uint32_t _sampleRate,
-                                       audio::format _format,
-                                       uint32_t *_bufferSize,
-                                       const audio::orchestra::StreamOptions& _options) {
+/**
+ * @brief Get the name of the hardware device used by a stream open with a device ID.
+ * @param[in] _device ID of the device.
+ * @param[out] _name Name of the device ("hw:card,device").
+ * @return false if the device does not exist.
+ */
+static bool getStreamDeviceName(uint32_t _device, char* _name) {
 	// I'm not using the "plug" interface ... too much inconsistent behavior.
 	unsigned nDevices = 0;
 	int32_t result, subdevice, card;
-	char name[64];
 	snd_ctl_t *chandle;
 	// Count cards and devices
 	card = -1;
-	// NOTE : Find the device name : [BEGIN]
 	snd_card_next(&card);
 	while (card >= 0) {
-		sprintf(name, "hw:%d", card);
-		result = snd_ctl_open(&chandle, name, SND_CTL_NONBLOCK);
+		sprintf(_name, "hw:%d", card);
+		result = snd_ctl_open(&chandle, _name, SND_CTL_NONBLOCK);
 		if (result < 0) {
 			ATA_ERROR("control open, card = " << card << ", " << snd_strerror(result) << ".");
 			return false;
@@ -379,9 +514,9 @@ bool audio::orchestra::api::Alsa::open(uint32_t _device,
 			if (result < 0) break;
 			if (subdevice < 0) break;
 			if (nDevices == _device) {
-				sprintf(name, "hw:%d,%d", card, subdevice);
+				sprintf(_name, "hw:%d,%d", card, subdevice);
 				snd_ctl_close(chandle);
-				goto foundDevice;
+				return true;
 			}
 			nDevices++;
 		}
@@ -393,17 +528,69 @@ bool audio::orchestra::api::Alsa::open(uint32_t _device,
 		ATA_ERROR("no devices found!");
 		return false;
 	}
-	if (_device >= nDevices) {
-		// This should not happen because a check is made before this function is called.
-		ATA_ERROR("device ID is invalid!");
+	// This should not happen because a check is made before this function is called.
+	ATA_ERROR("device ID is invalid!");
+	return false;
+}
+
+bool audio::orchestra::api::Alsa::open(uint32_t _device,
+                                       audio::orchestra::mode _mode,
+                                       uint32_t _channels,
+                                       uint32_t _firstChannel,
+                                       uint32_t _sampleRate,
+                                       audio::format _format,
+                                       uint32_t *_bufferSize,
+                                       const audio::orchestra::StreamOptions& _options) {
+	char name[64];
+	if (getStreamDeviceName(_device, name) == false) {
 		return false;
 	}
-	// NOTE : Find the device name : [ END ]
-
-foundDevice:
 	return openName(name, _mode, _channels, _firstChannel, _sampleRate, _format, _bufferSize, _options);
 }
 
+void audio::orchestra::api::Alsa::prepareOpen(enum audio::orchestra::mode _mode, const audio::orchestra::StreamParameters& _params) {
+	releasePrepareOpen();
+	if (_params.deviceId == -1) {
+		m_private->prepareName = _params.deviceName;
+	} else {
+		char name[64];
+		if (getStreamDeviceName(_params.deviceId, name) == false) {
+			return;
+		}
+		m_private->prepareName = name;
+	}
+	// Probe the devices before the devices of the stream are open (the 2 sides use this information).
+	saveDeviceInfo();
+	m_private->deviceInfoSaved = true;
+	snd_pcm_stream_t stream = SND_PCM_STREAM_CAPTURE;
+	if (_mode == audio::orchestra::mode_output) {
+		stream = SND_PCM_STREAM_PLAYBACK;
+	}
+	m_private->prepareThread = ememory::makeShared<ethread::Thread>([=](){
+		snd_pcm_t* handle = null;
+		int32_t result = snd_pcm_open(&handle, m_private->prepareName.c_str(), stream, SND_PCM_ASYNC);
+		if (result < 0) {
+			// The error is reported by the open of the stream.
+			ATA_DEBUG("prepare: can not open the pcm device (" << m_private->prepareName << "): " << snd_strerror(result));
+			handle = null;
+		}
+		m_private->prepareHandle = handle;
+	}, "Alsa prepare");
+}
+
+void audio::orchestra::api::Alsa::releasePrepareOpen() {
+	if (m_private->prepareThread != null) {
+		m_private->prepareThread->join();
+		m_private->prepareThread.reset();
+	}
+	if (m_private->prepareHandle != null) {
+		snd_pcm_close(m_private->prepareHandle);
+		m_private->prepareHandle = null;
+	}
+	m_private->prepareName.clear();
+	m_private->deviceInfoSaved = false;
+}
+
 bool audio::orchestra::api::Alsa::openName(const etk::String& _deviceName,
                                            audio::orchestra::mode _mode,
                                            uint32_t _channels,
@@ -412,6 +599,66 @@ bool audio::orchestra::api::Alsa::openName(const etk::String& _deviceName,
                                            audio::format _format,
                                            uint32_t *_bufferSize,
                                            const audio::orchestra::StreamOptions& _options) {
+	int32_t idTable = modeToIdTable(_mode);
+	if (m_aggregateDeviceName[idTable].size() == 0) {
+		return openDevice(_deviceName, _mode, _channels, _firstChannel, _sampleRate, _format, _bufferSize, _options);
+	}
+	if (m_mode != audio::orchestra::mode_unknow) {
+		ATA_ERROR("Aggregated devices can not be used in a duplex stream");
+		return false;
+	}
+	// Open the secondary devices first to know the number of channels of the main device.
+	uint32_t nbChannelsAggregate = 0;
+	for (size_t iii=0; iii<m_aggregateDeviceName[idTable].size(); ++iii) {
+		ememory::SharedPtr<audio::orchestra::api::AlsaAggregate> device = ememory::makeShared<audio::orchestra::api::AlsaAggregate>();
+		if (    device == null
+		     || device->open(m_aggregateDeviceName[idTable][iii], _mode, _sampleRate, *_bufferSize) == false) {
+			m_private->aggregate.clear();
+			return false;
+		}
+		nbChannelsAggregate += device->getNbChannels();
+		m_private->aggregate.pushBack(device);
+	}
+	if (_channels <= nbChannelsAggregate) {
+		ATA_ERROR("requested " << _channels << " channels, the aggregated devices already provide " << nbChannelsAggregate << " channels");
+		m_private->aggregate.clear();
+		return false;
+	}
+	if (openDevice(_deviceName, _mode, _channels - nbChannelsAggregate, _firstChannel, _sampleRate, _format, _bufferSize, _options) == false) {
+		m_private->aggregate.clear();
+		return false;
+	}
+	// The user buffer contain the channels of all the devices, the main device use the first ones.
+	m_nUserChannels[idTable] = _channels;
+	m_userBuffer[idTable].resize(_channels * m_bufferSize * audio::getFormatBytes(m_userFormat), 0);
+	if (m_doConvertBuffer[idTable] == false) {
+		m_doConvertBuffer[idTable] = true;
+		m_deviceBuffer.clear();
+		m_deviceBuffer.resize(m_nDeviceChannels[idTable] * m_bufferSize * audio::getFormatBytes(m_deviceFormat[idTable]), 0);
+	}
+	m_convertInfo[idTable].inOffset.clear();
+	m_convertInfo[idTable].outOffset.clear();
+	setConvertInfo(_mode, _firstChannel);
+	uint32_t firstChannel = _channels - nbChannelsAggregate;
+	for (size_t iii=0; iii<m_private->aggregate.size(); ++iii) {
+		if (    m_deviceBuffer.size() == 0
+		     || m_private->aggregate[iii]->setUserChannels(m_userFormat, _channels, firstChannel, m_bufferSize) == false) {
+			closeStream();
+			return false;
+		}
+		firstChannel += m_private->aggregate[iii]->getNbChannels();
+	}
+	return true;
+}
+
+bool audio::orchestra::api::Alsa::openDevice(const etk::String& _deviceName,
+                                             audio::orchestra::mode _mode,
+                                             uint32_t _channels,
+                                             uint32_t _firstChannel,
+                                             uint32_t _sampleRate,
+                                             audio::format _format,
+                                             uint32_t *_bufferSize,
+                                             const audio::orchestra::StreamOptions& _options) {
 	ATA_DEBUG("Probe ALSA device : ");
 	ATA_DEBUG("    _deviceName=" << _deviceName);
 	ATA_DEBUG("    _mode=" << _mode);
@@ -430,9 +677,7 @@ bool audio::orchestra::api::Alsa::openName(const etk::String& _deviceName,
 	// The getDeviceInfo() function will not work for a device that is
 	// already open.	Thus, we'll probe the system before opening a
 	// stream and save the results for use by getDeviceInfo().
-	// TODO : ...
-	{
-		// only do once
+	if (m_private->deviceInfoSaved == false) {
 		this->saveDeviceInfo();
 	}
 	snd_pcm_stream_t stream;
@@ -441,10 +686,32 @@ bool audio::orchestra::api::Alsa::openName(const etk::String& _deviceName,
 	} else {
 		stream = SND_PCM_STREAM_CAPTURE;
 	}
+	if (    _mode == audio::orchestra::mode_input
+	     && m_mode == audio::orchestra::mode_output) {
+		ATA_DEBUG("open the capture side of a full duplex stream");
+	} else if (m_mode != audio::orchestra::mode_unknow) {
+		ATA_ERROR("the stream is already open in mode: " << m_mode);
+		return false;
+	}
+	snd_pcm_t *handle = null;
 	//int32_t openMode = SND_PCM_NONBLOCK;
 	int32_t openMode = SND_PCM_ASYNC;
 	//int32_t openMode = SND_PCM_ASYNC | SND_PCM_NONBLOCK;
-	result = snd_pcm_open(&m_private->handle, _deviceName.c_str(), stream, openMode);
+	if (    _mode == audio::orchestra::mode_input
+	     && m_private->prepareThread != null) {
+		m_private->prepareThread->join();
+		m_private->prepareThread.reset();
+	}
+	if (    _mode == audio::orchestra::mode_input
+	     && m_private->prepareHandle != null
+	     && m_private->prepareName == _deviceName) {
+		ATA_DEBUG("use the capture device open in parallel of the playback device");
+		handle = m_private->prepareHandle;
+		m_private->prepareHandle = null;
+		result = 0;
+	} else {
+		result = snd_pcm_open(&handle, _deviceName.c_str(), stream, openMode);
+	}
 	ATA_DEBUG("Configure Mode : SND_PCM_ASYNC");
 	if (result < 0) {
 		if (_mode == audio::orchestra::mode_output) {
@@ -457,36 +724,36 @@ bool audio::orchestra::api::Alsa::openName(const etk::String& _deviceName,
 	// Fill the parameter structure.
 	snd_pcm_hw_params_t *hw_params;
 	snd_pcm_hw_params_alloca(&hw_params);
-	result = snd_pcm_hw_params_any(m_private->handle, hw_params);
+	result = snd_pcm_hw_params_any(handle, hw_params);
 	if (result < 0) {
-		snd_pcm_close(m_private->handle);
+		snd_pcm_close(handle);
 		ATA_ERROR("error getting pcm device (" << _deviceName << ") parameters, " << snd_strerror(result) << ".");
 		return false;
 	}
 	#if 1
 		ATA_DEBUG("configure Acces: SND_PCM_ACCESS_MMAP_INTERLEAVED");
-		result = snd_pcm_hw_params_set_access(m_private->handle, hw_params, SND_PCM_ACCESS_MMAP_INTERLEAVED);
+		result = snd_pcm_hw_params_set_access(handle, hw_params, SND_PCM_ACCESS_MMAP_INTERLEAVED);
 		if (result >= 0) {
 			m_deviceInterleaved[modeToIdTable(_mode)] =	true;
-			m_private->mmapInterface = true;
+			m_private->mmapInterface[modeToIdTable(_mode)] = true;
 		} else {
 			ATA_DEBUG("configure Acces: SND_PCM_ACCESS_MMAP_NONINTERLEAVED");
-			result = snd_pcm_hw_params_set_access(m_private->handle, hw_params, SND_PCM_ACCESS_MMAP_NONINTERLEAVED);
+			result = snd_pcm_hw_params_set_access(handle, hw_params, SND_PCM_ACCESS_MMAP_NONINTERLEAVED);
 			if (result >= 0) {
 				m_deviceInterleaved[modeToIdTable(_mode)] =	false;
-				m_private->mmapInterface = true;
+				m_private->mmapInterface[modeToIdTable(_mode)] = true;
 			} else {
 				ATA_DEBUG("configure Acces: SND_PCM_ACCESS_RW_INTERLEAVED");
-				result = snd_pcm_hw_params_set_access(m_private->handle, hw_params, SND_PCM_ACCESS_RW_INTERLEAVED);
+				result = snd_pcm_hw_params_set_access(handle, hw_params, SND_PCM_ACCESS_RW_INTERLEAVED);
 				if (result >= 0) {
 					m_deviceInterleaved[modeToIdTable(_mode)] =	true;
-					m_private->mmapInterface = false;
+					m_private->mmapInterface[modeToIdTable(_mode)] = false;
 				} else {
 					ATA_DEBUG("configure Acces: SND_PCM_ACCESS_RW_NONINTERLEAVED");
-					result = snd_pcm_hw_params_set_access(m_private->handle, hw_params, SND_PCM_ACCESS_RW_NONINTERLEAVED);
+					result = snd_pcm_hw_params_set_access(handle, hw_params, SND_PCM_ACCESS_RW_NONINTERLEAVED);
 					if (result >= 0) {
 						m_deviceInterleaved[modeToIdTable(_mode)] =	false;
-						m_private->mmapInterface = false;
+						m_private->mmapInterface[modeToIdTable(_mode)] = false;
 					} else {
 						ATA_ERROR("Can not open the interface ...");
 						return false;
@@ -496,16 +763,16 @@ bool audio::orchestra::api::Alsa::openName(const etk::String& _deviceName,
 		}
 	#else
 		ATA_DEBUG("configure Acces: SND_PCM_ACCESS_RW_INTERLEAVED");
-		result = snd_pcm_hw_params_set_access(m_private->handle, hw_params, SND_PCM_ACCESS_RW_INTERLEAVED);
+		result = snd_pcm_hw_params_set_access(handle, hw_params, SND_PCM_ACCESS_RW_INTERLEAVED);
 		if (result >= 0) {
 			m_deviceInterleaved[modeToIdTable(_mode)] =	true;
-			m_private->mmapInterface = false;
+			m_private->mmapInterface[modeToIdTable(_mode)] = false;
 		} else {
 			ATA_DEBUG("configure Acces: SND_PCM_ACCESS_RW_NONINTERLEAVED");
-			result = snd_pcm_hw_params_set_access(m_private->handle, hw_params, SND_PCM_ACCESS_RW_NONINTERLEAVED);
+			result = snd_pcm_hw_params_set_access(handle, hw_params, SND_PCM_ACCESS_RW_NONINTERLEAVED);
 			if (result >= 0) {
 				m_deviceInterleaved[modeToIdTable(_mode)] =	false;
-				m_private->mmapInterface = false;
+				m_private->mmapInterface[modeToIdTable(_mode)] = false;
 			} else {
 				ATA_ERROR("Can not open the interface ...");
 				return false;
@@ -513,7 +780,7 @@ bool audio::orchestra::api::Alsa::openName(const etk::String& _deviceName,
 		}
 	#endif
 	if (result < 0) {
-		snd_pcm_close(m_private->handle);
+		snd_pcm_close(handle);
 		ATA_ERROR("error setting pcm device (" << _deviceName << ") access, " << snd_strerror(result) << ".");
 		return false;
 	}
@@ -533,19 +800,19 @@ bool audio::orchestra::api::Alsa::openName(const etk::String& _deviceName,
 	} else if (_format == audio::format_double) {
 		deviceFormat = SND_PCM_FORMAT_FLOAT64;
 	}
-	if (snd_pcm_hw_params_test_format(m_private->handle, hw_params, deviceFormat) == 0) {
+	if (snd_pcm_hw_params_test_format(handle, hw_params, deviceFormat) == 0) {
 		m_deviceFormat[modeToIdTable(_mode)] = _format;
 	} else {
 		// If we get here, no supported format was found.
-		snd_pcm_close(m_private->handle);
+		snd_pcm_close(handle);
 		ATA_ERROR("pcm device " << _deviceName << " data format not supported: " << _format);
 		// TODO : display list of all supported format ..
 		return false;
 	}
 	ATA_DEBUG("configure format: " << _format);
-	result = snd_pcm_hw_params_set_format(m_private->handle, hw_params, deviceFormat);
+	result = snd_pcm_hw_params_set_format(handle, hw_params, deviceFormat);
 	if (result < 0) {
-		snd_pcm_close(m_private->handle);
+		snd_pcm_close(handle);
 		ATA_ERROR("error setting pcm device (" << _deviceName << ") data format, " << snd_strerror(result) << ".");
 		return false;
 	}
@@ -557,16 +824,16 @@ bool audio::orchestra::api::Alsa::openName(const etk::String& _deviceName,
 			ATA_DEBUG("configure swap Byte");
 			m_doByteSwap[modeToIdTable(_mode)] = true;
 		} else if (result < 0) {
-			snd_pcm_close(m_private->handle);
+			snd_pcm_close(handle);
 			ATA_ERROR("error getting pcm device (" << _deviceName << ") endian-ness, " << snd_strerror(result) << ".");
 			return false;
 		}
 	}
 	ATA_DEBUG("Set frequency " << _sampleRate);
 	// Set the sample rate.
-	result = snd_pcm_hw_params_set_rate_near(m_private->handle, hw_params, (uint32_t*) &_sampleRate, 0);
+	result = snd_pcm_hw_params_set_rate_near(handle, hw_params, (uint32_t*) &_sampleRate, 0);
 	if (result < 0) {
-		snd_pcm_close(m_private->handle);
+		snd_pcm_close(handle);
 		ATA_ERROR("error setting sample rate on device (" << _deviceName << "), " << snd_strerror(result) << ".");
 		return false;
 	}
@@ -577,18 +844,18 @@ bool audio::orchestra::api::Alsa::openName(const etk::String& _deviceName,
 	result = snd_pcm_hw_params_get_channels_max(hw_params, &value);
 	uint32_t deviceChannels = value;
 	if (result < 0) {
-		snd_pcm_close(m_private->handle);
+		snd_pcm_close(handle);
 		ATA_ERROR("requested channel parameters not supported by device (" << _deviceName << "), " << snd_strerror(result) << ".");
 		return false;
 	}
 	if (deviceChannels < _channels + _firstChannel) {
-		snd_pcm_close(m_private->handle);
+		snd_pcm_close(handle);
 		ATA_ERROR("requested channel " << _channels << " have : " << deviceChannels );
 		return false;
 	}
 	result = snd_pcm_hw_params_get_channels_min(hw_params, &value);
 	if (result < 0) {
-		snd_pcm_close(m_private->handle);
+		snd_pcm_close(handle);
 		ATA_ERROR("error getting minimum channels for device (" << _deviceName << "), " << snd_strerror(result) << ".");
 		return false;
 	}
@@ -600,9 +867,9 @@ bool audio::orchestra::api::Alsa::openName(const etk::String& _deviceName,
 	ATA_DEBUG("snd_pcm_hw_params_set_channels: " << deviceChannels);
 	m_nDeviceChannels[modeToIdTable(_mode)] = deviceChannels;
 	// Set the device channels.
-	result = snd_pcm_hw_params_set_channels(m_private->handle, hw_params, deviceChannels);
+	result = snd_pcm_hw_params_set_channels(handle, hw_params, deviceChannels);
 	if (result < 0) {
-		snd_pcm_close(m_private->handle);
+		snd_pcm_close(handle);
 		ATA_ERROR("error setting channels for device (" << _deviceName << "), " << snd_strerror(result) << ".");
 		return false;
 	}
@@ -610,9 +877,9 @@ bool audio::orchestra::api::Alsa::openName(const etk::String& _deviceName,
 	// Set the buffer (or period) size.
 	int32_t dir = 0;
 	snd_pcm_uframes_t periodSize = *_bufferSize;
-	result = snd_pcm_hw_params_set_period_size_near(m_private->handle, hw_params, &periodSize, &dir);
+	result = snd_pcm_hw_params_set_period_size_near(handle, hw_params, &periodSize, &dir);
 	if (result < 0) {
-		snd_pcm_close(m_private->handle);
+		snd_pcm_close(handle);
 		ATA_ERROR("error setting period size for device (" << _deviceName << "), " << snd_strerror(result) << ".");
 		return false;
 	}
@@ -624,19 +891,67 @@ bool audio::orchestra::api::Alsa::openName(const etk::String& _deviceName,
 	if (_options.flags.m_minimizeLatency == true) {
 		periods = 2;
 	}
-	/* TODO : Chouse the number of low level buffer ...
+	uint32_t targetLatency = _options.getTargetLatency();
+	if (targetLatency != 0) {
+		// The period is the callback size ==> the latency select the number of periods.
+		uint64_t targetFrames = uint64_t(targetLatency) * uint64_t(_sampleRate) / 1000000LL;
+		periods = (targetFrames + periodSize/2) / periodSize;
+		if (periods < 2) {
+			periods = 2;
+		}
+		ATA_DEBUG("configure target latency: " << targetLatency << "us ==> " << periods << " periods");
+	}
 	if (_options.numberOfBuffers > 0) {
 		periods = _options.numberOfBuffers;
 	}
-	*/
 	if (periods < 2) {
 		periods = 4; // a fairly safe default value
 	}
-	result = snd_pcm_hw_params_set_periods_near(m_private->handle, hw_params, &periods, &dir);
-	if (result < 0) {
-		snd_pcm_close(m_private->handle);
-		ATA_ERROR("error setting periods for device (" << _deviceName << "), " << snd_strerror(result) << ".");
-		return false;
+	m_private->timerScheduling = false;
+	m_private->catchUp = _options.flags.m_catchUp;
+	bool timerScheduling = _options.flags.m_timerScheduling;
+	if (_options.latency == audio::orchestra::latencyClass_powerSaving) {
+		timerScheduling = true;
+	}
+	// Decided before the open of the playback side: the 2 devices of a duplex stream use the period interrupts.
+	if (    timerScheduling == true
+	     && m_duplexOpen == true) {
+		if (_mode == audio::orchestra::mode_output) {
+			ATA_WARNING("Timer scheduling is not availlable in duplex mode (the capture drive the stream)");
+		}
+	} else if (timerScheduling == true) {
+		// Large buffer, the period is only the callback size.
+		m_private->timerScheduling = true;
+		if (snd_pcm_hw_params_can_disable_period_wakeup(hw_params) == 1) {
+			result = snd_pcm_hw_params_set_period_wakeup(handle, hw_params, 0);
+			if (result < 0) {
+				ATA_WARNING("Can not disable the period interrupts: " << snd_strerror(result));
+			} else {
+				ATA_DEBUG("configure period wakeup: disable");
+			}
+		} else {
+			ATA_INFO("The device (" << _deviceName << ") can not disable the period interrupts");
+		}
+		snd_pcm_uframes_t bufferFrames = snd_pcm_uframes_t(_sampleRate) * tschedBufferTimeMs / 1000;
+		if (targetLatency != 0) {
+			bufferFrames = uint64_t(targetLatency) * uint64_t(_sampleRate) / 1000000LL;
+		}
+		result = snd_pcm_hw_params_set_buffer_size_near(handle, hw_params, &bufferFrames);
+		if (result < 0) {
+			snd_pcm_close(handle);
+			ATA_ERROR("error setting buffer size for device (" << _deviceName << "), " << snd_strerror(result) << ".");
+			return false;
+		}
+		periods = bufferFrames / periodSize;
+		ATA_DEBUG("configure timer scheduling buffer: " << bufferFrames << " frames");
+	}
+	if (m_private->timerScheduling == false) {
+		result = snd_pcm_hw_params_set_periods_near(handle, hw_params, &periods, &dir);
+		if (result < 0) {
+			snd_pcm_close(handle);
+			ATA_ERROR("error setting periods for device (" << _deviceName << "), " << snd_strerror(result) << ".");
+			return false;
+		}
 	}
 	ATA_DEBUG("configure Buffer number: " << periods);
 	m_sampleRate = _sampleRate;
@@ -645,7 +960,7 @@ bool audio::orchestra::api::Alsa::openName(const etk::String& _deviceName,
 	if (    m_mode == audio::orchestra::mode_output
 	     && _mode == audio::orchestra::mode_input
 	     && *_bufferSize != m_bufferSize) {
-		snd_pcm_close(m_private->handle);
+		snd_pcm_close(handle);
 		ATA_ERROR("system error setting buffer size for duplex stream on device (" << _deviceName << ").");
 		return false;
 	}
@@ -666,50 +981,79 @@ bool audio::orchestra::api::Alsa::openName(const etk::String& _deviceName,
 	}
 
 	// Install the hardware configuration
-	result = snd_pcm_hw_params(m_private->handle, hw_params);
+	result = snd_pcm_hw_params(handle, hw_params);
 	if (result < 0) {
-		snd_pcm_close(m_private->handle);
+		snd_pcm_close(handle);
 		ATA_ERROR("error installing hardware configuration on device (" << _deviceName << "), " << snd_strerror(result) << ".");
 		return false;
 	}
+	m_private->clock.reset();
 	snd_pcm_uframes_t val;
 	// Set the software configuration to fill buffers with zeros and prevent device stopping on xruns.
 	snd_pcm_sw_params_t *swParams = null;
 	snd_pcm_sw_params_alloca(&swParams);
-	snd_pcm_sw_params_current(m_private->handle, swParams);
+	snd_pcm_sw_params_current(handle, swParams);
 	#if 0
 		ATA_DEBUG("configure start_threshold: " << int64_t(*_bufferSize));
-		snd_pcm_sw_params_set_start_threshold(m_private->handle, swParams, *_bufferSize);
+		snd_pcm_sw_params_set_start_threshold(handle, swParams, *_bufferSize);
 	#else
 		//ATA_DEBUG("configure start_threshold: " << int64_t(1));
-		//snd_pcm_sw_params_set_start_threshold(m_private->handle, swParams, 1);
-		ATA_DEBUG("configure start_threshold: " << int64_t(0));
-		snd_pcm_sw_params_set_start_threshold(m_private->handle, swParams, 0);
+		//snd_pcm_sw_params_set_start_threshold(handle, swParams, 1);
+		if (    _options.latency == audio::orchestra::latencyClass_ultraLow
+		     || _options.latency == audio::orchestra::latencyClass_low) {
+			// start as soon as the first period is availlable.
+			ATA_DEBUG("configure start_threshold: " << int64_t(*_bufferSize));
+			snd_pcm_sw_params_set_start_threshold(handle, swParams, *_bufferSize);
+		} else if (_options.latency == audio::orchestra::latencyClass_powerSaving) {
+			// start when the buffer is full.
+			ATA_DEBUG("configure start_threshold: " << int64_t(*_bufferSize*periods));
+			snd_pcm_sw_params_set_start_threshold(handle, swParams, *_bufferSize*periods);
+		} else {
+			ATA_DEBUG("configure start_threshold: " << int64_t(0));
+			snd_pcm_sw_params_set_start_threshold(handle, swParams, 0);
+		}
 	#endif
 	#if 1
 		ATA_DEBUG("configure stop_threshold: " << ULONG_MAX);
-		snd_pcm_sw_params_set_stop_threshold(m_private->handle, swParams, ULONG_MAX);
+		snd_pcm_sw_params_set_stop_threshold(handle, swParams, ULONG_MAX);
 	#else
 		ATA_DEBUG("configure stop_threshold: " << m_bufferSize*periods);
-		snd_pcm_sw_params_set_stop_threshold(m_private->handle, swParams, m_bufferSize*periods);
+		snd_pcm_sw_params_set_stop_threshold(handle, swParams, m_bufferSize*periods);
 	#endif
 	//ATA_DEBUG("configure silence_threshold: " << 0);
-	//snd_pcm_sw_params_set_silence_threshold(m_private->handle, swParams, 0);
+	//snd_pcm_sw_params_set_silence_threshold(handle, swParams, 0);
 	// The following two settings were suggested by Theo Veenker
 	#if 1
-		snd_pcm_sw_params_set_avail_min(m_private->handle, swParams, *_bufferSize*periods/2);
+	if (    m_private->timerScheduling == true
+	     || _options.latency == audio::orchestra::latencyClass_ultraLow
+	     || _options.latency == audio::orchestra::latencyClass_low) {
+		// wakeup on each period (the timer scheduling wakeup came from the timer, the blocking IO must not wait more than one chunk).
+		snd_pcm_sw_params_set_avail_min(handle, swParams, *_bufferSize);
+		snd_pcm_sw_params_get_avail_min(swParams, &val);
+		ATA_DEBUG("configure set availlable min: " << *_bufferSize << " really set: " << val);
+	} else {
+		snd_pcm_sw_params_set_avail_min(handle, swParams, *_bufferSize*periods/2);
 		snd_pcm_sw_params_get_avail_min(swParams, &val);
 		ATA_DEBUG("configure set availlable min: " << *_bufferSize*periods/2 << " really set: " << val);
+	}
 	#endif
 	#if 0
 		int valInt;
 		snd_pcm_sw_params_get_period_event(swParams, &valInt);
 		ATA_DEBUG("configure get period_event: " << valInt);
-		snd_pcm_sw_params_set_xfer_align(m_private->handle, swParams, 1);
+		snd_pcm_sw_params_set_xfer_align(handle, swParams, 1);
 	// here are two options for a fix
-	//snd_pcm_sw_params_set_silence_size(m_private->handle, swParams, ULONG_MAX);
+	//snd_pcm_sw_params_set_silence_size(handle, swParams, ULONG_MAX);
 	#endif
-	//snd_pcm_sw_params_set_tstamp_mode(m_private->handle, swParams, SND_PCM_TSTAMP_ENABLE);
+	if (m_private->timeMode == timestampMode_Hardware) {
+		snd_pcm_sw_params_set_tstamp_mode(handle, swParams, SND_PCM_TSTAMP_ENABLE);
+		// The raw clock is not slewed by NTP: the timestamps follow the audio clock.
+		if (snd_pcm_sw_params_set_tstamp_type(handle, swParams, SND_PCM_TSTAMP_TYPE_MONOTONIC_RAW) < 0) {
+			if (snd_pcm_sw_params_set_tstamp_type(handle, swParams, SND_PCM_TSTAMP_TYPE_MONOTONIC) < 0) {
+				ATA_WARNING("Can not select a monotonic timestamp ==> use gettimeofday");
+			}
+		}
+	}
 	ATA_DEBUG("configuration: ");
 
 	//ATA_DEBUG("    start_mode: " << snd_pcm_start_mode_name(snd_pcm_sw_params_get_start_mode(swParams)));
@@ -733,12 +1077,29 @@ bool audio::orchestra::api::Alsa::openName(const etk::String& _deviceName,
 	ATA_DEBUG("    silence_size: " << val);
 	snd_pcm_sw_params_get_boundary(swParams, &val);
 	ATA_DEBUG("    boundary: " << val);
-	result = snd_pcm_sw_params(m_private->handle, swParams);
+	result = snd_pcm_sw_params(handle, swParams);
 	if (result < 0) {
-		snd_pcm_close(m_private->handle);
+		snd_pcm_close(handle);
 		ATA_ERROR("error installing software configuration on device (" << _deviceName << "), " << snd_strerror(result) << ".");
 		return false;
 	}
+	// Keep the configuration to reopen the stream when the device is lost.
+	{
+		int32_t idTable = modeToIdTable(_mode);
+		m_private->deviceName[idTable] = _deviceName;
+		if (m_private->hwParams[idTable] == null) {
+			snd_pcm_hw_params_malloc(&m_private->hwParams[idTable]);
+		}
+		if (m_private->swParams[idTable] == null) {
+			snd_pcm_sw_params_malloc(&m_private->swParams[idTable]);
+		}
+		if (m_private->hwParams[idTable] != null) {
+			snd_pcm_hw_params_copy(m_private->hwParams[idTable], hw_params);
+		}
+		if (m_private->swParams[idTable] != null) {
+			snd_pcm_sw_params_copy(m_private->swParams[idTable], swParams);
+		}
+	}
 	
 	{
 		snd_pcm_uframes_t _period_size = 0;
@@ -777,27 +1138,94 @@ bool audio::orchestra::api::Alsa::openName(const etk::String& _deviceName,
 	}
 	// Generate conbverters:
 	if (m_doConvertBuffer[modeToIdTable(_mode)]) {
+		bool makeBuffer = true;
 		bufferBytes = m_nDeviceChannels[modeToIdTable(_mode)] * audio::getFormatBytes(m_deviceFormat[modeToIdTable(_mode)]);
 		bufferBytes *= *_bufferSize;
-		if (m_deviceBuffer) {
-			free(m_deviceBuffer);
-			m_deviceBuffer = null;
+		// The device buffer is shared between the playback and the capture in duplex mode.
+		if (    _mode == audio::orchestra::mode_input
+		     && m_mode == audio::orchestra::mode_output
+		     && m_deviceBuffer.size() != 0) {
+			uint64_t bytesOut = m_nDeviceChannels[0] * audio::getFormatBytes(m_deviceFormat[0]);
+			bytesOut *= *_bufferSize;
+			if (bufferBytes <= bytesOut) {
+				makeBuffer = false;
+			}
 		}
-		m_deviceBuffer = (char *) calloc(bufferBytes, 1);
-		if (m_deviceBuffer == null) {
-			ATA_ERROR("error allocating device buffer memory.");
-			goto error;
+		if (makeBuffer == true) {
+			m_deviceBuffer.clear();
+			m_deviceBuffer.resize(bufferBytes, 0);
+			if (m_deviceBuffer.size() == 0) {
+				ATA_ERROR("error allocating device buffer memory.");
+				goto error;
+			}
 		}
 	}
 	m_nBuffers = periods;
 	ATA_INFO("ALSA NB buffer = " << m_nBuffers);
+	{
+		snd_pcm_uframes_t hwBufferSize = 0;
+		snd_pcm_hw_params_get_buffer_size(hw_params, &hwBufferSize);
+		m_private->hwBufferSize = hwBufferSize;
+		m_bufferLatency = uint64_t(hwBufferSize) * 1000000LL / uint64_t(m_sampleRate);
+		ATA_INFO("ALSA buffer latency = " << m_bufferLatency << "us (target=" << targetLatency << "us)");
+		if (m_private->timerScheduling == true) {
+			m_private->watermarkMin = snd_pcm_uframes_t(_sampleRate) * tschedWatermarkMs / 1000;
+			if (m_private->watermarkMin < snd_pcm_uframes_t(*_bufferSize) * 2) {
+				m_private->watermarkMin = snd_pcm_uframes_t(*_bufferSize) * 2;
+			}
+			m_private->watermark = m_private->watermarkMin;
+			ATA_INFO("ALSA timer scheduling: buffer=" << hwBufferSize << " watermark=" << m_private->watermark);
+		}
+	}
 	// TODO : m_device[modeToIdTable(_mode)] = _device;
 	m_state = audio::orchestra::state::stopped;
 	// Setup the buffer conversion information structure.
 	if (m_doConvertBuffer[modeToIdTable(_mode)]) {
 		setConvertInfo(_mode, _firstChannel);
 	}
+	m_private->handle[modeToIdTable(_mode)] = handle;
+	if (m_mode == audio::orchestra::mode_output) {
+		// Full duplex: the IO thread already exist, it will drive the 2 handles.
+		m_mode = audio::orchestra::mode_duplex;
+		if (snd_pcm_link(m_private->handle[0], m_private->handle[1]) == 0) {
+			m_private->linked = true;
+		} else {
+			ATA_WARNING("Can not link the capture and playback handles (not the same clock?) ==> start them separately");
+			m_private->linked = false;
+		}
+		m_private->prefill = true;
+		return true;
+	}
 	m_mode = _mode;
+	// Setup the watchdog.
+	{
+		int64_t bufferTimeMs = int64_t(m_private->hwBufferSize) * 1000LL / int64_t(m_sampleRate);
+		m_private->watchdogTimeout = bufferTimeMs * watchdogBufferCount;
+		if (m_private->watchdogTimeout < int32_t(watchdogMinimumMs)) {
+			m_private->watchdogTimeout = watchdogMinimumMs;
+		}
+		m_private->watchdogCount = 0;
+		m_private->stalled = false;
+		ATA_DEBUG("ALSA watchdog timeout = " << m_private->watchdogTimeout << "ms");
+	}
+	if (m_threadConfig.sharedThread >= 0) {
+		if (m_private->timerScheduling == true) {
+			ATA_WARNING("the timer scheduling mode use its own IO thread (the shared thread " << m_threadConfig.sharedThread << " is not used)");
+		} else {
+			m_private->engine = audio::orchestra::api::AlsaEngine::get(m_threadConfig.sharedThread, m_threadConfig);
+			if (m_private->engine == null) {
+				goto error;
+			}
+			m_private->engine->add(this);
+			return true;
+		}
+	}
+	// Setup the control event of the IO thread.
+	m_private->eventFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (m_private->eventFd < 0) {
+		ATA_ERROR("creating the control eventfd: " << strerror(errno));
+		goto error;
+	}
 	// Setup callback thread.
 	m_private->threadRunning = true;
 	ATA_INFO("create thread ...");
@@ -810,17 +1238,22 @@ bool audio::orchestra::api::Alsa::openName(const etk::String& _deviceName,
 	ethread::setPriority(*m_private->thread, -6);
 	return true;
 error:
-	if (m_private->handle) {
-		snd_pcm_close(m_private->handle);
-		m_private->handle = null;
-	}
-	for (int32_t iii=0; iii<2; ++iii) {
-		m_userBuffer[iii].clear();
-	}
-	if (m_deviceBuffer) {
-		free(m_deviceBuffer);
-		m_deviceBuffer = 0;
+	if (handle) {
+		snd_pcm_close(handle);
+		handle = null;
+	}
+	if (    m_mode == audio::orchestra::mode_unknow
+	     && m_private->eventFd >= 0) {
+		close(m_private->eventFd);
+		m_private->eventFd = -1;
+	}
+	m_private->handle[modeToIdTable(_mode)] = null;
+	m_userBuffer[modeToIdTable(_mode)].clear();
+	if (m_mode != audio::orchestra::mode_unknow) {
+		// The playback side of the duplex stream is still open (closed by the caller).
+		return false;
 	}
+	m_deviceBuffer.clear();
 	m_state = audio::orchestra::state::closed;
 	return false;
 }
@@ -837,26 +1270,48 @@ enum audio::orchestra::error audio::orchestra::api::Alsa::closeStream() {
 		m_private->m_semaphore.post();
 	}
 	m_mutex.unLock();
+	if (m_private->engine != null) {
+		// When remove return, the shared thread does not use this stream anymore.
+		m_private->engine->remove(this);
+		m_private->engine.reset();
+	}
+	// Do not wait the next period of the device (or the watchdog if it is stalled).
+	wakeUpThread();
 	if (m_private->thread != null) {
 		m_private->thread->join();
 		m_private->thread = null;
 	}
-	if (m_state == audio::orchestra::state::running) {
+	if (m_private->eventFd >= 0) {
+		close(m_private->eventFd);
+		m_private->eventFd = -1;
+	}
+	// A stream stopped by its callback may not be drained by the shared engine yet.
+	if (    m_state == audio::orchestra::state::running
+	     || m_state == audio::orchestra::state::stopping) {
 		m_state = audio::orchestra::state::stopped;
-		snd_pcm_drop(m_private->handle);
+		for (int32_t iii=0; iii<2; ++iii) {
+			if (m_private->handle[iii] != null) {
+				snd_pcm_drop(m_private->handle[iii]);
+			}
+		}
 	}
 	// close all stream :
-	if (m_private->handle) {
-		snd_pcm_close(m_private->handle);
-		m_private->handle = null;
+	m_private->aggregate.clear();
+	if (m_private->linked == true) {
+		snd_pcm_unlink(m_private->handle[1]);
+		m_private->linked = false;
 	}
 	for (int32_t iii=0; iii<2; ++iii) {
-		m_userBuffer[iii].clear();
+		if (m_private->handle[iii] != null) {
+			snd_pcm_close(m_private->handle[iii]);
+			m_private->handle[iii] = null;
+		}
 	}
-	if (m_deviceBuffer) {
-		free(m_deviceBuffer);
-		m_deviceBuffer = 0;
+	for (int32_t iii=0; iii<2; ++iii) {
+		m_userBuffer[iii].clear();
 	}
+	m_deviceBuffer.clear();
+	m_private->deviceLost = false;
 	m_mode = audio::orchestra::mode_unknow;
 	m_state = audio::orchestra::state::closed;
 	return audio::orchestra::error_none;
@@ -880,24 +1335,41 @@ enum audio::orchestra::error audio::orchestra::api::Alsa::startStream() {
 	ATA_DEBUG("Lock (done)");
 	int32_t result = 0;
 	snd_pcm_state_t state;
-	if (m_private->handle == null) {
+	if (    m_private->handle[0] == null
+	     && m_private->handle[1] == null) {
 		ATA_ERROR("send null to alsa ...");
 	}
-	ATA_DEBUG("snd_pcm_state");
-	state = snd_pcm_state(m_private->handle);
-	ATA_DEBUG("snd_pcm_state (done)");
-	if (state != SND_PCM_STATE_PREPARED) {
-		ATA_ERROR("prepare stream");
-		result = snd_pcm_prepare(m_private->handle);
-		if (result < 0) {
-			ATA_ERROR("error preparing pcm device: ERR=" << snd_strerror(result) << ".");
-			goto unlock;
+	// Note: when the handles are linked, preparing the first one prepare the second.
+	for (int32_t iii=0; iii<2; ++iii) {
+		if (m_private->handle[iii] == null) {
+			continue;
+		}
+		ATA_DEBUG("snd_pcm_state");
+		state = snd_pcm_state(m_private->handle[iii]);
+		ATA_DEBUG("snd_pcm_state (done)");
+		if (state != SND_PCM_STATE_PREPARED) {
+			ATA_ERROR("prepare stream");
+			result = snd_pcm_prepare(m_private->handle[iii]);
+			if (result < 0) {
+				ATA_ERROR("error preparing pcm device: ERR=" << snd_strerror(result) << ".");
+				goto unlock;
+			}
 		}
 	}
+	if (m_mode == audio::orchestra::mode_duplex) {
+		m_private->prefill = true;
+	}
+	for (size_t iii=0; iii<m_private->aggregate.size(); ++iii) {
+		m_private->aggregate[iii]->start();
+	}
+	m_private->watchdogCount = 0;
+	m_private->stalled = false;
+	m_private->engineStarted = false;
 	m_state = audio::orchestra::state::running;
 unlock:
 	m_private->runnable = true;
 	m_private->m_semaphore.post();
+	wakeUpThread();
 	if (result >= 0) {
 		ATA_DEBUG("Start stream (END2)");
 		return audio::orchestra::error_none;
@@ -917,16 +1389,27 @@ enum audio::orchestra::error audio::orchestra::api::Alsa::stopStream() {
 	m_state = audio::orchestra::state::stopped;
 	ethread::UniqueLock lck(m_mutex);
 	int32_t result = 0;
-	if (m_mode == audio::orchestra::mode_output) {
-		result = snd_pcm_drain(m_private->handle);
-	} else {
-		result = snd_pcm_drop(m_private->handle);
+	if (m_private->handle[0] != null) {
+		result = snd_pcm_drain(m_private->handle[0]);
+		if (result < 0) {
+			ATA_ERROR("error draining output pcm device, " << snd_strerror(result) << ".");
+			goto unlock;
+		}
 	}
-	if (result < 0) {
-		ATA_ERROR("error draining output pcm device, " << snd_strerror(result) << ".");
-		goto unlock;
+	if (    m_private->handle[1] != null
+	     && (    m_private->linked == false
+	          || m_private->handle[0] == null)) {
+		result = snd_pcm_drop(m_private->handle[1]);
+		if (result < 0) {
+			ATA_ERROR("error stopping input pcm device, " << snd_strerror(result) << ".");
+			goto unlock;
+		}
+	}
+	for (size_t iii=0; iii<m_private->aggregate.size(); ++iii) {
+		m_private->aggregate[iii]->stop();
 	}
 unlock:
+	wakeUpThread();
 	if (result >= 0) {
 		return audio::orchestra::error_none;
 	}
@@ -944,25 +1427,82 @@ enum audio::orchestra::error audio::orchestra::api::Alsa::abortStream() {
 	m_state = audio::orchestra::state::stopped;
 	ethread::UniqueLock lck(m_mutex);
 	int32_t result = 0;
-	result = snd_pcm_drop(m_private->handle);
-	if (result < 0) {
-		ATA_ERROR("error aborting output pcm device, " << snd_strerror(result) << ".");
-		goto unlock;
+	for (int32_t iii=0; iii<2; ++iii) {
+		if (m_private->handle[iii] == null) {
+			continue;
+		}
+		// linked handles are dropped together
+		if (    iii == 1
+		     && m_private->linked == true) {
+			break;
+		}
+		result = snd_pcm_drop(m_private->handle[iii]);
+		if (result < 0) {
+			ATA_ERROR("error aborting pcm device, " << snd_strerror(result) << ".");
+			goto unlock;
+		}
+	}
+	for (size_t iii=0; iii<m_private->aggregate.size(); ++iii) {
+		m_private->aggregate[iii]->stop();
 	}
 unlock:
+	wakeUpThread();
 	if (result >= 0) {
 		return audio::orchestra::error_none;
 	}
 	return audio::orchestra::error_systemError;
 }
 
+/**
+ * @brief Read all the pending control events.
+ */
+static void drainEventFd(int32_t _fd) {
+	uint64_t value = 0;
+	while (read(_fd, &value, sizeof(value)) > 0) {
+		// nothing to do
+	}
+}
+
+/**
+ * @brief Wait a control event (the device is not polled).
+ * @param[in] _fd Control eventfd.
+ * @param[in] _timeoutMs Maximum waiting time (-1 infinite).
+ */
+static void wait_for_control(int32_t _fd, int32_t _timeoutMs) {
+	struct pollfd ufds;
+	ufds.fd = _fd;
+	ufds.events = POLLIN;
+	ufds.revents = 0;
+	if (poll(&ufds, 1, _timeoutMs) > 0) {
+		drainEventFd(_fd);
+	}
+}
+
 /**
  * @briefTransfer method - write and wait for room in buffer using poll
+ * @param[in] _handle PCM handle
+ * @param[in] _ufds List of the _count PCM descriptors followed by the control eventfd.
+ * @param[in] _count Number of PCM descriptors.
+ * @param[in] _timeoutMs Watchdog timeout (-1 infinite).
+ * @return 0 the device is ready, 1 a control event is received, -ETIMEDOUT when no period came before the timeout, -EIO on error.
  */
-static int32_t wait_for_poll(snd_pcm_t* _handle, struct pollfd* _ufds, unsigned int _count) {
+static int32_t wait_for_poll(snd_pcm_t* _handle, struct pollfd* _ufds, unsigned int _count, int32_t _timeoutMs) {
 	uint16_t revents;
 	while (true) {
-		poll(_ufds, _count, -1);
+		int32_t ret = poll(_ufds, _count+1, _timeoutMs);
+		if (ret == 0) {
+			return -ETIMEDOUT;
+		}
+		if (ret < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return -EIO;
+		}
+		if (_ufds[_count].revents & POLLIN) {
+			drainEventFd(_ufds[_count].fd);
+			return 1;
+		}
 		snd_pcm_poll_descriptors_revents(_handle, _ufds, _count, &revents);
 		if (revents & POLLERR) {
 			return -EIO;
@@ -976,104 +1516,722 @@ static int32_t wait_for_poll(snd_pcm_t* _handle, struct pollfd* _ufds, unsigned
 	}
 }
 
-void audio::orchestra::api::Alsa::callbackEvent() {
-	// Lock while the system is not started ...
-	if (m_state == audio::orchestra::state::stopped) {
-		while (!m_private->runnable) {
-			m_private->m_semaphore.wait();
-		}
-		if (m_state != audio::orchestra::state::running) {
-			return;
-		}
-	}
-	ethread::setName("Alsa IO-" + m_name);
-	//Wait data with poll
-	etk::Vector<struct pollfd> ufds;
-	signed short *ptr;
-	int32_t err, count, cptr, init;
-	count = snd_pcm_poll_descriptors_count(m_private->handle);
+/**
+ * @brief Get the descriptors of the IO thread.
+ * @param[in] _handle Device that drive the cycle.
+ * @param[out] _ufds Descriptors of the device and the control event (last one).
+ * @param[in] _eventFd Control eventfd.
+ * @return Number of descriptors of the device.
+ */
+static int32_t getPollDescriptors(snd_pcm_t* _handle, etk::Vector<struct pollfd>& _ufds, int32_t _eventFd) {
+	int32_t count = snd_pcm_poll_descriptors_count(_handle);
 	if (count <= 0) {
 		ATA_CRITICAL("Invalid poll descriptors count");
+		count = 0;
 	}
-	ufds.resize(count);
-	if (ufds.size() == 0) {
+	// The last descriptor is the control event.
+	_ufds.resize(count+1);
+	if (_ufds.size() == 0) {
 		ATA_CRITICAL("No enough memory\n");
 	}
-	if ((err = snd_pcm_poll_descriptors(m_private->handle, &(ufds[0]), count)) < 0) {
+	int32_t err = snd_pcm_poll_descriptors(_handle, &(_ufds[0]), count);
+	if (err < 0) {
 		ATA_CRITICAL("Unable to obtain poll descriptors for playback: "<< snd_strerror(err));
 	}
-	while (m_private->threadRunning == true) {
-		// have data or need data ...
-		if (m_private->mmapInterface == false) {
-			if (m_mode == audio::orchestra::mode_input) {
-				callbackEventOneCycleRead();
-			} else {
-				callbackEventOneCycleWrite();
+	_ufds[count].fd = _eventFd;
+	_ufds[count].events = POLLIN;
+	_ufds[count].revents = 0;
+	return count;
+}
+
+/**
+ * @brief Open a device with the configuration of a lost device (same access, format, channels, rate, period and buffer).
+ * @param[in] _deviceName Name of the device to open.
+ * @param[in] _stream Direction of the device.
+ * @param[in] _hwParams Hardware configuration of the lost device.
+ * @param[in] _swParams Software configuration of the lost device.
+ * @param[in] _timerScheduling Disable the period interrupts (timer scheduling mode).
+ * @return The prepared device or null if it is not availlable with this configuration.
+ */
+static snd_pcm_t* reopenDevice(const etk::String& _deviceName,
+                               snd_pcm_stream_t _stream,
+                               const snd_pcm_hw_params_t* _hwParams,
+                               snd_pcm_sw_params_t* _swParams,
+                               bool _timerScheduling) {
+	snd_pcm_t* handle = null;
+	// Non-blocking open: a device used by an other application must not block the IO thread.
+	if (snd_pcm_open(&handle, _deviceName.c_str(), _stream, SND_PCM_NONBLOCK) < 0) {
+		return null;
+	}
+	snd_pcm_nonblock(handle, 0);
+	snd_pcm_access_t access;
+	snd_pcm_format_t format;
+	uint32_t channels = 0;
+	uint32_t rate = 0;
+	snd_pcm_uframes_t periodSize = 0;
+	snd_pcm_uframes_t bufferSize = 0;
+	int32_t dir = 0;
+	snd_pcm_hw_params_get_access(_hwParams, &access);
+	snd_pcm_hw_params_get_format(_hwParams, &format);
+	snd_pcm_hw_params_get_channels(_hwParams, &channels);
+	snd_pcm_hw_params_get_rate(_hwParams, &rate, &dir);
+	snd_pcm_hw_params_get_period_size(_hwParams, &periodSize, &dir);
+	snd_pcm_hw_params_get_buffer_size(_hwParams, &bufferSize);
+	snd_pcm_hw_params_t *hwParams;
+	snd_pcm_hw_params_alloca(&hwParams);
+	if (    snd_pcm_hw_params_any(handle, hwParams) < 0
+	     || snd_pcm_hw_params_set_access(handle, hwParams, access) < 0
+	     || snd_pcm_hw_params_set_format(handle, hwParams, format) < 0
+	     || snd_pcm_hw_params_set_channels(handle, hwParams, channels) < 0
+	     || snd_pcm_hw_params_set_rate(handle, hwParams, rate, 0) < 0
+	     || snd_pcm_hw_params_set_period_size(handle, hwParams, periodSize, 0) < 0
+	     || snd_pcm_hw_params_set_buffer_size(handle, hwParams, bufferSize) < 0) {
+		ATA_WARNING("ALSA reconnect: device '" << _deviceName << "' does not support the configuration of the stream");
+		snd_pcm_close(handle);
+		return null;
+	}
+	if (    _timerScheduling == true
+	     && snd_pcm_hw_params_can_disable_period_wakeup(hwParams) == 1) {
+		snd_pcm_hw_params_set_period_wakeup(handle, hwParams, 0);
+	}
+	int32_t result = snd_pcm_hw_params(handle, hwParams);
+	if (result >= 0) {
+		result = snd_pcm_sw_params(handle, _swParams);
+	}
+	if (result < 0) {
+		ATA_WARNING("ALSA reconnect: can not configure the device '" << _deviceName << "': " << snd_strerror(result));
+		snd_pcm_close(handle);
+		return null;
+	}
+	return handle;
+}
+
+bool audio::orchestra::api::Alsa::checkDeviceLost(int32_t _idTable, int32_t _result) {
+	snd_pcm_t* handle = m_private->handle[_idTable];
+	if (    _result != -ENODEV
+	     && (    handle == null
+	          || snd_pcm_state(handle) != SND_PCM_STATE_DISCONNECTED)) {
+		return false;
+	}
+	if (m_private->deviceLost == false) {
+		ATA_ERROR("ALSA device '" << m_private->deviceName[_idTable] << "' lost: " << snd_strerror(_result));
+		m_private->deviceLost = true;
+	}
+	return true;
+}
+
+bool audio::orchestra::api::Alsa::reconnect() {
+	m_private->deviceLost = false;
+	if (    m_reconnect == false
+	     || m_private->aggregate.size() != 0
+	     || m_private->engine != null
+	     || (    m_private->handle[0] != null
+	          && m_private->hwParams[0] == null)
+	     || (    m_private->handle[1] != null
+	          && m_private->hwParams[1] == null)) {
+		if (m_reconnect == true) {
+			ATA_ERROR("ALSA reconnect: not availlable with the aggregated devices or the shared IO thread");
+		}
+		ATA_ERROR("ALSA: device lost ==> stop the IO");
+		m_private->watchdogCount = watchdogMaxRestart + 1;
+		return false;
+	}
+	audio::Time lossTime = audio::Time::now();
+	audio::Duration timeout(0, int64_t(m_reconnectTimeout) * 1000000LL);
+	snd_pcm_t* handle[2] = {null, null};
+	bool done = false;
+	while (    m_private->threadRunning == true
+	        && m_state == audio::orchestra::state::running) {
+		done = true;
+		for (int32_t iii=0; iii<2; ++iii) {
+			if (    m_private->handle[iii] == null
+			     || handle[iii] != null) {
+				continue;
 			}
-		} else {
-			if (m_mode == audio::orchestra::mode_input) {
-				callbackEventOneCycleMMAPRead();
-			} else {
-				callbackEventOneCycleMMAPWrite();
+			snd_pcm_stream_t stream = (iii == 0 ? SND_PCM_STREAM_PLAYBACK : SND_PCM_STREAM_CAPTURE);
+			// The lost device first (it can be plugged again), then the fallbacks in order.
+			handle[iii] = reopenDevice(m_private->deviceName[iii], stream, m_private->hwParams[iii], m_private->swParams[iii], m_private->timerScheduling);
+			for (size_t jjj=0; jjj<m_fallbackDeviceName[iii].size() && handle[iii] == null; ++jjj) {
+				handle[iii] = reopenDevice(m_fallbackDeviceName[iii][jjj], stream, m_private->hwParams[iii], m_private->swParams[iii], m_private->timerScheduling);
+				if (handle[iii] != null) {
+					ATA_WARNING("ALSA reconnect: use the fallback device '" << m_fallbackDeviceName[iii][jjj] << "'");
+				}
+			}
+			if (handle[iii] == null) {
+				done = false;
 			}
 		}
-		ATA_VERBOSE("Poll [Start] " << count);
-		err = wait_for_poll(m_private->handle, &(ufds[0]), count);
-		ATA_VERBOSE("Poll [STOP] " << err);
-		if (err < 0) {
-			ATA_ERROR(" POLL timeout ...");
-			return;
+		if (done == true) {
+			break;
+		}
+		if (timeout <= audio::Time::now() - lossTime) {
+			ATA_ERROR("ALSA reconnect: no device found in " << m_reconnectTimeout << "ms ==> stop the IO");
+			break;
+		}
+		// Retry later (a stop or a close of the stream wake up the thread).
+		wait_for_control(m_private->eventFd, reconnectRetryMs);
+		done = false;
+	}
+	if (done == false) {
+		for (int32_t iii=0; iii<2; ++iii) {
+			if (handle[iii] != null) {
+				snd_pcm_close(handle[iii]);
+			}
 		}
+		m_private->watchdogCount = watchdogMaxRestart + 1;
+		return false;
 	}
-	ATA_DEBUG("End of thread");
-}
-
-audio::Time audio::orchestra::api::Alsa::getStreamTime() {
-	//ATA_DEBUG("mode : " << m_private->timeMode);
-	if (m_private->timeMode == timestampMode_Hardware) {
-		snd_pcm_status_t *status = null;
-		snd_pcm_status_alloca(&status);
-		// get harware timestamp all the time:
-		snd_pcm_status(m_private->handle, status);
-		#if 1
-			snd_timestamp_t timestamp;
-			snd_pcm_status_get_tstamp(status, &timestamp);
-			m_startTime = audio::Time(timestamp.tv_sec, timestamp.tv_usec * 1000);
-		#else
-			#if 1
-				snd_htimestamp_t timestamp;
-				snd_pcm_status_get_htstamp(status, &timestamp);
-				m_startTime = audio::Time(timestamp.tv_sec, timestamp.tv_nsec);
-			#else
-				snd_htimestamp_t timestamp;
-				snd_pcm_status_get_audio_htstamp(status, &timestamp);
-				m_startTime = audio::Time(timestamp.tv_sec, timestamp.tv_nsec);
-				return m_startTime;
-			#endif
-		#endif
-		ATA_VERBOSE("snd_pcm_status_get_htstamp : " << m_startTime);
+	{
+		ethread::UniqueLock lck(m_mutex);
+		if (m_private->linked == true) {
+			snd_pcm_unlink(m_private->handle[1]);
+			m_private->linked = false;
+		}
+		for (int32_t iii=0; iii<2; ++iii) {
+			if (handle[iii] == null) {
+				continue;
+			}
+			snd_pcm_close(m_private->handle[iii]);
+			m_private->handle[iii] = handle[iii];
+			m_private->xrun[iii] = false;
+		}
+		m_private->clock.reset();
+		m_private->watchdogCount = 0;
+		m_private->stalled = false;
+		if (m_mode == audio::orchestra::mode_duplex) {
+			m_private->linked = (snd_pcm_link(m_private->handle[0], m_private->handle[1]) == 0);
+			m_private->prefill = true;
+		}
+	}
+	int32_t doStopStream = fillStreamGap(audio::Time::now() - lossTime);
+	if (doStopStream == 2) {
+		abortStream();
+	} else if (doStopStream == 1) {
+		callbackStopStream();
+	} else if (m_mode == audio::orchestra::mode_input) {
+		// The capture start after the periods of the gap: the new device does not overrun before the first read.
+		ethread::UniqueLock lck(m_mutex);
+		snd_pcm_start(m_private->handle[1]);
+	}
+	return true;
+}
+
+void audio::orchestra::api::Alsa::callbackStopStream() {
+	if (m_private->engine == null) {
+		stopStream();
+		return;
+	}
+	// The drain block until the end of the buffer: it can not be done in the thread shared with the other streams.
+	m_state = audio::orchestra::state::stopping;
+	__atomic_store_n(&m_private->stopPending, true, __ATOMIC_RELEASE);
+	m_private->engine->requestStop();
+}
+
+bool audio::orchestra::api::Alsa::engineStopPending() {
+	return __atomic_exchange_n(&m_private->stopPending, false, __ATOMIC_ACQ_REL);
+}
+
+void audio::orchestra::api::Alsa::engineStop() {
+	if (m_state != audio::orchestra::state::stopping) {
+		// Stopped, aborted or restarted by the user in the meantime.
+		return;
+	}
+	stopStream();
+}
+
+void audio::orchestra::api::Alsa::wakeUpThread() {
+	if (m_private->engine != null) {
+		m_private->engine->wakeUp();
+		return;
+	}
+	if (m_private->eventFd < 0) {
+		return;
+	}
+	uint64_t value = 1;
+	if (write(m_private->eventFd, &value, sizeof(value)) < 0) {
+		// The counter is already set: the thread will wake up.
+	}
+}
+
+bool audio::orchestra::api::Alsa::watchdogRestart() {
+	// In duplex mode, the capture drive the IO thread.
+	snd_pcm_t* handle = m_private->handle[0];
+	if (    m_mode == audio::orchestra::mode_input
+	     || m_mode == audio::orchestra::mode_duplex) {
+		handle = m_private->handle[1];
+	}
+	m_private->watchdogCount++;
+	m_private->stalled = true;
+	ATA_ERROR("ALSA watchdog: no period since " << m_private->watchdogTimeout << "ms ==> device stalled (state=" << snd_pcm_state_name(snd_pcm_state(handle)) << ") restart " << m_private->watchdogCount << "/" << watchdogMaxRestart);
+	if (m_private->watchdogCount > watchdogMaxRestart) {
+		ATA_ERROR("ALSA watchdog: device '" << m_name << "' does not restart ==> stop the IO");
+		return false;
+	}
+	ethread::UniqueLock lck(m_mutex);
+	// The linked handles are restarted together.
+	snd_pcm_drop(handle);
+	int32_t result = snd_pcm_prepare(handle);
+	if (result < 0) {
+		ATA_ERROR("ALSA watchdog: can not prepare the device: " << snd_strerror(result));
+		return true;
+	}
+	m_private->xrun[0] = (m_private->handle[0] != null);
+	m_private->xrun[1] = (m_private->handle[1] != null);
+	if (m_mode == audio::orchestra::mode_duplex) {
+		m_private->prefill = true;
+	} else if (m_mode == audio::orchestra::mode_input) {
+		snd_pcm_start(handle);
+	}
+	return true;
+}
+
+void audio::orchestra::api::Alsa::callbackEvent() {
+	// Lock while the system is not started ...
+	if (m_state == audio::orchestra::state::stopped) {
+		while (!m_private->runnable) {
+			m_private->m_semaphore.wait();
+		}
+		if (m_state != audio::orchestra::state::running) {
+			return;
+		}
+	}
+	ethread::setName("Alsa IO-" + m_name);
+	configureIoThread();
+	// In duplex mode, the capture drive the cycle (the playback write is blocking).
+	snd_pcm_t* pollHandle = m_private->handle[0];
+	if (    m_mode == audio::orchestra::mode_input
+	     || m_mode == audio::orchestra::mode_duplex) {
+		pollHandle = m_private->handle[1];
+	}
+	//Wait data with poll
+	etk::Vector<struct pollfd> ufds;
+	int32_t err;
+	int32_t count = getPollDescriptors(pollHandle, ufds, m_private->eventFd);
+	if (m_private->timerScheduling == true) {
+		callbackEventTimer();
+		ATA_DEBUG("End of thread");
+		return;
+	}
+	while (m_private->threadRunning == true) {
+		if (    m_state != audio::orchestra::state::running
+		     || m_private->watchdogCount > watchdogMaxRestart) {
+			// Stopped (or dead device): the device is not polled, wait the next start or the close.
+			wait_for_control(m_private->eventFd, -1);
+			continue;
+		}
+		if (m_private->deviceLost == true) {
+			if (reconnect() == true) {
+				// New device: new descriptors.
+				pollHandle = m_private->handle[0];
+				if (    m_mode == audio::orchestra::mode_input
+				     || m_mode == audio::orchestra::mode_duplex) {
+					pollHandle = m_private->handle[1];
+				}
+				count = getPollDescriptors(pollHandle, ufds, m_private->eventFd);
+			}
+			continue;
+		}
+		// have data or need data ...
+		callbackEventAvailable();
+		if (m_private->deviceLost == true) {
+			continue;
+		}
+		ATA_VERBOSE("Poll [Start] " << count);
+		err = wait_for_poll(pollHandle, &(ufds[0]), count, m_private->watchdogTimeout);
+		ATA_VERBOSE("Poll [STOP] " << err);
+		if (err == 0) {
+			m_private->watchdogCount = 0;
+			m_private->stalled = false;
+		} else if (err == 1) {
+			// control event: check the stream state.
+			continue;
+		} else if (err == -ETIMEDOUT) {
+			if (m_state != audio::orchestra::state::running) {
+				continue;
+			}
+			if (    watchdogRestart() == false
+			     && m_reconnect == true) {
+				// The device does not restart: open it again.
+				m_private->watchdogCount = 0;
+				m_private->deviceLost = true;
+			}
+		} else if (err < 0) {
+			if (m_state != audio::orchestra::state::running) {
+				// The device has been stopped while polling.
+				continue;
+			}
+			if (checkDeviceLost((m_mode == audio::orchestra::mode_output ? 0 : 1), err) == true) {
+				continue;
+			}
+			ATA_ERROR(" POLL error ...");
+			return;
+		}
+	}
+	ATA_DEBUG("End of thread");
+}
+
+bool audio::orchestra::api::Alsa::engineIsActive() {
+	return    m_state == audio::orchestra::state::running
+	       && m_private->watchdogCount <= watchdogMaxRestart;
+}
+
+void audio::orchestra::api::Alsa::engineStartCapture() {
+	if (m_private->handle[1] == null) {
+		return;
+	}
+	if (snd_pcm_state(m_private->handle[1]) != SND_PCM_STATE_PREPARED) {
+		return;
+	}
+	if (    m_mode == audio::orchestra::mode_duplex
+	     && m_private->prefill == true) {
+		// The linked capture can be started by the playback start threshold.
+		duplexPrefill();
+		if (snd_pcm_state(m_private->handle[1]) != SND_PCM_STATE_PREPARED) {
+			return;
+		}
+	}
+	int32_t result = snd_pcm_start(m_private->handle[1]);
+	if (result < 0) {
+		ATA_ERROR("can not start the capture: " << snd_strerror(result));
+	}
+}
+
+int32_t audio::orchestra::api::Alsa::engineGetPollDescriptors(etk::Vector<struct pollfd>& _ufds) {
+	// In duplex mode, the capture drive the cycle.
+	snd_pcm_t* pollHandle = m_private->handle[0];
+	if (    m_mode == audio::orchestra::mode_input
+	     || m_mode == audio::orchestra::mode_duplex) {
+		pollHandle = m_private->handle[1];
+	}
+	ethread::UniqueLock lck(m_mutex);
+	if (m_private->engineStarted == false) {
+		m_private->engineStarted = true;
+		m_private->lastPeriod = audio::Time::now();
+		if (m_threadConfig.lockMemory == true) {
+			lockStreamBuffers();
+		}
+	}
+	engineStartCapture();
+	int32_t count = snd_pcm_poll_descriptors_count(pollHandle);
+	if (count <= 0) {
+		ATA_ERROR("Invalid poll descriptors count");
+		return 0;
+	}
+	size_t offset = _ufds.size();
+	_ufds.resize(offset + count);
+	int32_t result = snd_pcm_poll_descriptors(pollHandle, &_ufds[offset], count);
+	if (result < 0) {
+		ATA_ERROR("Unable to obtain poll descriptors: " << snd_strerror(result));
+		_ufds.resize(offset);
+		return 0;
+	}
+	return count;
+}
+
+void audio::orchestra::api::Alsa::engineProcess(struct pollfd* _ufds, int32_t _count) {
+	if (m_state != audio::orchestra::state::running) {
+		return;
+	}
+	snd_pcm_t* pollHandle = m_private->handle[0];
+	if (    m_mode == audio::orchestra::mode_input
+	     || m_mode == audio::orchestra::mode_duplex) {
+		pollHandle = m_private->handle[1];
+	}
+	unsigned short revents = 0;
+	snd_pcm_poll_descriptors_revents(pollHandle, _ufds, _count, &revents);
+	if ((revents & (POLLIN | POLLOUT | POLLERR)) == 0) {
+		return;
+	}
+	if ((revents & (POLLIN | POLLOUT)) != 0) {
+		m_private->watchdogCount = 0;
+		m_private->stalled = false;
+		m_private->lastPeriod = audio::Time::now();
+	}
+	// POLLERR: the cycle recover the xrun (the watchdog is not reset).
+	callbackEventAvailable();
+	if (m_private->deviceLost == true) {
+		// The shared thread does not wait a new device: remove the stream from the poll set.
+		reconnect();
+		wakeUpThread();
+		return;
+	}
+	ethread::UniqueLock lck(m_mutex);
+	if (m_state == audio::orchestra::state::running) {
+		engineStartCapture();
+	}
+}
+
+int32_t audio::orchestra::api::Alsa::engineWatchdog(const audio::Time& _now) {
+	if (engineIsActive() == false) {
+		return -1;
+	}
+	int64_t elapsed = (_now.get() - m_private->lastPeriod.get()) / 1000000LL;
+	if (elapsed < m_private->watchdogTimeout) {
+		return m_private->watchdogTimeout - elapsed;
+	}
+	m_private->lastPeriod = _now;
+	if (watchdogRestart() == false) {
+		// Dead device: remove it from the poll set.
+		wakeUpThread();
+		return -1;
+	}
+	{
+		ethread::UniqueLock lck(m_mutex);
+		engineStartCapture();
+	}
+	return m_private->watchdogTimeout;
+}
+
+void audio::orchestra::api::Alsa::callbackEventOneCycle() {
+	if (m_private->mmapInterface[modeToIdTable(m_mode)] == false) {
+		if (m_mode == audio::orchestra::mode_input) {
+			callbackEventOneCycleRead();
+		} else {
+			callbackEventOneCycleWrite();
+		}
+	} else {
+		if (m_mode == audio::orchestra::mode_input) {
+			callbackEventOneCycleMMAPRead();
+		} else {
+			callbackEventOneCycleMMAPWrite();
+		}
+	}
+}
+
+void audio::orchestra::api::Alsa::callbackEventAvailable() {
+	uint32_t nbPeriods = 1;
+	if (m_private->catchUp == true) {
+		// In duplex mode, the capture drive the cycle.
+		snd_pcm_t* handle = m_private->handle[0];
+		if (    m_mode == audio::orchestra::mode_input
+		     || m_mode == audio::orchestra::mode_duplex) {
+			handle = m_private->handle[1];
+		}
+		snd_pcm_sframes_t avail = snd_pcm_avail_update(handle);
+		if (avail > snd_pcm_sframes_t(m_bufferSize)) {
+			nbPeriods = uint32_t(avail) / m_bufferSize;
+			uint32_t maxPeriods = m_private->hwBufferSize / m_bufferSize;
+			if (nbPeriods > maxPeriods) {
+				nbPeriods = maxPeriods;
+			}
+			if (nbPeriods > 1) {
+				ATA_VERBOSE("Catch up " << nbPeriods << " periods (avail=" << avail << ")");
+			}
+		}
+	}
+	for (uint32_t iii=0; iii<nbPeriods; ++iii) {
+		if (    iii != 0
+		     && m_state != audio::orchestra::state::running) {
+			break;
+		}
+		if (m_mode == audio::orchestra::mode_duplex) {
+			callbackEventOneCycleDuplex();
+		} else {
+			callbackEventOneCycle();
+		}
+	}
+}
+
+void audio::orchestra::api::Alsa::timerWatermarkUpdate(bool _xrun) {
+	audio::Time now = audio::Time::now();
+	if (_xrun == true) {
+		// Not enough margin: double it (up to the half of the buffer).
+		m_private->watermark *= 2;
+		if (m_private->watermark > m_private->hwBufferSize / 2) {
+			m_private->watermark = m_private->hwBufferSize / 2;
+		}
+		m_private->watermarkTime = now;
+		ATA_WARNING("ALSA timer scheduling xrun ==> watermark=" << m_private->watermark);
+		return;
+	}
+	if (    m_private->watermark > m_private->watermarkMin
+	     && now - m_private->watermarkTime > audio::Duration(tschedWatermarkDecreaseSecond, 0)) {
+		// Stable since a long time: reduce the margin slowly.
+		m_private->watermark = m_private->watermark * 3 / 4;
+		if (m_private->watermark < m_private->watermarkMin) {
+			m_private->watermark = m_private->watermarkMin;
+		}
+		m_private->watermarkTime = now;
+		ATA_INFO("ALSA timer scheduling stable ==> watermark=" << m_private->watermark);
+	}
+}
+
+void audio::orchestra::api::Alsa::callbackEventTimer() {
+	int32_t idTable = modeToIdTable(m_mode);
+	snd_pcm_t* handle = m_private->handle[idTable];
+	int32_t timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+	if (timerFd < 0) {
+		ATA_CRITICAL("Can not create the wakeup timer: " << strerror(errno));
+		return;
+	}
+	m_private->watermarkTime = audio::Time::now();
+	struct pollfd ufds[2];
+	ufds[0].fd = timerFd;
+	ufds[0].events = POLLIN;
+	ufds[1].fd = m_private->eventFd;
+	ufds[1].events = POLLIN;
+	// Watchdog: the poll never time out (the timer always wake up the thread), the position of the device must move.
+	audio::Time lastProgress = audio::Time::now();
+	snd_pcm_sframes_t lastAvail = -1;
+	while (m_private->threadRunning == true) {
+		if (    m_state != audio::orchestra::state::running
+		     || m_private->watchdogCount > watchdogMaxRestart) {
+			// Stopped (or dead device): wait the next start or the close.
+			wait_for_control(m_private->eventFd, -1);
+			lastProgress = audio::Time::now();
+			continue;
+		}
+		if (m_private->deviceLost == true) {
+			if (reconnect() == false) {
+				// Dead device: wait the close.
+				wait_for_control(m_private->eventFd, -1);
+			}
+			handle = m_private->handle[idTable];
+			lastProgress = audio::Time::now();
+			continue;
+		}
+		if (    m_mode == audio::orchestra::mode_input
+		     && snd_pcm_state(handle) == SND_PCM_STATE_PREPARED) {
+			// No blocking read to start the capture.
+			snd_pcm_start(handle);
+		}
+		// Process all the chunks availlable.
+		snd_pcm_sframes_t avail = snd_pcm_avail_update(handle);
+		if (    avail < 0
+		     && checkDeviceLost(idTable, avail) == true) {
+			continue;
+		} else if (avail < 0) {
+			// The read/write will restart the device.
+			avail = m_bufferSize;
+		} else if (snd_pcm_uframes_t(avail) >= m_private->hwBufferSize) {
+			// The stop threshold is disable: the xrun is only visible with the fill level.
+			if (snd_pcm_state(handle) == SND_PCM_STATE_RUNNING) {
+				m_private->xrun[idTable] = true;
+				timerWatermarkUpdate(true);
+			}
+		} else {
+			timerWatermarkUpdate(false);
+		}
+		if (    avail != lastAvail
+		     || avail >= snd_pcm_sframes_t(m_bufferSize)) {
+			lastProgress = audio::Time::now();
+			lastAvail = avail;
+			m_private->watchdogCount = 0;
+			m_private->stalled = false;
+		} else if (audio::Time::now() - lastProgress > audio::Duration(0, int64_t(m_private->watchdogTimeout) * 1000000LL)) {
+			lastProgress = audio::Time::now();
+			if (    watchdogRestart() == false
+			     && m_reconnect == true) {
+				// The device does not restart: open it again.
+				m_private->watchdogCount = 0;
+				m_private->deviceLost = true;
+			}
+			continue;
+		}
+		while (    avail >= snd_pcm_sframes_t(m_bufferSize)
+		        && m_private->threadRunning == true
+		        && m_state == audio::orchestra::state::running) {
+			callbackEventOneCycle();
+			avail -= m_bufferSize;
+		}
+		// Compute the next wakeup: when only the watermark stay in the buffer (or free in the buffer for the capture).
+		snd_pcm_sframes_t frames = m_bufferSize;
+		if (m_mode == audio::orchestra::mode_input) {
+			avail = snd_pcm_avail_update(handle);
+			if (avail >= 0) {
+				frames = snd_pcm_sframes_t(m_private->hwBufferSize) - snd_pcm_sframes_t(m_private->watermark) - avail;
+			}
+		} else {
+			snd_pcm_sframes_t delay = 0;
+			if (snd_pcm_delay(handle, &delay) == 0) {
+				frames = delay - snd_pcm_sframes_t(m_private->watermark);
+			}
+		}
+		if (frames < snd_pcm_sframes_t(m_bufferSize)) {
+			frames = m_bufferSize;
+		}
+		int64_t sleepNs = int64_t(frames) * 1000000000LL / int64_t(m_sampleRate);
+		struct itimerspec timeout;
+		memset(&timeout, 0, sizeof(timeout));
+		timeout.it_value.tv_sec = sleepNs / 1000000000LL;
+		timeout.it_value.tv_nsec = sleepNs % 1000000000LL;
+		timerfd_settime(timerFd, 0, &timeout, null);
+		ATA_VERBOSE("Timer wakeup in " << frames << " frames");
+		ufds[0].revents = 0;
+		ufds[1].revents = 0;
+		poll(ufds, 2, -1);
+		if (ufds[1].revents & POLLIN) {
+			// control event: check the stream state.
+			drainEventFd(m_private->eventFd);
+		}
+		uint64_t expirations = 0;
+		if (read(timerFd, &expirations, sizeof(expirations)) < 0) {
+			// nothing to do (the timer has been re-armed)
+		}
+	}
+	close(timerFd);
+}
+
+audio::Time audio::orchestra::api::Alsa::getStreamTime() {
+	if (m_private->timeMode == timestampMode_Hardware) {
+		// Value published by the IO thread at each period (no system call).
+		audio::orchestra::api::AlsaTimestamp timestamp;
+		if (m_private->clock.read(timestamp) == true) {
+			return audio::Time(timestamp.sec, timestamp.nsec);
+		}
+	}
+	return readStreamTime();
+}
+
+audio::Time audio::orchestra::api::Alsa::updateStreamTime() {
+	audio::orchestra::api::AlsaTimestamp timestamp;
+	audio::Time time = readStreamTime(&timestamp);
+	if (m_private->timeMode == timestampMode_Hardware) {
+		m_private->clock.write(timestamp);
+		// Time of the first frame of the period for the clock estimator (see tickStreamTime).
+		m_periodTime = time;
+	}
+	return time;
+}
+
+audio::Time audio::orchestra::api::Alsa::readStreamTime(audio::orchestra::api::AlsaTimestamp* _timestamp) {
+	//ATA_DEBUG("mode : " << m_private->timeMode);
+	// In duplex mode, the playback handle gives the stream time.
+	snd_pcm_t* handle = m_private->handle[modeToIdTable(m_mode)];
+	if (m_private->timeMode == timestampMode_Hardware) {
+		snd_pcm_status_t *status = null;
+		snd_pcm_status_alloca(&status);
+		// get harware timestamp all the time:
+		snd_pcm_status(handle, status);
+		snd_htimestamp_t timestamp;
+		snd_pcm_status_get_htstamp(status, &timestamp);
+		ATA_VERBOSE("snd_pcm_status_get_htstamp : " << timestamp.tv_sec << "." << timestamp.tv_nsec);
 		snd_pcm_sframes_t delay = snd_pcm_status_get_delay(status);
-		audio::Duration timeDelay = audio::Duration(0, delay*1000000000LL/int64_t(m_sampleRate));
-		ATA_VERBOSE("delay : " << timeDelay);
-		//return m_startTime + m_duration;
-		if (m_mode == audio::orchestra::mode_output) {
+		int64_t timeDelay = delay*1000000000LL/int64_t(m_sampleRate);
+		ATA_VERBOSE("delay : " << timeDelay << "ns");
+		int64_t timeNs = int64_t(timestamp.tv_sec)*1000000000LL + int64_t(timestamp.tv_nsec);
+		if (m_mode != audio::orchestra::mode_input) {
 			// output
-			m_startTime += timeDelay;
+			timeNs += timeDelay;
 		} else {
 			// input
-			m_startTime -= timeDelay;
+			timeNs -= timeDelay;
 		}
-		return m_startTime;
+		if (_timestamp != null) {
+			_timestamp->sec = timeNs / 1000000000LL;
+			_timestamp->nsec = timeNs % 1000000000LL;
+		}
+		return audio::Time(timeNs / 1000000000LL, timeNs % 1000000000LL);
 	} else if (m_private->timeMode == timestampMode_trigered) {
 		if (m_startTime == audio::Time()) {
 			snd_pcm_status_t *status = null;
 			snd_pcm_status_alloca(&status);
 			// get harware timestamp all the time:
-			snd_pcm_status(m_private->handle, status);
+			snd_pcm_status(handle, status);
 			// get start time:
 			snd_timestamp_t timestamp;
 			snd_pcm_status_get_trigger_tstamp(status, &timestamp);
-			m_startTime = audio::Time(timestamp.tv_sec, timestamp.tv_usec);
+			m_startTime = audio::Time(timestamp.tv_sec, timestamp.tv_usec * 1000);
 			ATA_VERBOSE("snd_pcm_status_get_trigger_tstamp : " << m_startTime);
 		}
 		return m_startTime + m_duration;
@@ -1083,7 +2241,7 @@ audio::Time audio::orchestra::api::Alsa::getStreamTime() {
 			m_startTime = audio::Time::now();
 			ATA_ERROR("START TIOMESTAMP : " << m_startTime);
 			audio::Duration timeDelay = audio::Duration(0, m_bufferSize*1000000000LL/int64_t(m_sampleRate));
-			if (m_mode == audio::orchestra::mode_output) {
+			if (m_mode != audio::orchestra::mode_input) {
 				// output
 				m_startTime += timeDelay;
 			} else {
@@ -1091,6 +2249,7 @@ audio::Time audio::orchestra::api::Alsa::getStreamTime() {
 				m_startTime -= timeDelay;
 			}
 			m_duration = audio::Duration(0);
+			m_streamFrames = 0;
 		}
 		return m_startTime + m_duration;
 	}
@@ -1106,9 +2265,13 @@ void audio::orchestra::api::Alsa::callbackEventOneCycleRead() {
 	int32_t doStopStream = 0;
 	audio::Time streamTime;
 	etk::Vector<enum audio::orchestra::status> status;
-	if (m_private->xrun[0] == true) {
-		status.pushBack(audio::orchestra::status::underflow);
-		m_private->xrun[0] = false;
+	if (m_private->xrun[1] == true) {
+		status.pushBack(audio::orchestra::status::overflow);
+		m_private->xrun[1] = false;
+	}
+	if (m_private->aggregateXrun == true) {
+		status.pushBack(audio::orchestra::status::overflow);
+		m_private->aggregateXrun = false;
 	}
 	int32_t result;
 	char *buffer;
@@ -1123,7 +2286,7 @@ void audio::orchestra::api::Alsa::callbackEventOneCycleRead() {
 	ethread::UniqueLock lck(m_mutex);
 	// Setup parameters.
 	if (m_doConvertBuffer[1]) {
-		buffer = m_deviceBuffer;
+		buffer = &m_deviceBuffer[0];
 		channels = m_nDeviceChannels[1];
 		format = m_deviceFormat[1];
 	} else {
@@ -1133,38 +2296,38 @@ void audio::orchestra::api::Alsa::callbackEventOneCycleRead() {
 	}
 	// Read samples from device in interleaved/non-interleaved format.
 	if (m_deviceInterleaved[1]) {
-		result = snd_pcm_readi(m_private->handle, buffer, m_bufferSize);
+		result = snd_pcm_readi(m_private->handle[1], buffer, m_bufferSize);
 	} else {
 		void *bufs[channels];
 		size_t offset = m_bufferSize * audio::getFormatBytes(format);
 		for (int32_t i=0; i<channels; i++)
 			bufs[i] = (void *) (buffer + (i * offset));
-		result = snd_pcm_readn(m_private->handle, bufs, m_bufferSize);
+		result = snd_pcm_readn(m_private->handle[1], bufs, m_bufferSize);
 	}
 	{
-		snd_pcm_state_t state = snd_pcm_state(m_private->handle);
+		snd_pcm_state_t state = snd_pcm_state(m_private->handle[1]);
 		ATA_VERBOSE("plop : " << state);
 		if (state == SND_PCM_STATE_XRUN) {
 			ATA_ERROR("Xrun...");
 		}
 	}
 	// get timestamp : (to init here ...
-	streamTime = getStreamTime();
+	streamTime = updateStreamTime();
 	ATA_VERBOSE("get data :" << result << " request:" << int32_t(m_bufferSize));
 	if (result < int32_t(m_bufferSize)) {
 		// Either an error or overrun occured.
 		if (result == -EPIPE) {
-			snd_pcm_state_t state = snd_pcm_state(m_private->handle);
+			snd_pcm_state_t state = snd_pcm_state(m_private->handle[1]);
 			if (state == SND_PCM_STATE_XRUN) {
 				m_private->xrun[1] = true;
-				result = snd_pcm_prepare(m_private->handle);
+				result = snd_pcm_prepare(m_private->handle[1]);
 				if (result < 0) {
 					ATA_ERROR("error preparing device after overrun, " << snd_strerror(result) << ".");
 				}
 			} else {
 				ATA_ERROR("error, current state is " << snd_pcm_state_name(state) << ", " << snd_strerror(result) << ".");
 			}
-		} else {
+		} else if (checkDeviceLost(1, result) == false) {
 			ATA_ERROR("audio read error, " << snd_strerror(result) << ".");
 			ethread::sleepMilliSeconds((10));
 		}
@@ -1177,17 +2340,19 @@ void audio::orchestra::api::Alsa::callbackEventOneCycleRead() {
 	}
 	// Do buffer conversion if necessary.
 	if (m_doConvertBuffer[1]) {
-		convertBuffer(&m_userBuffer[1][0], m_deviceBuffer, m_convertInfo[1]);
+		convertBuffer(&m_userBuffer[1][0], &m_deviceBuffer[0], m_convertInfo[1]);
 	}
 	// Check stream latency
-	result = snd_pcm_delay(m_private->handle, &frames);
+	result = snd_pcm_delay(m_private->handle[1], &frames);
 	if (result == 0 && frames > 0) {
 		ATA_VERBOSE("Delay in the Input " << frames << " chunk");
 		m_latency[1] = frames;
 	}
+	// Get the channels of the aggregated devices.
+	aggregateRead();
 
 noInput:
-	streamTime = getStreamTime();
+	streamTime = updateStreamTime();
 	{
 		audio::Time startCall = audio::Time::now();
 		doStopStream = m_callback(&m_userBuffer[1][0],
@@ -1211,7 +2376,7 @@ noInput:
 unlock:
 	audio::orchestra::Api::tickStreamTime();
 	if (doStopStream == 1) {
-		this->stopStream();
+		callbackStopStream();
 	}
 }
 
@@ -1223,9 +2388,13 @@ void audio::orchestra::api::Alsa::callbackEventOneCycleWrite() {
 	int32_t doStopStream = 0;
 	audio::Time streamTime;
 	etk::Vector<enum audio::orchestra::status> status;
-	if (m_private->xrun[1] == true) {
-		status.pushBack(audio::orchestra::status::overflow);
-		m_private->xrun[1] = false;
+	if (m_private->xrun[0] == true) {
+		status.pushBack(audio::orchestra::status::underflow);
+		m_private->xrun[0] = false;
+	}
+	if (m_private->aggregateXrun == true) {
+		status.pushBack(audio::orchestra::status::underflow);
+		m_private->aggregateXrun = false;
 	}
 	int32_t result;
 	char *buffer;
@@ -1237,7 +2406,7 @@ void audio::orchestra::api::Alsa::callbackEventOneCycleWrite() {
 		// !!! goto unlock;
 	}
 	
-	streamTime = getStreamTime();
+	streamTime = updateStreamTime();
 	{
 		audio::Time startCall = audio::Time::now();
 		doStopStream = m_callback(null,
@@ -1257,10 +2426,12 @@ void audio::orchestra::api::Alsa::callbackEventOneCycleWrite() {
 		abortStream();
 		return;
 	}
+	// Send the channels of the aggregated devices.
+	aggregateWrite();
 	ethread::UniqueLock lck(m_mutex);
 	// Setup parameters and do buffer conversion if necessary.
 	if (m_doConvertBuffer[0]) {
-		buffer = m_deviceBuffer;
+		buffer = &m_deviceBuffer[0];
 		convertBuffer(buffer, &m_userBuffer[0][0], m_convertInfo[0]);
 		channels = m_nDeviceChannels[0];
 		format = m_deviceFormat[0];
@@ -1275,36 +2446,36 @@ void audio::orchestra::api::Alsa::callbackEventOneCycleWrite() {
 	}
 	// Write samples to device in interleaved/non-interleaved format.
 	if (m_deviceInterleaved[0]) {
-		result = snd_pcm_writei(m_private->handle, buffer, m_bufferSize);
+		result = snd_pcm_writei(m_private->handle[0], buffer, m_bufferSize);
 	} else {
 		void *bufs[channels];
 		size_t offset = m_bufferSize * audio::getFormatBytes(format);
 		for (int32_t i=0; i<channels; i++) {
 			bufs[i] = (void *) (buffer + (i * offset));
 		}
-		result = snd_pcm_writen(m_private->handle, bufs, m_bufferSize);
+		result = snd_pcm_writen(m_private->handle[0], bufs, m_bufferSize);
 	}
 	if (result < (int) m_bufferSize) {
 		// Either an error or underrun occured.
 		if (result == -EPIPE) {
-			snd_pcm_state_t state = snd_pcm_state(m_private->handle);
+			snd_pcm_state_t state = snd_pcm_state(m_private->handle[0]);
 			if (state == SND_PCM_STATE_XRUN) {
 				m_private->xrun[0] = true;
-				result = snd_pcm_prepare(m_private->handle);
+				result = snd_pcm_prepare(m_private->handle[0]);
 				if (result < 0) {
 					ATA_ERROR("error preparing device after underrun, " << snd_strerror(result) << ".");
 				}
 			} else {
 				ATA_ERROR("error, current state is " << snd_pcm_state_name(state) << ", " << snd_strerror(result) << ".");
 			}
-		} else {
+		} else if (checkDeviceLost(0, result) == false) {
 			ATA_ERROR("audio write error, " << snd_strerror(result) << ".");
 		}
 		// TODO : Notuify application audio::orchestra::error_warning;
 		goto unlock;
 	}
 	// Check stream latency
-	result = snd_pcm_delay(m_private->handle, &frames);
+	result = snd_pcm_delay(m_private->handle[0], &frames);
 	if (result == 0 && frames > 0) {
 		ATA_VERBOSE("Delay in the Output " << frames << " chunk");
 		m_latency[0] = frames;
@@ -1313,7 +2484,7 @@ void audio::orchestra::api::Alsa::callbackEventOneCycleWrite() {
 unlock:
 	audio::orchestra::Api::tickStreamTime();
 	if (doStopStream == 1) {
-		this->stopStream();
+		callbackStopStream();
 	}
 }
 
@@ -1325,9 +2496,13 @@ void audio::orchestra::api::Alsa::callbackEventOneCycleMMAPWrite() {
 	int32_t doStopStream = 0;
 	audio::Time streamTime;
 	etk::Vector<enum audio::orchestra::status> status;
-	if (m_private->xrun[1] == true) {
-		status.pushBack(audio::orchestra::status::overflow);
-		m_private->xrun[1] = false;
+	if (m_private->xrun[0] == true) {
+		status.pushBack(audio::orchestra::status::underflow);
+		m_private->xrun[0] = false;
+	}
+	if (m_private->aggregateXrun == true) {
+		status.pushBack(audio::orchestra::status::underflow);
+		m_private->aggregateXrun = false;
 	}
 	int32_t result;
 	char *buffer;
@@ -1338,12 +2513,14 @@ void audio::orchestra::api::Alsa::callbackEventOneCycleMMAPWrite() {
 	if (m_state == audio::orchestra::state::stopped) {
 		// !!! goto unlock;
 	}
-	int32_t avail = snd_pcm_avail_update(m_private->handle);
+	int32_t avail = snd_pcm_avail_update(m_private->handle[0]);
 	if (avail < 0) {
-		ATA_ERROR("Can not get buffer data ..." << avail);
+		if (checkDeviceLost(0, avail) == false) {
+			ATA_ERROR("Can not get buffer data ..." << avail);
+		}
 		return;
 	}
-	streamTime = getStreamTime();
+	streamTime = updateStreamTime();
 	{
 		audio::Time startCall = audio::Time::now();
 		doStopStream = m_callback(null,
@@ -1363,11 +2540,13 @@ void audio::orchestra::api::Alsa::callbackEventOneCycleMMAPWrite() {
 		abortStream();
 		return;
 	}
+	// Send the channels of the aggregated devices.
+	aggregateWrite();
 	{
 		ethread::UniqueLock lck(m_mutex);
 		// Setup parameters and do buffer conversion if necessary.
 		if (m_doConvertBuffer[0]) {
-			buffer = m_deviceBuffer;
+			buffer = &m_deviceBuffer[0];
 			convertBuffer(buffer, &m_userBuffer[0][0], m_convertInfo[0]);
 			channels = m_nDeviceChannels[0];
 			format = m_deviceFormat[0];
@@ -1383,14 +2562,14 @@ void audio::orchestra::api::Alsa::callbackEventOneCycleMMAPWrite() {
 		#if 1
 			// Write samples to device in interleaved/non-interleaved format.
 			if (m_deviceInterleaved[0]) {
-				result = snd_pcm_mmap_writei(m_private->handle, buffer, m_bufferSize);
+				result = snd_pcm_mmap_writei(m_private->handle[0], buffer, m_bufferSize);
 			} else {
 				void *bufs[channels];
 				size_t offset = m_bufferSize * audio::getFormatBytes(format);
 				for (int32_t i=0; i<channels; i++) {
 					bufs[i] = (void *) (buffer + (i * offset));
 				}
-				result = snd_pcm_mmap_writen(m_private->handle, bufs, m_bufferSize);
+				result = snd_pcm_mmap_writen(m_private->handle[0], bufs, m_bufferSize);
 			}
 		#else
 			// TODO: Understand why this does not work ...
@@ -1400,7 +2579,7 @@ void audio::orchestra::api::Alsa::callbackEventOneCycleMMAPWrite() {
 				snd_pcm_uframes_t offset, frames;
 				frames = m_bufferSize;
 				ATA_DEBUG("START");
-				int err = snd_pcm_mmap_begin(m_private->handle, &myAreas, &offset, &frames);
+				int err = snd_pcm_mmap_begin(m_private->handle[0], &myAreas, &offset, &frames);
 				if (err < 0) {
 					ATA_CRITICAL("SUPER_FAIL");
 				}
@@ -1422,7 +2601,7 @@ void audio::orchestra::api::Alsa::callbackEventOneCycleMMAPWrite() {
 					result = m_bufferSize;
 				}
 				ATA_DEBUG("commit " << offset << " frame=" << frames);
-				int commitres = snd_pcm_mmap_commit(m_private->handle, offset, frames);
+				int commitres = snd_pcm_mmap_commit(m_private->handle[0], offset, frames);
 				if (    commitres < 0
 				     || (snd_pcm_uframes_t)commitres != frames) {
 					ATA_CRITICAL("MMAP commit error: " << snd_strerror(err));
@@ -1433,11 +2612,11 @@ void audio::orchestra::api::Alsa::callbackEventOneCycleMMAPWrite() {
 				for (int32_t i=0; i<channels; i++) {
 					bufs[i] = (void *) (buffer + (i * offset));
 				}
-				result = snd_pcm_writen(m_private->handle, bufs, m_bufferSize);
+				result = snd_pcm_writen(m_private->handle[0], bufs, m_bufferSize);
 			}
 		#endif
 		// Check stream latency
-		result = snd_pcm_delay(m_private->handle, &frames);
+		result = snd_pcm_delay(m_private->handle[0], &frames);
 		if (result == 0 && frames > 0) {
 			ATA_VERBOSE("Delay in the Output " << frames << " chunk");
 			m_latency[0] = frames;
@@ -1447,7 +2626,7 @@ void audio::orchestra::api::Alsa::callbackEventOneCycleMMAPWrite() {
 unlock:
 	audio::orchestra::Api::tickStreamTime();
 	if (doStopStream == 1) {
-		this->stopStream();
+		callbackStopStream();
 	}
 }
 void audio::orchestra::api::Alsa::callbackEventOneCycleMMAPRead() {
@@ -1459,9 +2638,13 @@ void audio::orchestra::api::Alsa::callbackEventOneCycleMMAPRead() {
 	int32_t doStopStream = 0;
 	audio::Time streamTime;
 	etk::Vector<enum audio::orchestra::status> status;
-	if (m_private->xrun[0] == true) {
-		status.pushBack(audio::orchestra::status::underflow);
-		m_private->xrun[0] = false;
+	if (m_private->xrun[1] == true) {
+		status.pushBack(audio::orchestra::status::overflow);
+		m_private->xrun[1] = false;
+	}
+	if (m_private->aggregateXrun == true) {
+		status.pushBack(audio::orchestra::status::overflow);
+		m_private->aggregateXrun = false;
 	}
 	int32_t result;
 	char *buffer;
@@ -1476,7 +2659,7 @@ void audio::orchestra::api::Alsa::callbackEventOneCycleMMAPRead() {
 		ethread::UniqueLock lck(m_mutex);
 		// Setup parameters.
 		if (m_doConvertBuffer[1]) {
-			buffer = m_deviceBuffer;
+			buffer = &m_deviceBuffer[0];
 			channels = m_nDeviceChannels[1];
 			format = m_deviceFormat[1];
 		} else {
@@ -1486,16 +2669,16 @@ void audio::orchestra::api::Alsa::callbackEventOneCycleMMAPRead() {
 		}
 		// Read samples from device in interleaved/non-interleaved format.
 		if (m_deviceInterleaved[1]) {
-			result = snd_pcm_mmap_readi(m_private->handle, buffer, m_bufferSize);
+			result = snd_pcm_mmap_readi(m_private->handle[1], buffer, m_bufferSize);
 		} else {
 			void *bufs[channels];
 			size_t offset = m_bufferSize * audio::getFormatBytes(format);
 			for (int32_t i=0; i<channels; i++)
 				bufs[i] = (void *) (buffer + (i * offset));
-			result = snd_pcm_mmap_readn(m_private->handle, bufs, m_bufferSize);
+			result = snd_pcm_mmap_readn(m_private->handle[1], bufs, m_bufferSize);
 		}
 		{
-			snd_pcm_state_t state = snd_pcm_state(m_private->handle);
+			snd_pcm_state_t state = snd_pcm_state(m_private->handle[1]);
 			ATA_VERBOSE("plop: " << state);
 			if (state == SND_PCM_STATE_XRUN) {
 				ATA_ERROR("Xrun...");
@@ -1508,17 +2691,17 @@ void audio::orchestra::api::Alsa::callbackEventOneCycleMMAPRead() {
 			}
 			// Either an error or overrun occured.
 			if (result == -EPIPE) {
-				snd_pcm_state_t state = snd_pcm_state(m_private->handle);
+				snd_pcm_state_t state = snd_pcm_state(m_private->handle[1]);
 				if (state == SND_PCM_STATE_XRUN) {
 					m_private->xrun[1] = true;
-					result = snd_pcm_prepare(m_private->handle);
+					result = snd_pcm_prepare(m_private->handle[1]);
 					if (result < 0) {
 						ATA_ERROR("error preparing device after overrun, " << snd_strerror(result) << ".");
 					}
 				} else {
 					ATA_ERROR("error, current state is " << snd_pcm_state_name(state) << ", " << snd_strerror(result) << ".");
 				}
-			} else {
+			} else if (checkDeviceLost(1, result) == false) {
 				ATA_ERROR("audio read error, " << snd_strerror(result) << ".");
 				ethread::sleepMilliSeconds((10));
 			}
@@ -1526,24 +2709,27 @@ void audio::orchestra::api::Alsa::callbackEventOneCycleMMAPRead() {
 			goto noInput;
 		}
 		// get timestamp : (to init here ...
-		streamTime = getStreamTime();
+		streamTime = updateStreamTime();
 		// Do byte swapping if necessary.
 		if (m_doByteSwap[1]) {
 			byteSwapBuffer(buffer, m_bufferSize * channels, format);
 		}
 		// Do buffer conversion if necessary.
 		if (m_doConvertBuffer[1]) {
-			convertBuffer(&m_userBuffer[1][0], m_deviceBuffer, m_convertInfo[1]);
+			convertBuffer(&m_userBuffer[1][0], &m_deviceBuffer[0], m_convertInfo[1]);
 		}
 		// Check stream latency
-		result = snd_pcm_delay(m_private->handle, &frames);
+		result = snd_pcm_delay(m_private->handle[1], &frames);
 		if (result == 0 && frames > 0) {
 			ATA_VERBOSE("Delay in the Input " << frames << " chunk");
 			m_latency[1] = frames;
 		}
 	}
+	// Get the channels of the aggregated devices.
+	aggregateRead();
+
 noInput:
-	streamTime = getStreamTime();
+	streamTime = updateStreamTime();
 	{
 		audio::Time startCall = audio::Time::now();
 		doStopStream = m_callback(&m_userBuffer[1][0],
@@ -1566,10 +2752,246 @@ noInput:
 unlock:
 	audio::orchestra::Api::tickStreamTime();
 	if (doStopStream == 1) {
-		this->stopStream();
+		callbackStopStream();
+	}
+}
+
+
+void audio::orchestra::api::Alsa::aggregateRead() {
+	for (size_t iii=0; iii<m_private->aggregate.size(); ++iii) {
+		if (m_private->aggregate[iii]->read(&m_userBuffer[1][0], m_bufferSize) == false) {
+			m_private->aggregateXrun = true;
+		}
+	}
+}
+
+void audio::orchestra::api::Alsa::aggregateWrite() {
+	for (size_t iii=0; iii<m_private->aggregate.size(); ++iii) {
+		if (m_private->aggregate[iii]->write(&m_userBuffer[0][0], m_bufferSize) == false) {
+			m_private->aggregateXrun = true;
+		}
+	}
+}
+
+void audio::orchestra::api::Alsa::duplexPrefill() {
+	// Fill the playback buffer with silence to have a constant delay between the capture and the playback.
+	char *buffer;
+	int32_t channels;
+	audio::format format;
+	if (m_doConvertBuffer[0]) {
+		buffer = &m_deviceBuffer[0];
+		channels = m_nDeviceChannels[0];
+		format = m_deviceFormat[0];
+	} else {
+		buffer = &m_userBuffer[0][0];
+		channels = m_nUserChannels[0];
+		format = m_userFormat;
+	}
+	memset(buffer, 0, m_bufferSize * channels * audio::getFormatBytes(format));
+	uint32_t nbPeriods = 1;
+	if (m_nBuffers > 2) {
+		nbPeriods = m_nBuffers - 1;
+	}
+	ATA_DEBUG("Prefill duplex playback with " << nbPeriods << " periods");
+	for (uint32_t iii=0; iii<nbPeriods; ++iii) {
+		int32_t result = writeDevice(buffer, channels, format);
+		if (result < int32_t(m_bufferSize)) {
+			ATA_ERROR("error in duplex prefill, " << snd_strerror(result) << ".");
+			break;
+		}
+	}
+	m_private->prefill = false;
+}
+
+int32_t audio::orchestra::api::Alsa::readDevice(char* _buffer, int32_t _channels, audio::format _format) {
+	snd_pcm_t* handle = m_private->handle[1];
+	// Read samples from device in interleaved/non-interleaved format.
+	if (m_deviceInterleaved[1]) {
+		if (m_private->mmapInterface[1] == true) {
+			return snd_pcm_mmap_readi(handle, _buffer, m_bufferSize);
+		}
+		return snd_pcm_readi(handle, _buffer, m_bufferSize);
+	}
+	void *bufs[_channels];
+	size_t offset = m_bufferSize * audio::getFormatBytes(_format);
+	for (int32_t iii=0; iii<_channels; ++iii) {
+		bufs[iii] = (void *) (_buffer + (iii * offset));
+	}
+	if (m_private->mmapInterface[1] == true) {
+		return snd_pcm_mmap_readn(handle, bufs, m_bufferSize);
+	}
+	return snd_pcm_readn(handle, bufs, m_bufferSize);
+}
+
+int32_t audio::orchestra::api::Alsa::writeDevice(char* _buffer, int32_t _channels, audio::format _format) {
+	snd_pcm_t* handle = m_private->handle[0];
+	// Write samples to device in interleaved/non-interleaved format.
+	if (m_deviceInterleaved[0]) {
+		if (m_private->mmapInterface[0] == true) {
+			return snd_pcm_mmap_writei(handle, _buffer, m_bufferSize);
+		}
+		return snd_pcm_writei(handle, _buffer, m_bufferSize);
+	}
+	void *bufs[_channels];
+	size_t offset = m_bufferSize * audio::getFormatBytes(_format);
+	for (int32_t iii=0; iii<_channels; ++iii) {
+		bufs[iii] = (void *) (_buffer + (iii * offset));
 	}
+	if (m_private->mmapInterface[0] == true) {
+		return snd_pcm_mmap_writen(handle, bufs, m_bufferSize);
+	}
+	return snd_pcm_writen(handle, bufs, m_bufferSize);
+}
+
+bool audio::orchestra::api::Alsa::recoverXrun(int32_t _idTable, int32_t _result) {
+	snd_pcm_t* handle = m_private->handle[_idTable];
+	if (checkDeviceLost(_idTable, _result) == true) {
+		// The IO thread reopen the device (no retry on the lost handle).
+		return true;
+	}
+	if (_result != -EPIPE) {
+		ATA_ERROR("audio " << (_idTable==0?"write":"read") << " error, " << snd_strerror(_result) << ".");
+		return false;
+	}
+	snd_pcm_state_t state = snd_pcm_state(handle);
+	if (state != SND_PCM_STATE_XRUN) {
+		ATA_ERROR("error, current state is " << snd_pcm_state_name(state) << ", " << snd_strerror(_result) << ".");
+		return false;
+	}
+	m_private->xrun[_idTable] = true;
+	// linked handles: the prepare is done on the 2 handles.
+	_result = snd_pcm_prepare(handle);
+	if (_result < 0) {
+		ATA_ERROR("error preparing device after xrun, " << snd_strerror(_result) << ".");
+		return false;
+	}
+	if (    m_private->linked == false
+	     && m_private->handle[1-_idTable] != null) {
+		snd_pcm_prepare(m_private->handle[1-_idTable]);
+	}
+	m_private->prefill = true;
+	return true;
 }
 
+void audio::orchestra::api::Alsa::callbackEventOneCycleDuplex() {
+	ATA_VERBOSE("One cycle duplex ...");
+	if (m_state == audio::orchestra::state::closed) {
+		ATA_CRITICAL("the stream is closed ... this shouldn't happen!");
+		return; // TODO : notify appl: audio::orchestra::error_warning;
+	}
+	int32_t doStopStream = 0;
+	audio::Time streamTime;
+	etk::Vector<enum audio::orchestra::status> status;
+	int32_t result;
+	char *buffer;
+	int32_t channels;
+	snd_pcm_sframes_t frames;
+	audio::format format;
+	if (m_private->prefill == true) {
+		ethread::UniqueLock lck(m_mutex);
+		duplexPrefill();
+	}
+	if (m_private->xrun[0] == true) {
+		status.pushBack(audio::orchestra::status::underflow);
+		m_private->xrun[0] = false;
+	}
+	if (m_private->xrun[1] == true) {
+		status.pushBack(audio::orchestra::status::overflow);
+		m_private->xrun[1] = false;
+	}
+	{
+		ethread::UniqueLock lck(m_mutex);
+		// Setup parameters.
+		if (m_doConvertBuffer[1]) {
+			buffer = &m_deviceBuffer[0];
+			channels = m_nDeviceChannels[1];
+			format = m_deviceFormat[1];
+		} else {
+			buffer = &m_userBuffer[1][0];
+			channels = m_nUserChannels[1];
+			format = m_userFormat;
+		}
+		result = readDevice(buffer, channels, format);
+		ATA_VERBOSE("get data :" << result << " request:" << int32_t(m_bufferSize));
+		if (result < int32_t(m_bufferSize)) {
+			// Either an error or overrun occured.
+			if (recoverXrun(1, result) == false) {
+				ethread::sleepMilliSeconds((10));
+			}
+			// Nothing to process, the playback will be prefilled at the next cycle.
+			return;
+		}
+		// Do byte swapping if necessary.
+		if (m_doByteSwap[1]) {
+			byteSwapBuffer(buffer, m_bufferSize * channels, format);
+		}
+		// Do buffer conversion if necessary.
+		if (m_doConvertBuffer[1]) {
+			convertBuffer(&m_userBuffer[1][0], &m_deviceBuffer[0], m_convertInfo[1]);
+		}
+		// Check stream latency
+		result = snd_pcm_delay(m_private->handle[1], &frames);
+		if (result == 0 && frames > 0) {
+			m_latency[1] = frames;
+		}
+	}
+	// The stream time is the playback time, the capture has been done before the full stream latency.
+	streamTime = updateStreamTime();
+	{
+		audio::Duration inputDelay(0, int64_t(m_latency[0]+m_latency[1])*1000000000LL/int64_t(m_sampleRate));
+		audio::Time startCall = audio::Time::now();
+		doStopStream = m_callback(&m_userBuffer[1][0],
+		                          streamTime - inputDelay,
+		                          &m_userBuffer[0][0],
+		                          streamTime,
+		                          m_bufferSize,
+		                          status);
+		audio::Time stopCall = audio::Time::now();
+		audio::Duration timeDelay(0, m_bufferSize*1000000000LL/int64_t(m_sampleRate));
+		audio::Duration timeProcess = stopCall - startCall;
+		if (timeDelay <= timeProcess) {
+			ATA_ERROR("SOFT XRUN ... : (bufferTime) " << timeDelay << " < " << timeProcess << " (process time)");
+		}
+	}
+	if (doStopStream == 2) {
+		abortStream();
+		return;
+	}
+	{
+		ethread::UniqueLock lck(m_mutex);
+		// Setup parameters and do buffer conversion if necessary.
+		if (m_doConvertBuffer[0]) {
+			buffer = &m_deviceBuffer[0];
+			convertBuffer(buffer, &m_userBuffer[0][0], m_convertInfo[0]);
+			channels = m_nDeviceChannels[0];
+			format = m_deviceFormat[0];
+		} else {
+			buffer = &m_userBuffer[0][0];
+			channels = m_nUserChannels[0];
+			format = m_userFormat;
+		}
+		// Do byte swapping if necessary.
+		if (m_doByteSwap[0]) {
+			byteSwapBuffer(buffer, m_bufferSize * channels, format);
+		}
+		result = writeDevice(buffer, channels, format);
+		if (result < int32_t(m_bufferSize)) {
+			// Either an error or underrun occured.
+			recoverXrun(0, result);
+			goto unlock;
+		}
+		// Check stream latency
+		result = snd_pcm_delay(m_private->handle[0], &frames);
+		if (result == 0 && frames > 0) {
+			m_latency[0] = frames;
+		}
+	}
+unlock:
+	audio::orchestra::Api::tickStreamTime();
+	if (doStopStream == 1) {
+		callbackStopStream();
+	}
+}
 
 bool audio::orchestra::api::Alsa::isMasterOf(ememory::SharedPtr<audio::orchestra::Api> _api) {
 	ememory::SharedPtr<audio::orchestra::api::Alsa> slave = ememory::dynamicPointerCast<audio::orchestra::api::Alsa>(_api);
@@ -1585,16 +3007,21 @@ bool audio::orchestra::api::Alsa::isMasterOf(ememory::SharedPtr<audio::orchestra
 		ATA_ERROR("The SLAVE stream is already running! ==> can not synchronize ...");
 		return false;
 	}
-	snd_pcm_t * master = null;
-	if (m_private->handle != null) {
-		master = m_private->handle;
-	}
+	snd_pcm_t * master = m_private->handle[0];
 	if (master == null) {
+		master = m_private->handle[1];
+	}
+	snd_pcm_t * slaveHandle = slave->m_private->handle[0];
+	if (slaveHandle == null) {
+		slaveHandle = slave->m_private->handle[1];
+	}
+	if (    master == null
+	     || slaveHandle == null) {
 		ATA_ERROR("No ALSA handles ...");
 		return false;
 	}
 	ATA_INFO("   ==> plop");
-	if (snd_pcm_link(master, slave->m_private->handle) != 0) {
+	if (snd_pcm_link(master, slaveHandle) != 0) {
 		ATA_ERROR("Can not syncronize handle output");
 	} else {
 		ATA_INFO("   -------------------- LINK 0 --------------------");
@@ -1602,5 +3029,23 @@ bool audio::orchestra::api::Alsa::isMasterOf(ememory::SharedPtr<audio::orchestra
 	return true;
 }
 
+bool audio::orchestra::api::Alsa::startDeviceMonitor(audio::orchestra::DeviceEventCallback _callback) {
+	stopDeviceMonitor();
+	ememory::SharedPtr<audio::orchestra::api::AlsaMonitor> monitor = ememory::makeShared<audio::orchestra::api::AlsaMonitor>();
+	if (    monitor == null
+	     || monitor->start(_callback) == false) {
+		return false;
+	}
+	m_private->monitor = monitor;
+	return true;
+}
+
+void audio::orchestra::api::Alsa::stopDeviceMonitor() {
+	if (m_private->monitor == null) {
+		return;
+	}
+	m_private->monitor->stop();
+	m_private->monitor.reset();
+}
 
 #endif
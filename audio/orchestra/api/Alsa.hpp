@@ -8,10 +8,13 @@
 
 #ifdef ORCHESTRA_BUILD_ALSA
 
+struct pollfd;
+
 namespace audio {
 	namespace orchestra {
 		namespace api {
 			class AlsaPrivate;
+			class AlsaTimestamp;
 			class Alsa: public audio::orchestra::Api {
 				public:
 					static ememory::SharedPtr<audio::orchestra::Api> create();
@@ -47,10 +50,117 @@ namespace audio {
 					void callbackEventOneCycleWrite();
 					void callbackEventOneCycleMMAPRead();
 					void callbackEventOneCycleMMAPWrite();
+					void callbackEventOneCycleDuplex();
+					/**
+					 * @brief Process one chunk of a single direction stream (read or write).
+					 */
+					void callbackEventOneCycle();
+					/**
+					 * @brief Process the periods of the stream after a wakeup (all the availlable periods in catch up mode).
+					 */
+					void callbackEventAvailable();
+					/**
+					 * @brief IO loop of the timer scheduling mode (wakeup with a timer, process all the availlable chunks).
+					 */
+					void callbackEventTimer();
+					/**
+					 * @brief Shared IO engine: check if the stream must be polled (running and not stalled).
+					 */
+					bool engineIsActive();
+					/**
+					 * @brief Shared IO engine: add the poll descriptors of the stream (start the capture if needed).
+					 * @param[in,out] _ufds Poll set of the engine.
+					 * @return Number of descriptors added.
+					 */
+					int32_t engineGetPollDescriptors(etk::Vector<struct pollfd>& _ufds);
+					/**
+					 * @brief Shared IO engine: process the period of the stream if its descriptors are ready.
+					 * @param[in] _ufds Descriptors of the stream (set by engineGetPollDescriptors).
+					 * @param[in] _count Number of descriptors.
+					 */
+					void engineProcess(struct pollfd* _ufds, int32_t _count);
+					/**
+					 * @brief Shared IO engine: check the watchdog of the stream.
+					 * @param[in] _now Current time.
+					 * @return Time before the next check (ms) or -1 if the stream is not polled.
+					 */
+					int32_t engineWatchdog(const audio::Time& _now);
+					/**
+					 * @brief Shared IO engine: check (and clear) the stop requested by the callback.
+					 * @return true if the stream must be stopped by the stop thread.
+					 */
+					bool engineStopPending();
+					/**
+					 * @brief Shared IO engine: stop the stream requested by the callback (drain out of the IO thread).
+					 */
+					void engineStop();
+				private:
+					/**
+					 * @brief Stop the stream at the request of the callback.
+					 * @note With the shared engine, the stream is only marked stopping: the drain is done by the stop thread.
+					 */
+					void callbackStopStream();
+					/**
+					 * @brief Start the capture when it is prepared (the shared engine does not read before the poll).
+					 * @note Must be called with m_mutex locked.
+					 */
+					void engineStartCapture();
+					/**
+					 * @brief Adapt the safety margin of the timer scheduling mode.
+					 * @param[in] _xrun An xrun has been detected.
+					 */
+					void timerWatermarkUpdate(bool _xrun);
+					/**
+					 * @brief Wake up the IO thread blocked in poll (start, stop and close request).
+					 */
+					void wakeUpThread();
+					/**
+					 * @brief Restart the device when the watchdog detect that no period came during too long.
+					 * @return false if the device is definitively stalled.
+					 */
+					bool watchdogRestart();
+				private:
+					/**
+					 * @brief Read one period on the capture handle (interleaved or not, mmap or not).
+					 * @return Number of frame read or a negative alsa error.
+					 */
+					int32_t readDevice(char* _buffer, int32_t _channels, audio::format _format);
+					/**
+					 * @brief Write one period on the playback handle (interleaved or not, mmap or not).
+					 * @return Number of frame written or a negative alsa error.
+					 */
+					int32_t writeDevice(char* _buffer, int32_t _channels, audio::format _format);
+					/**
+					 * @brief Restart the handles after an Xrun (duplex mode).
+					 * @param[in] _idTable Handle that fail (0 playback, 1 capture).
+					 * @param[in] _result Error returned by the read/write.
+					 * @return true if the stream can continue.
+					 */
+					bool recoverXrun(int32_t _idTable, int32_t _result);
+					/**
+					 * @brief Check if an error come from a device that is unplugged.
+					 * @param[in] _idTable Direction of the device (0: playback, 1: capture).
+					 * @param[in] _result Error returned by the device.
+					 * @return true if the device is lost (the IO thread reopen it, see reconnect).
+					 */
+					bool checkDeviceLost(int32_t _idTable, int32_t _result);
+					/**
+					 * @brief Reopen the lost devices with the same configuration (IO thread only, StreamOptions::reconnect).
+					 * The lost device is tried first, then the fallback devices, until StreamOptions::reconnectTimeout. The
+					 * buffers, the converters and the IO thread of the stream are kept, the gap is given to the callback as silence.
+					 * @return false if the stream is dead (no reconnection requested or no device found).
+					 */
+					bool reconnect();
+					/**
+					 * @brief Fill the playback buffer with silence (fixed capture to playback delay).
+					 */
+					void duplexPrefill();
 				private:
 					ememory::SharedPtr<AlsaPrivate> m_private;
 					etk::Vector<audio::orchestra::DeviceInfo> m_devices;
 					void saveDeviceInfo();
+					void prepareOpen(enum audio::orchestra::mode _mode, const audio::orchestra::StreamParameters& _params);
+					void releasePrepareOpen();
 					bool open(uint32_t _device,
 					          enum audio::orchestra::mode _mode,
 					          uint32_t _channels,
@@ -68,9 +178,45 @@ namespace audio {
 					              audio::format _format,
 					              uint32_t *_bufferSize,
 					              const audio::orchestra::StreamOptions& _options);
+					/**
+					 * @brief Open one device (openName open the aggregated devices around it).
+					 */
+					bool openDevice(const etk::String& _deviceName,
+					                audio::orchestra::mode _mode,
+					                uint32_t _channels,
+					                uint32_t _firstChannel,
+					                uint32_t _sampleRate,
+					                audio::format _format,
+					                uint32_t *_bufferSize,
+					                const audio::orchestra::StreamOptions& _options);
+					/**
+					 * @brief Get the channels of the aggregated capture devices in the user buffer.
+					 */
+					void aggregateRead();
+					/**
+					 * @brief Send the channels of the user buffer to the aggregated playback devices.
+					 */
+					void aggregateWrite();
+					/**
+					 * @brief Get the time of the stream at the last period (no system call in the hardware timestamp mode).
+					 */
 					virtual audio::Time getStreamTime();
+					/**
+					 * @brief Read the time of the stream on the device (snd_pcm_status).
+					 * @param[out] _timestamp Hardware time of the stream (can be null).
+					 */
+					audio::Time readStreamTime(audio::orchestra::api::AlsaTimestamp* _timestamp = null);
+					/**
+					 * @brief Read the time of the stream and publish it for the other threads (IO thread only).
+					 */
+					audio::Time updateStreamTime();
 				public:
 					bool isMasterOf(ememory::SharedPtr<audio::orchestra::Api> _api);
+					bool isAggregateSupported() {
+						return true;
+					}
+					bool startDeviceMonitor(audio::orchestra::DeviceEventCallback _callback);
+					void stopDeviceMonitor();
 			};
 		}
 	}
@@ -0,0 +1,546 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license APACHE v2.0 (see license file)
+ */
+
+#if defined(ORCHESTRA_BUILD_ALSA)
+
+#include <audio/orchestra/api/AlsaAggregate.hpp>
+#include <audio/orchestra/debug.hpp>
+extern "C" {
+	#include <errno.h>
+	#include <string.h>
+	#include <time.h>
+	#include <limits.h>
+}
+
+// Drift controller parameters (the error is in frames):
+static const double driftFilter = 0.05; //!< low pass filter on the measured fill level
+static const double driftProportional = 2.0e-6; //!< 100 frames of error ==> 200 ppm of correction
+static const double driftIntegral = 2.0e-9; //!< slow correction of the static clock offset
+static const double driftMaxCorrection = 0.005; //!< max correction of the rate (5000 ppm)
+
+static uint32_t minFrames(uint32_t _val1, uint32_t _val2) {
+	return _val1 < _val2 ? _val1 : _val2;
+}
+
+static uint32_t maxFrames(uint32_t _val1, uint32_t _val2) {
+	return _val1 > _val2 ? _val1 : _val2;
+}
+
+static float convertInt16ToFloat(int16_t _value) {
+	return float(_value) * (1.0f/32768.0f);
+}
+
+static float convertInt32ToFloat(int32_t _value) {
+	return float(double(_value) * (1.0/2147483648.0));
+}
+
+static int16_t convertFloatToInt16(float _value) {
+	if (_value >= 1.0f) {
+		return INT16_MAX;
+	}
+	if (_value <= -1.0f) {
+		return INT16_MIN;
+	}
+	return int16_t(_value * 32768.0f);
+}
+
+static int32_t convertFloatToInt32(float _value) {
+	if (_value >= 1.0f) {
+		return INT32_MAX;
+	}
+	if (_value <= -1.0f) {
+		return INT32_MIN;
+	}
+	return int32_t(double(_value) * 2147483648.0);
+}
+
+audio::orchestra::api::AlsaAggregate::AlsaAggregate() :
+  m_handle(null),
+  m_mode(audio::orchestra::mode_unknow),
+  m_sampleRate(0),
+  m_bufferSize(0),
+  m_nbChannels(0),
+  m_deviceFormat(SND_PCM_FORMAT_UNKNOWN),
+  m_userFormat(audio::format_unknow),
+  m_nbUserChannels(0),
+  m_firstUserChannel(0),
+  m_fifoRead(0),
+  m_fifoSize(0),
+  m_fifoCapacity(0),
+  m_primed(false),
+  m_step(1.0),
+  m_position(0.0),
+  m_target(0.0),
+  m_errorFiltered(0.0),
+  m_errorIntegral(0.0) {
+
+}
+
+audio::orchestra::api::AlsaAggregate::~AlsaAggregate() {
+	close();
+}
+
+bool audio::orchestra::api::AlsaAggregate::open(const etk::String& _deviceName,
+                                                enum audio::orchestra::mode _mode,
+                                                uint32_t _sampleRate,
+                                                uint32_t _bufferSize) {
+	ATA_DEBUG("Open aggregated ALSA device: '" << _deviceName << "' mode=" << _mode);
+	m_name = _deviceName;
+	m_mode = _mode;
+	snd_pcm_stream_t stream = SND_PCM_STREAM_CAPTURE;
+	if (_mode == audio::orchestra::mode_output) {
+		stream = SND_PCM_STREAM_PLAYBACK;
+	}
+	// The card is not the clock master ==> never block the IO thread on it.
+	int32_t result = snd_pcm_open(&m_handle, _deviceName.c_str(), stream, SND_PCM_NONBLOCK);
+	if (result < 0) {
+		ATA_ERROR("aggregated pcm device (" << _deviceName << ") won't open: " << snd_strerror(result) << ".");
+		m_handle = null;
+		return false;
+	}
+	snd_pcm_hw_params_t *hwParams;
+	snd_pcm_hw_params_alloca(&hwParams);
+	result = snd_pcm_hw_params_any(m_handle, hwParams);
+	if (result < 0) {
+		ATA_ERROR("error getting pcm device (" << _deviceName << ") parameters, " << snd_strerror(result) << ".");
+		goto error;
+	}
+	result = snd_pcm_hw_params_set_access(m_handle, hwParams, SND_PCM_ACCESS_RW_INTERLEAVED);
+	if (result < 0) {
+		ATA_ERROR("error setting pcm device (" << _deviceName << ") access, " << snd_strerror(result) << ".");
+		goto error;
+	}
+	// Select the best format, the samples are processed in float.
+	if (snd_pcm_hw_params_test_format(m_handle, hwParams, SND_PCM_FORMAT_FLOAT) == 0) {
+		m_deviceFormat = SND_PCM_FORMAT_FLOAT;
+	} else if (snd_pcm_hw_params_test_format(m_handle, hwParams, SND_PCM_FORMAT_S32) == 0) {
+		m_deviceFormat = SND_PCM_FORMAT_S32;
+	} else if (snd_pcm_hw_params_test_format(m_handle, hwParams, SND_PCM_FORMAT_S16) == 0) {
+		m_deviceFormat = SND_PCM_FORMAT_S16;
+	} else {
+		ATA_ERROR("pcm device (" << _deviceName << ") has no float/int32/int16 format (use a 'plug:' device).");
+		goto error;
+	}
+	result = snd_pcm_hw_params_set_format(m_handle, hwParams, m_deviceFormat);
+	if (result < 0) {
+		ATA_ERROR("error setting pcm device (" << _deviceName << ") data format, " << snd_strerror(result) << ".");
+		goto error;
+	}
+	{
+		uint32_t channels = 0;
+		result = snd_pcm_hw_params_get_channels_max(hwParams, &channels);
+		if (result < 0) {
+			ATA_ERROR("error getting channels of device (" << _deviceName << "), " << snd_strerror(result) << ".");
+			goto error;
+		}
+		result = snd_pcm_hw_params_set_channels(m_handle, hwParams, channels);
+		if (result < 0) {
+			ATA_ERROR("error setting " << channels << " channels for device (" << _deviceName << "), " << snd_strerror(result) << ".");
+			goto error;
+		}
+		m_nbChannels = channels;
+	}
+	// The nominal rate must be the same, only the drift is compensated.
+	result = snd_pcm_hw_params_set_rate(m_handle, hwParams, _sampleRate, 0);
+	if (result < 0) {
+		ATA_ERROR("aggregated device (" << _deviceName << ") does not support the rate " << _sampleRate << ", " << snd_strerror(result) << ".");
+		goto error;
+	}
+	m_sampleRate = _sampleRate;
+	{
+		int32_t dir = 0;
+		snd_pcm_uframes_t periodSize = _bufferSize;
+		result = snd_pcm_hw_params_set_period_size_near(m_handle, hwParams, &periodSize, &dir);
+		if (result < 0) {
+			ATA_ERROR("error setting period size for device (" << _deviceName << "), " << snd_strerror(result) << ".");
+			goto error;
+		}
+		m_bufferSize = periodSize;
+		uint32_t periods = 4;
+		result = snd_pcm_hw_params_set_periods_near(m_handle, hwParams, &periods, &dir);
+		if (result < 0) {
+			ATA_ERROR("error setting periods for device (" << _deviceName << "), " << snd_strerror(result) << ".");
+			goto error;
+		}
+	}
+	result = snd_pcm_hw_params(m_handle, hwParams);
+	if (result < 0) {
+		ATA_ERROR("error installing hardware configuration on device (" << _deviceName << "), " << snd_strerror(result) << ".");
+		goto error;
+	}
+	// Keep 2 periods of the master in the card (FIFO + hardware).
+	m_target = 2.0 * maxFrames(m_bufferSize, _bufferSize);
+	{
+		snd_pcm_sw_params_t *swParams = null;
+		snd_pcm_sw_params_alloca(&swParams);
+		snd_pcm_sw_params_current(m_handle, swParams);
+		if (_mode == audio::orchestra::mode_output) {
+			// start automaticly when the target level is reached.
+			snd_pcm_sw_params_set_start_threshold(m_handle, swParams, snd_pcm_uframes_t(m_target));
+		}
+		snd_pcm_sw_params_set_stop_threshold(m_handle, swParams, ULONG_MAX);
+		snd_pcm_sw_params_set_avail_min(m_handle, swParams, m_bufferSize);
+		// Timestamps on the same clock than the IO thread to correct the delay.
+		snd_pcm_sw_params_set_tstamp_mode(m_handle, swParams, SND_PCM_TSTAMP_ENABLE);
+		if (snd_pcm_sw_params_set_tstamp_type(m_handle, swParams, SND_PCM_TSTAMP_TYPE_MONOTONIC) < 0) {
+			ATA_WARNING("aggregated device (" << _deviceName << ") has no monotonic timestamp (less precise drift)");
+		}
+		result = snd_pcm_sw_params(m_handle, swParams);
+		if (result < 0) {
+			ATA_ERROR("error installing software configuration on device (" << _deviceName << "), " << snd_strerror(result) << ".");
+			goto error;
+		}
+	}
+	ATA_INFO("Aggregated device '" << _deviceName << "' channels=" << m_nbChannels << " period=" << m_bufferSize);
+	return true;
+error:
+	close();
+	return false;
+}
+
+void audio::orchestra::api::AlsaAggregate::close() {
+	if (m_handle == null) {
+		return;
+	}
+	snd_pcm_drop(m_handle);
+	snd_pcm_close(m_handle);
+	m_handle = null;
+}
+
+bool audio::orchestra::api::AlsaAggregate::setUserChannels(enum audio::format _format,
+                                                           uint32_t _nbUserChannels,
+                                                           uint32_t _firstUserChannel,
+                                                           uint32_t _bufferSize) {
+	if (    _format != audio::format_int16
+	     && _format != audio::format_int32
+	     && _format != audio::format_float
+	     && _format != audio::format_double) {
+		ATA_ERROR("aggregated device does not support the user format: " << _format);
+		return false;
+	}
+	m_userFormat = _format;
+	m_nbUserChannels = _nbUserChannels;
+	m_firstUserChannel = _firstUserChannel;
+	// Allocate all the buffers here (never in the IO thread).
+	uint32_t nbFramesMax = maxFrames(_bufferSize, m_bufferSize) * 2;
+	m_target = 2.0 * maxFrames(m_bufferSize, _bufferSize);
+	m_fifoCapacity = nbFramesMax * 4;
+	m_fifo.resize(m_fifoCapacity * m_nbChannels, 0.0f);
+	m_fifoRead = 0;
+	m_fifoSize = 0;
+	m_history.resize(m_nbChannels, 0.0f);
+	m_input.resize(nbFramesMax * m_nbChannels, 0.0f);
+	// the step can not be lower than (1-driftMaxCorrection)
+	m_output.resize((nbFramesMax * 2 + 4) * m_nbChannels, 0.0f);
+	m_deviceBuffer.resize(nbFramesMax * m_nbChannels * snd_pcm_format_physical_width(m_deviceFormat) / 8, 0);
+	return true;
+}
+
+bool audio::orchestra::api::AlsaAggregate::start() {
+	if (m_handle == null) {
+		return false;
+	}
+	m_fifoRead = 0;
+	m_fifoSize = 0;
+	m_primed = false;
+	m_position = 0.0;
+	for (size_t iii=0; iii<m_history.size(); ++iii) {
+		m_history[iii] = 0.0f;
+	}
+	// Keep the last rate ratio (the clocks does not change), but restart the filter.
+	m_errorFiltered = 0.0;
+	int32_t result = snd_pcm_prepare(m_handle);
+	if (result < 0) {
+		ATA_ERROR("error preparing aggregated device (" << m_name << "), " << snd_strerror(result) << ".");
+		return false;
+	}
+	if (m_mode == audio::orchestra::mode_input) {
+		result = snd_pcm_start(m_handle);
+		if (result < 0) {
+			ATA_ERROR("error starting aggregated device (" << m_name << "), " << snd_strerror(result) << ".");
+			return false;
+		}
+	}
+	return true;
+}
+
+void audio::orchestra::api::AlsaAggregate::stop() {
+	if (m_handle == null) {
+		return;
+	}
+	snd_pcm_drop(m_handle);
+}
+
+void audio::orchestra::api::AlsaAggregate::fifoPush(const float* _data, uint32_t _nbFrames) {
+	if (_nbFrames > m_fifoCapacity - m_fifoSize) {
+		// Overflow: drop the oldest frames.
+		uint32_t drop = _nbFrames - (m_fifoCapacity - m_fifoSize);
+		ATA_WARNING("aggregated device (" << m_name << ") FIFO overflow: drop " << drop << " frames");
+		m_fifoRead = (m_fifoRead + drop) % m_fifoCapacity;
+		m_fifoSize -= minFrames(drop, m_fifoSize);
+	}
+	uint32_t write = (m_fifoRead + m_fifoSize) % m_fifoCapacity;
+	for (uint32_t iii=0; iii<_nbFrames; ++iii) {
+		memcpy(&m_fifo[write * m_nbChannels], &_data[iii * m_nbChannels], m_nbChannels * sizeof(float));
+		write = (write + 1) % m_fifoCapacity;
+	}
+	m_fifoSize += _nbFrames;
+}
+
+uint32_t audio::orchestra::api::AlsaAggregate::fifoPop(float* _data, uint32_t _nbFrames) {
+	uint32_t nbFrames = minFrames(_nbFrames, m_fifoSize);
+	for (uint32_t iii=0; iii<nbFrames; ++iii) {
+		memcpy(&_data[iii * m_nbChannels], &m_fifo[m_fifoRead * m_nbChannels], m_nbChannels * sizeof(float));
+		m_fifoRead = (m_fifoRead + 1) % m_fifoCapacity;
+	}
+	m_fifoSize -= nbFrames;
+	return nbFrames;
+}
+
+uint32_t audio::orchestra::api::AlsaAggregate::resample(const float* _input, uint32_t _nbFrames, float* _output) {
+	// Linear interpolation between the last frame of the previous call (position 0) and the new frames.
+	uint32_t nbOutput = 0;
+	double position = m_position;
+	while (position < double(_nbFrames)) {
+		int32_t index = int32_t(position);
+		float fraction = float(position - double(index));
+		const float* previous = &m_history[0];
+		if (index > 0) {
+			previous = &_input[(index-1) * m_nbChannels];
+		}
+		const float* next = &_input[index * m_nbChannels];
+		for (uint32_t ccc=0; ccc<m_nbChannels; ++ccc) {
+			_output[ccc] = previous[ccc] + (next[ccc] - previous[ccc]) * fraction;
+		}
+		_output += m_nbChannels;
+		++nbOutput;
+		position += m_step;
+	}
+	m_position = position - double(_nbFrames);
+	if (_nbFrames > 0) {
+		memcpy(&m_history[0], &_input[(_nbFrames-1) * m_nbChannels], m_nbChannels * sizeof(float));
+	}
+	return nbOutput;
+}
+
+void audio::orchestra::api::AlsaAggregate::updateDrift() {
+	snd_pcm_status_t *status = null;
+	snd_pcm_status_alloca(&status);
+	if (snd_pcm_status(m_handle, status) < 0) {
+		return;
+	}
+	if (snd_pcm_status_get_state(status) != SND_PCM_STATE_RUNNING) {
+		return;
+	}
+	// Number of frame in the card when the status has been captured.
+	double fill = snd_pcm_status_get_delay(status);
+	// Correct it with the time elapsed since the status timestamp.
+	snd_htimestamp_t timestamp;
+	snd_pcm_status_get_htstamp(status, &timestamp);
+	if (    timestamp.tv_sec != 0
+	     || timestamp.tv_nsec != 0) {
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		double elapsed = double(now.tv_sec - timestamp.tv_sec) + double(now.tv_nsec - timestamp.tv_nsec) * 0.000000001;
+		if (    elapsed > 0.0
+		     && elapsed < 0.1) {
+			if (m_mode == audio::orchestra::mode_output) {
+				fill -= elapsed * double(m_sampleRate);
+			} else {
+				fill += elapsed * double(m_sampleRate);
+			}
+		}
+	}
+	fill += double(m_fifoSize);
+	// PI controller: a too high level ==> consume more input frames for each output frame.
+	double error = fill - m_target;
+	m_errorFiltered += driftFilter * (error - m_errorFiltered);
+	m_errorIntegral += m_errorFiltered;
+	double integralMax = driftMaxCorrection / driftIntegral;
+	if (m_errorIntegral > integralMax) {
+		m_errorIntegral = integralMax;
+	} else if (m_errorIntegral < -integralMax) {
+		m_errorIntegral = -integralMax;
+	}
+	double correction = driftProportional * m_errorFiltered + driftIntegral * m_errorIntegral;
+	if (correction > driftMaxCorrection) {
+		correction = driftMaxCorrection;
+	} else if (correction < -driftMaxCorrection) {
+		correction = -driftMaxCorrection;
+	}
+	m_step = 1.0 + correction;
+	ATA_VERBOSE("aggregated device (" << m_name << ") fill=" << fill << " ratio=" << getRatio());
+}
+
+bool audio::orchestra::api::AlsaAggregate::recover(int32_t _error) {
+	if (_error == -EAGAIN) {
+		return true;
+	}
+	if (    _error != -EPIPE
+	     && _error != -ESTRPIPE) {
+		ATA_ERROR("aggregated device (" << m_name << ") error, " << snd_strerror(_error) << ".");
+		return false;
+	}
+	ATA_WARNING("aggregated device (" << m_name << ") xrun");
+	int32_t result = snd_pcm_prepare(m_handle);
+	if (result < 0) {
+		ATA_ERROR("error preparing aggregated device after xrun, " << snd_strerror(result) << ".");
+		return false;
+	}
+	if (m_mode == audio::orchestra::mode_input) {
+		m_primed = false;
+		snd_pcm_start(m_handle);
+	}
+	return false;
+}
+
+bool audio::orchestra::api::AlsaAggregate::write(const char* _userBuffer, uint32_t _nbFrames) {
+	if (m_handle == null) {
+		return false;
+	}
+	updateDrift();
+	// Extract our channels from the user buffer.
+	for (uint32_t iii=0; iii<_nbFrames; ++iii) {
+		float* out = &m_input[iii * m_nbChannels];
+		uint32_t offset = iii * m_nbUserChannels + m_firstUserChannel;
+		for (uint32_t ccc=0; ccc<m_nbChannels; ++ccc) {
+			switch (m_userFormat) {
+				case audio::format_int16:
+					out[ccc] = convertInt16ToFloat(reinterpret_cast<const int16_t*>(_userBuffer)[offset + ccc]);
+					break;
+				case audio::format_int32:
+					out[ccc] = convertInt32ToFloat(reinterpret_cast<const int32_t*>(_userBuffer)[offset + ccc]);
+					break;
+				case audio::format_float:
+					out[ccc] = reinterpret_cast<const float*>(_userBuffer)[offset + ccc];
+					break;
+				case audio::format_double:
+					out[ccc] = float(reinterpret_cast<const double*>(_userBuffer)[offset + ccc]);
+					break;
+				default:
+					out[ccc] = 0.0f;
+					break;
+			}
+		}
+	}
+	fifoPush(&m_output[0], resample(&m_input[0], _nbFrames, &m_output[0]));
+	// Send all that the card can accept.
+	bool ret = true;
+	snd_pcm_sframes_t avail = snd_pcm_avail_update(m_handle);
+	if (avail < 0) {
+		return recover(avail);
+	}
+	uint32_t maxChunk = m_input.size() / m_nbChannels;
+	while (    avail > 0
+	        && m_fifoSize > 0) {
+		uint32_t nbFrames = fifoPop(&m_input[0], minFrames(uint32_t(avail), maxChunk));
+		uint32_t nbSamples = nbFrames * m_nbChannels;
+		if (m_deviceFormat == SND_PCM_FORMAT_FLOAT) {
+			memcpy(&m_deviceBuffer[0], &m_input[0], nbSamples * sizeof(float));
+		} else if (m_deviceFormat == SND_PCM_FORMAT_S32) {
+			int32_t* out = reinterpret_cast<int32_t*>(&m_deviceBuffer[0]);
+			for (uint32_t iii=0; iii<nbSamples; ++iii) {
+				out[iii] = convertFloatToInt32(m_input[iii]);
+			}
+		} else {
+			int16_t* out = reinterpret_cast<int16_t*>(&m_deviceBuffer[0]);
+			for (uint32_t iii=0; iii<nbSamples; ++iii) {
+				out[iii] = convertFloatToInt16(m_input[iii]);
+			}
+		}
+		snd_pcm_sframes_t result = snd_pcm_writei(m_handle, &m_deviceBuffer[0], nbFrames);
+		if (result < 0) {
+			ret = recover(result);
+			break;
+		}
+		avail -= nbFrames;
+	}
+	return ret;
+}
+
+bool audio::orchestra::api::AlsaAggregate::read(char* _userBuffer, uint32_t _nbFrames) {
+	if (m_handle == null) {
+		return false;
+	}
+	bool ret = true;
+	updateDrift();
+	// Get all that the card has captured.
+	snd_pcm_sframes_t avail = snd_pcm_avail_update(m_handle);
+	if (avail < 0) {
+		ret = recover(avail);
+		avail = 0;
+	}
+	uint32_t maxChunk = m_input.size() / m_nbChannels;
+	while (avail > 0) {
+		uint32_t nbFrames = minFrames(uint32_t(avail), maxChunk);
+		snd_pcm_sframes_t result = snd_pcm_readi(m_handle, &m_deviceBuffer[0], nbFrames);
+		if (result < 0) {
+			ret = recover(result);
+			break;
+		}
+		nbFrames = result;
+		uint32_t nbSamples = nbFrames * m_nbChannels;
+		if (m_deviceFormat == SND_PCM_FORMAT_FLOAT) {
+			memcpy(&m_input[0], &m_deviceBuffer[0], nbSamples * sizeof(float));
+		} else if (m_deviceFormat == SND_PCM_FORMAT_S32) {
+			const int32_t* in = reinterpret_cast<const int32_t*>(&m_deviceBuffer[0]);
+			for (uint32_t iii=0; iii<nbSamples; ++iii) {
+				m_input[iii] = convertInt32ToFloat(in[iii]);
+			}
+		} else {
+			const int16_t* in = reinterpret_cast<const int16_t*>(&m_deviceBuffer[0]);
+			for (uint32_t iii=0; iii<nbSamples; ++iii) {
+				m_input[iii] = convertInt16ToFloat(in[iii]);
+			}
+		}
+		fifoPush(&m_output[0], resample(&m_input[0], nbFrames, &m_output[0]));
+		avail -= nbFrames;
+	}
+	// Wait to have the target level before providing data.
+	uint32_t nbFrames = 0;
+	if (m_primed == false) {
+		if (m_fifoSize >= uint32_t(m_target)) {
+			m_primed = true;
+		}
+	}
+	if (m_primed == true) {
+		nbFrames = fifoPop(&m_output[0], _nbFrames);
+		if (nbFrames < _nbFrames) {
+			ATA_WARNING("aggregated device (" << m_name << ") FIFO underflow: " << nbFrames << "/" << _nbFrames);
+			m_primed = false;
+			ret = false;
+		}
+	}
+	// Set our channels in the user buffer (silence for the missing frames).
+	for (uint32_t iii=0; iii<_nbFrames; ++iii) {
+		uint32_t offset = iii * m_nbUserChannels + m_firstUserChannel;
+		for (uint32_t ccc=0; ccc<m_nbChannels; ++ccc) {
+			float value = 0.0f;
+			if (iii < nbFrames) {
+				value = m_output[iii * m_nbChannels + ccc];
+			}
+			switch (m_userFormat) {
+				case audio::format_int16:
+					reinterpret_cast<int16_t*>(_userBuffer)[offset + ccc] = convertFloatToInt16(value);
+					break;
+				case audio::format_int32:
+					reinterpret_cast<int32_t*>(_userBuffer)[offset + ccc] = convertFloatToInt32(value);
+					break;
+				case audio::format_float:
+					reinterpret_cast<float*>(_userBuffer)[offset + ccc] = value;
+					break;
+				case audio::format_double:
+					reinterpret_cast<double*>(_userBuffer)[offset + ccc] = value;
+					break;
+				default:
+					break;
+			}
+		}
+	}
+	return ret;
+}
+
+#endif
@@ -0,0 +1,127 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license APACHE v2.0 (see license file)
+ */
+#pragma once
+#ifdef ORCHESTRA_BUILD_ALSA
+
+#include <alsa/asoundlib.h>
+#include <etk/types.hpp>
+#include <etk/String.hpp>
+#include <etk/Vector.hpp>
+#include <audio/format.hpp>
+#include <audio/orchestra/mode.hpp>
+
+namespace audio {
+	namespace orchestra {
+		namespace api {
+			/**
+			 * @brief Secondary card of an aggregated ALSA stream.
+			 * The main card of the stream is the clock master: this card is accessed in non-blocking mode from the IO
+			 * thread of the main card, and its samples are adaptively resampled to follow the master clock. The rate
+			 * ratio is driven by the fill level of the card (snd_pcm_status delay corrected with its htstamp).
+			 */
+			class AlsaAggregate {
+				public:
+					AlsaAggregate();
+					~AlsaAggregate();
+					/**
+					 * @brief Open and configure the card (the number of channels is the maximum supported by the card).
+					 * @param[in] _deviceName Alsa name of the card.
+					 * @param[in] _mode Direction of the stream (input or output).
+					 * @param[in] _sampleRate Nominal sample rate (must be the same than the main card).
+					 * @param[in] _bufferSize Period size of the main card.
+					 * @return true if the card is open.
+					 */
+					bool open(const etk::String& _deviceName,
+					          enum audio::orchestra::mode _mode,
+					          uint32_t _sampleRate,
+					          uint32_t _bufferSize);
+					/**
+					 * @brief Close the card.
+					 */
+					void close();
+					/**
+					 * @brief Get the number of channels provided by this card.
+					 */
+					uint32_t getNbChannels() const {
+						return m_nbChannels;
+					}
+					/**
+					 * @brief Set the position of the channels of this card in the user buffer.
+					 * @param[in] _format User sample format.
+					 * @param[in] _nbUserChannels Number of channels of the user buffer.
+					 * @param[in] _firstUserChannel First channel of this card in the user buffer.
+					 * @param[in] _bufferSize Number of frame of the user buffer.
+					 * @return false if the user format can not be used.
+					 */
+					bool setUserChannels(enum audio::format _format,
+					                     uint32_t _nbUserChannels,
+					                     uint32_t _firstUserChannel,
+					                     uint32_t _bufferSize);
+					/**
+					 * @brief Prepare the card (and start the capture).
+					 */
+					bool start();
+					/**
+					 * @brief Stop the card.
+					 */
+					void stop();
+					/**
+					 * @brief Send the channels of this card of one user buffer (playback, called in the IO thread).
+					 * @return false if an xrun occured.
+					 */
+					bool write(const char* _userBuffer, uint32_t _nbFrames);
+					/**
+					 * @brief Set the channels of this card in the user buffer (capture, called in the IO thread).
+					 * @return false if an xrun occured (silence inserted).
+					 */
+					bool read(char* _userBuffer, uint32_t _nbFrames);
+					/**
+					 * @brief Get the current rate ratio (card clock / master clock).
+					 */
+					double getRatio() const {
+						return 1.0/m_step;
+					}
+				private:
+					snd_pcm_t* m_handle;
+					etk::String m_name;
+					enum audio::orchestra::mode m_mode;
+					uint32_t m_sampleRate;
+					uint32_t m_bufferSize;
+					uint32_t m_nbChannels;
+					snd_pcm_format_t m_deviceFormat;
+					etk::Vector<char> m_deviceBuffer; //!< buffer in the card format
+					// User buffer position:
+					enum audio::format m_userFormat;
+					uint32_t m_nbUserChannels;
+					uint32_t m_firstUserChannel;
+					// FIFO of resampled frames (interleaved float):
+					etk::Vector<float> m_fifo;
+					uint32_t m_fifoRead; //!< read position (frame)
+					uint32_t m_fifoSize; //!< number of frame in the FIFO
+					uint32_t m_fifoCapacity; //!< number of frame that can be stored
+					bool m_primed; //!< capture: the FIFO has reach the target level
+					// Resampler (linear interpolation with adaptive step):
+					double m_step; //!< number of input frame consumed for one output frame
+					double m_position; //!< fractional position of the next output frame
+					etk::Vector<float> m_history; //!< last input frame
+					etk::Vector<float> m_input; //!< float samples before resampling
+					etk::Vector<float> m_output; //!< float samples after resampling
+					// Drift controller:
+					double m_target; //!< target fill level (frames)
+					double m_errorFiltered;
+					double m_errorIntegral;
+				private:
+					void fifoPush(const float* _data, uint32_t _nbFrames);
+					uint32_t fifoPop(float* _data, uint32_t _nbFrames);
+					uint32_t resample(const float* _input, uint32_t _nbFrames, float* _output);
+					void updateDrift();
+					bool recover(int32_t _error);
+			};
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,266 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license APACHE v2.0 (see license file)
+ */
+
+#if defined(ORCHESTRA_BUILD_ALSA)
+
+#include <audio/orchestra/Interface.hpp>
+#include <audio/orchestra/debug.hpp>
+#include <audio/orchestra/api/Alsa.hpp>
+#include <audio/orchestra/api/AlsaEngine.hpp>
+#include <ethread/tools.hpp>
+extern "C" {
+	#include <poll.h>
+	#include <errno.h>
+	#include <string.h>
+	#include <unistd.h>
+	#include <sys/eventfd.h>
+}
+
+static const int32_t engineIdleTimeoutMs = -1; //!< Poll timeout when no stream is running
+
+/**
+ * @brief Registry of the engines (an engine is destroyed when its last stream is closed).
+ */
+static etk::Vector<ememory::WeakPtr<audio::orchestra::api::AlsaEngine>>& getEngineList() {
+	static etk::Vector<ememory::WeakPtr<audio::orchestra::api::AlsaEngine>> list;
+	return list;
+}
+
+static ethread::Mutex& getEngineListMutex() {
+	static ethread::Mutex mutex;
+	return mutex;
+}
+
+/**
+ * @brief Descriptors of one stream in the poll set.
+ */
+class AlsaEngineEntry {
+	public:
+		audio::orchestra::api::Alsa* stream;
+		uint32_t offset; //!< Index of the first descriptor of the stream
+		int32_t count; //!< Number of descriptors
+};
+
+/**
+ * @brief Check the watchdog of the polled streams.
+ * @return Poll timeout before the next watchdog check (ms).
+ */
+static int32_t checkWatchdog(etk::Vector<AlsaEngineEntry>& _entries) {
+	audio::Time now = audio::Time::now();
+	int32_t timeout = engineIdleTimeoutMs;
+	for (size_t iii=0; iii<_entries.size(); ++iii) {
+		int32_t remaining = _entries[iii].stream->engineWatchdog(now);
+		if (    remaining >= 0
+		     && (    timeout < 0
+		          || remaining < timeout)) {
+			timeout = remaining;
+		}
+	}
+	return timeout;
+}
+
+ememory::SharedPtr<audio::orchestra::api::AlsaEngine> audio::orchestra::api::AlsaEngine::get(uint32_t _id, const audio::orchestra::ThreadConfig& _config) {
+	ethread::UniqueLock lock(getEngineListMutex());
+	etk::Vector<ememory::WeakPtr<audio::orchestra::api::AlsaEngine>>& list = getEngineList();
+	if (_id >= list.size()) {
+		list.resize(_id+1);
+	}
+	ememory::SharedPtr<audio::orchestra::api::AlsaEngine> engine = list[_id].lock();
+	if (engine != null) {
+		return engine;
+	}
+	engine = ememory::makeShared<audio::orchestra::api::AlsaEngine>(_id, _config);
+	if (engine->start() == false) {
+		return null;
+	}
+	list[_id] = engine;
+	return engine;
+}
+
+audio::orchestra::api::AlsaEngine::AlsaEngine(uint32_t _id, const audio::orchestra::ThreadConfig& _config) :
+  m_id(_id),
+  m_config(_config),
+  m_changed(true),
+  m_running(false),
+  m_eventFd(-1) {
+
+}
+
+audio::orchestra::api::AlsaEngine::~AlsaEngine() {
+	__atomic_store_n(&m_running, false, __ATOMIC_RELEASE);
+	wakeUp();
+	if (m_thread != null) {
+		m_thread->join();
+		m_thread.reset();
+	}
+	if (m_stopThread != null) {
+		m_stopSemaphore.post();
+		m_stopThread->join();
+		m_stopThread.reset();
+	}
+	if (m_eventFd >= 0) {
+		close(m_eventFd);
+		m_eventFd = -1;
+	}
+	ATA_INFO("ALSA engine " << m_id << ": stopped");
+}
+
+bool audio::orchestra::api::AlsaEngine::start() {
+	m_eventFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (m_eventFd < 0) {
+		ATA_ERROR("ALSA engine " << m_id << ": can not create the control eventfd: " << strerror(errno));
+		return false;
+	}
+	m_running = true;
+	m_thread = ememory::makeShared<ethread::Thread>([&](){threadCallback();}, "Alsa engine");
+	if (m_thread == null) {
+		m_running = false;
+		ATA_ERROR("ALSA engine " << m_id << ": can not create the IO thread");
+		return false;
+	}
+	ethread::setPriority(*m_thread, -6);
+	// The stop thread keep the default scheduling: it only wait the end of the drain.
+	m_stopThread = ememory::makeShared<ethread::Thread>([&](){stopCallback();}, "Alsa engine stop");
+	if (m_stopThread == null) {
+		ATA_ERROR("ALSA engine " << m_id << ": can not create the stop thread");
+		return false;
+	}
+	ATA_INFO("ALSA engine " << m_id << ": started (policy=" << m_config.policy << " priority=" << m_config.priority << " affinity=" << m_config.cpuAffinity << ")");
+	return true;
+}
+
+void audio::orchestra::api::AlsaEngine::add(audio::orchestra::api::Alsa* _stream) {
+	ethread::UniqueLock lock(m_mutex);
+	m_streams.pushBack(_stream);
+	__atomic_store_n(&m_changed, true, __ATOMIC_RELEASE);
+	wakeUp();
+}
+
+void audio::orchestra::api::AlsaEngine::remove(audio::orchestra::api::Alsa* _stream) {
+	{
+		// The IO thread hold the lock while it process the streams.
+		ethread::UniqueLock lock(m_mutex);
+		auto it = m_streams.begin();
+		while (it != m_streams.end()) {
+			if (*it == _stream) {
+				it = m_streams.erase(it);
+			} else {
+				++it;
+			}
+		}
+		__atomic_store_n(&m_changed, true, __ATOMIC_RELEASE);
+		wakeUp();
+	}
+	// Wait the end of a drain of the stream in progress in the stop thread.
+	ethread::UniqueLock lock(m_stopMutex);
+}
+
+void audio::orchestra::api::AlsaEngine::wakeUp() {
+	__atomic_store_n(&m_changed, true, __ATOMIC_RELEASE);
+	if (m_eventFd < 0) {
+		return;
+	}
+	uint64_t value = 1;
+	if (write(m_eventFd, &value, sizeof(value)) < 0) {
+		// The counter is already set: the thread will wake up.
+	}
+}
+
+void audio::orchestra::api::AlsaEngine::requestStop() {
+	// The stream is no more running: remove it from the poll set.
+	wakeUp();
+	m_stopSemaphore.post();
+}
+
+void audio::orchestra::api::AlsaEngine::stopCallback() {
+	ethread::setName("Alsa engine-" + etk::toString(m_id) + " stop");
+	while (true) {
+		m_stopSemaphore.wait();
+		if (__atomic_load_n(&m_running, __ATOMIC_ACQUIRE) == false) {
+			break;
+		}
+		ethread::UniqueLock stopLock(m_stopMutex);
+		etk::Vector<audio::orchestra::api::Alsa*> streams;
+		{
+			ethread::UniqueLock lock(m_mutex);
+			for (size_t iii=0; iii<m_streams.size(); ++iii) {
+				if (m_streams[iii]->engineStopPending() == true) {
+					streams.pushBack(m_streams[iii]);
+				}
+			}
+		}
+		// The drain is done without the engine lock: the other streams continue to be processed.
+		for (size_t iii=0; iii<streams.size(); ++iii) {
+			streams[iii]->engineStop();
+		}
+	}
+	ATA_DEBUG("ALSA engine " << m_id << ": end of stop thread");
+}
+
+void audio::orchestra::api::AlsaEngine::threadCallback() {
+	ethread::setName("Alsa engine-" + etk::toString(m_id));
+	m_config.applyCurrentThread();
+	// The first descriptor is the control event, then the descriptors of each running stream.
+	etk::Vector<struct pollfd> ufds;
+	etk::Vector<AlsaEngineEntry> entries;
+	int32_t timeout = engineIdleTimeoutMs;
+	while (__atomic_load_n(&m_running, __ATOMIC_ACQUIRE) == true) {
+		if (__atomic_exchange_n(&m_changed, false, __ATOMIC_ACQ_REL) == true) {
+			ethread::UniqueLock lock(m_mutex);
+			ufds.clear();
+			entries.clear();
+			struct pollfd control;
+			control.fd = m_eventFd;
+			control.events = POLLIN;
+			control.revents = 0;
+			ufds.pushBack(control);
+			for (size_t iii=0; iii<m_streams.size(); ++iii) {
+				if (m_streams[iii]->engineIsActive() == false) {
+					continue;
+				}
+				AlsaEngineEntry entry;
+				entry.stream = m_streams[iii];
+				entry.offset = ufds.size();
+				entry.count = m_streams[iii]->engineGetPollDescriptors(ufds);
+				if (entry.count > 0) {
+					entries.pushBack(entry);
+				}
+			}
+			timeout = checkWatchdog(entries);
+			ATA_DEBUG("ALSA engine " << m_id << ": poll " << entries.size() << "/" << m_streams.size() << " streams");
+		}
+		int32_t ret = poll(&ufds[0], ufds.size(), timeout);
+		if (ret < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			ATA_ERROR("ALSA engine " << m_id << ": poll error: " << strerror(errno));
+			ethread::sleepMilliSeconds(10);
+			continue;
+		}
+		if ((ufds[0].revents & POLLIN) != 0) {
+			uint64_t value = 0;
+			while (read(m_eventFd, &value, sizeof(value)) > 0) {
+				// nothing to do
+			}
+		}
+		ethread::UniqueLock lock(m_mutex);
+		if (__atomic_load_n(&m_changed, __ATOMIC_ACQUIRE) == true) {
+			// The streams may have been removed: rebuild the poll set before using them.
+			continue;
+		}
+		if (ret > 0) {
+			for (size_t iii=0; iii<entries.size(); ++iii) {
+				entries[iii].stream->engineProcess(&ufds[entries[iii].offset], entries[iii].count);
+			}
+		}
+		// Check all the streams (a stream that is always ready does not delay the watchdog of the others).
+		timeout = checkWatchdog(entries);
+	}
+	ATA_DEBUG("ALSA engine " << m_id << ": end of thread");
+}
+
+#endif
@@ -0,0 +1,91 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license APACHE v2.0 (see license file)
+ */
+#pragma once
+#ifdef ORCHESTRA_BUILD_ALSA
+
+#include <etk/types.hpp>
+#include <etk/Vector.hpp>
+#include <ethread/Mutex.hpp>
+#include <ethread/Thread.hpp>
+#include <ethread/Semaphore.hpp>
+#include <ememory/memory.hpp>
+#include <audio/orchestra/ThreadConfig.hpp>
+
+namespace audio {
+	namespace orchestra {
+		namespace api {
+			class Alsa;
+			/**
+			 * @brief Shared IO thread of the ALSA streams (ThreadConfig::sharedThread).
+			 * One thread poll the descriptors of all the running streams registered on it and process the periods of the
+			 * streams that are ready: many small streams use one real-time thread instead of one thread per stream.
+			 * @note The thread is configured with the ThreadConfig of the stream that create the engine (pin it with
+			 *       ThreadConfig::cpuAffinity to have N engines on N cores).
+			 */
+			class AlsaEngine {
+				private:
+					uint32_t m_id; //!< Index of the engine (ThreadConfig::sharedThread)
+					audio::orchestra::ThreadConfig m_config; //!< Configuration of the IO thread
+					ethread::Mutex m_mutex; //!< Protect the list of streams (held while the streams are processed)
+					etk::Vector<audio::orchestra::api::Alsa*> m_streams; //!< Streams driven by this engine
+					bool m_changed; //!< The poll set must be rebuilt (stream added, removed, started or stopped)
+					bool m_running; //!< The IO thread must continue
+					int32_t m_eventFd; //!< eventfd in the poll set to wake up the IO thread
+					ememory::SharedPtr<ethread::Thread> m_thread;
+					ethread::Mutex m_stopMutex; //!< Held while the stop thread drain a stream (never taken by the IO thread)
+					ethread::Semaphore m_stopSemaphore; //!< Wake up the stop thread (stop requested by a callback)
+					ememory::SharedPtr<ethread::Thread> m_stopThread; //!< Drain the streams stopped by their callback out of the IO thread
+				public:
+					/**
+					 * @brief Get an engine (created at the first call, destroyed with the last stream).
+					 * @param[in] _id Index of the engine.
+					 * @param[in] _config Configuration of the IO thread (used only when the engine is created).
+					 * @return The engine or null if the IO thread can not be created.
+					 */
+					static ememory::SharedPtr<audio::orchestra::api::AlsaEngine> get(uint32_t _id, const audio::orchestra::ThreadConfig& _config);
+					AlsaEngine(uint32_t _id, const audio::orchestra::ThreadConfig& _config);
+					~AlsaEngine();
+					/**
+					 * @brief Register a stream (it is polled when it is running).
+					 * @param[in] _stream Stream to drive.
+					 */
+					void add(audio::orchestra::api::Alsa* _stream);
+					/**
+					 * @brief Unregister a stream.
+					 * @note When this function return, the IO thread does not use the stream anymore.
+					 * @param[in] _stream Stream to remove.
+					 */
+					void remove(audio::orchestra::api::Alsa* _stream);
+					/**
+					 * @brief Request the IO thread to rebuild its poll set (the state of a stream changed).
+					 */
+					void wakeUp();
+					/**
+					 * @brief Request the stop thread to stop the streams marked by Alsa::engineRequestStop (the drain block the
+					 *        IO thread and all the other streams of the engine).
+					 * @note Can be called from the IO thread (does not lock).
+					 */
+					void requestStop();
+				private:
+					/**
+					 * @brief Start the IO thread.
+					 * @return false if the thread can not be created.
+					 */
+					bool start();
+					/**
+					 * @brief IO loop.
+					 */
+					void threadCallback();
+					/**
+					 * @brief Stop loop: drain the streams stopped by their callback.
+					 */
+					void stopCallback();
+			};
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,153 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license APACHE v2.0 (see license file)
+ */
+
+#if defined(ORCHESTRA_BUILD_ALSA)
+
+#include <audio/orchestra/debug.hpp>
+#include <audio/orchestra/api/AlsaMonitor.hpp>
+#include <ethread/tools.hpp>
+extern "C" {
+	#include <poll.h>
+	#include <errno.h>
+	#include <stdio.h>
+	#include <string.h>
+	#include <unistd.h>
+	#include <sys/eventfd.h>
+	#include <sys/inotify.h>
+}
+
+static const char* alsaDeviceDirectory = "/dev/snd";
+
+audio::orchestra::api::AlsaMonitor::AlsaMonitor() :
+  m_running(false),
+  m_inotifyFd(-1),
+  m_eventFd(-1) {
+	
+}
+
+audio::orchestra::api::AlsaMonitor::~AlsaMonitor() {
+	stop();
+}
+
+bool audio::orchestra::api::AlsaMonitor::start(audio::orchestra::DeviceEventCallback _callback) {
+	stop();
+	m_inotifyFd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+	if (m_inotifyFd < 0) {
+		ATA_ERROR("ALSA monitor: can not create the inotify descriptor: " << strerror(errno));
+		return false;
+	}
+	if (inotify_add_watch(m_inotifyFd, alsaDeviceDirectory, IN_CREATE | IN_DELETE) < 0) {
+		ATA_ERROR("ALSA monitor: can not watch '" << alsaDeviceDirectory << "': " << strerror(errno));
+		stop();
+		return false;
+	}
+	m_eventFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (m_eventFd < 0) {
+		ATA_ERROR("ALSA monitor: can not create the control eventfd: " << strerror(errno));
+		stop();
+		return false;
+	}
+	m_callback = _callback;
+	m_running = true;
+	m_thread = ememory::makeShared<ethread::Thread>([&](){threadCallback();}, "Alsa monitor");
+	if (m_thread == null) {
+		ATA_ERROR("ALSA monitor: can not create the thread");
+		stop();
+		return false;
+	}
+	return true;
+}
+
+void audio::orchestra::api::AlsaMonitor::stop() {
+	__atomic_store_n(&m_running, false, __ATOMIC_RELEASE);
+	if (m_eventFd >= 0) {
+		uint64_t value = 1;
+		if (write(m_eventFd, &value, sizeof(value)) < 0) {
+			// The counter is already set: the thread will wake up.
+		}
+	}
+	if (m_thread != null) {
+		m_thread->join();
+		m_thread.reset();
+	}
+	if (m_eventFd >= 0) {
+		close(m_eventFd);
+		m_eventFd = -1;
+	}
+	if (m_inotifyFd >= 0) {
+		close(m_inotifyFd);
+		m_inotifyFd = -1;
+	}
+	m_callback = null;
+}
+
+void audio::orchestra::api::AlsaMonitor::processNode(const char* _node, enum audio::orchestra::deviceEvent _event) {
+	uint32_t card = 0;
+	uint32_t device = 0;
+	char direction = 0;
+	if (sscanf(_node, "pcmC%uD%u%c", &card, &device, &direction) != 3) {
+		// control, timer, midi ... nodes.
+		return;
+	}
+	enum audio::orchestra::mode mode;
+	if (direction == 'p') {
+		mode = audio::orchestra::mode_output;
+	} else if (direction == 'c') {
+		mode = audio::orchestra::mode_input;
+	} else {
+		return;
+	}
+	char name[64];
+	sprintf(name, "hw:%u,%u", card, device);
+	ATA_INFO("ALSA monitor: " << _event << " '" << name << "' (" << mode << ")");
+	if (m_callback != null) {
+		m_callback(_event, name, mode);
+	}
+}
+
+void audio::orchestra::api::AlsaMonitor::threadCallback() {
+	ethread::setName("Alsa monitor");
+	// Aligned buffer: the events are read in place.
+	char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+	struct pollfd ufds[2];
+	ufds[0].fd = m_eventFd;
+	ufds[0].events = POLLIN;
+	ufds[1].fd = m_inotifyFd;
+	ufds[1].events = POLLIN;
+	while (__atomic_load_n(&m_running, __ATOMIC_ACQUIRE) == true) {
+		ufds[0].revents = 0;
+		ufds[1].revents = 0;
+		if (poll(ufds, 2, -1) < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			ATA_ERROR("ALSA monitor: poll error: " << strerror(errno));
+			ethread::sleepMilliSeconds(100);
+			continue;
+		}
+		if ((ufds[1].revents & POLLIN) == 0) {
+			continue;
+		}
+		ssize_t size = read(m_inotifyFd, buffer, sizeof(buffer));
+		if (size <= 0) {
+			continue;
+		}
+		for (char* it = buffer; it < buffer + size; ) {
+			const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(it);
+			if (event->len > 0) {
+				if ((event->mask & IN_CREATE) != 0) {
+					processNode(event->name, audio::orchestra::deviceEvent_added);
+				} else if ((event->mask & IN_DELETE) != 0) {
+					processNode(event->name, audio::orchestra::deviceEvent_removed);
+				}
+			}
+			it += sizeof(struct inotify_event) + event->len;
+		}
+	}
+	ATA_DEBUG("ALSA monitor: end of thread");
+}
+
+#endif
@@ -0,0 +1,59 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license APACHE v2.0 (see license file)
+ */
+#pragma once
+#ifdef ORCHESTRA_BUILD_ALSA
+
+#include <etk/types.hpp>
+#include <ethread/Thread.hpp>
+#include <ememory/memory.hpp>
+#include <audio/orchestra/DeviceEvent.hpp>
+
+namespace audio {
+	namespace orchestra {
+		namespace api {
+			/**
+			 * @brief Hot-plug monitor of the ALSA devices.
+			 * The PCM nodes of /dev/snd (pcmC<card>D<device>p/c) are created and removed by udev when a card is plugged
+			 * or unplugged: an inotify watch on the directory report the devices without polling the ALSA control API.
+			 * @note ALSA has no default device: deviceEvent_defaultChanged is never reported.
+			 */
+			class AlsaMonitor {
+				private:
+					audio::orchestra::DeviceEventCallback m_callback; //!< User callback
+					bool m_running; //!< The monitor thread must continue
+					int32_t m_inotifyFd; //!< inotify descriptor watching /dev/snd
+					int32_t m_eventFd; //!< eventfd to wake up the monitor thread (stop)
+					ememory::SharedPtr<ethread::Thread> m_thread;
+				public:
+					AlsaMonitor();
+					~AlsaMonitor();
+					/**
+					 * @brief Start the monitor thread.
+					 * @param[in] _callback Function called on each event (on the monitor thread).
+					 * @return false if the directory can not be watched.
+					 */
+					bool start(audio::orchestra::DeviceEventCallback _callback);
+					/**
+					 * @brief Stop and join the monitor thread (the callback is not called anymore).
+					 */
+					void stop();
+				private:
+					/**
+					 * @brief Monitor loop (blocking read of the inotify events).
+					 */
+					void threadCallback();
+					/**
+					 * @brief Report the event of a node of /dev/snd (nodes that are not a PCM are ignored).
+					 * @param[in] _node Name of the node in /dev/snd.
+					 * @param[in] _event Type of the event.
+					 */
+					void processNode(const char* _node, enum audio::orchestra::deviceEvent _event);
+			};
+		}
+	}
+}
+
+#endif
@@ -479,7 +479,7 @@ bool audio::orchestra::api::Asio::open(uint32_t _device,
 		bool makeBuffer = true;
 		bufferBytes = m_nDeviceChannels[modeToIdTable(_mode)] * audio::getFormatBytes(m_deviceFormat[modeToIdTable(_mode)]);
 		if (_mode == audio::orchestra::mode_input) {
-			if (m_mode == audio::orchestra::mode_output && m_deviceBuffer) {
+			if (m_mode == audio::orchestra::mode_output && m_deviceBuffer.size() != 0) {
 				uint64_t bytesOut = m_nDeviceChannels[0] * audio::getFormatBytes(m_deviceFormat[0]);
 				if (bufferBytes <= bytesOut) {
 					makeBuffer = false;
@@ -488,12 +488,9 @@ bool audio::orchestra::api::Asio::open(uint32_t _device,
 		}
 		if (makeBuffer) {
 			bufferBytes *= *_bufferSize;
-			if (m_deviceBuffer) {
-				free(m_deviceBuffer);
-				m_deviceBuffer = null;
-			}
-			m_deviceBuffer = (char *) calloc(bufferBytes, 1);
-			if (m_deviceBuffer == null) {
+			m_deviceBuffer.clear();
+			m_deviceBuffer.resize(bufferBytes, 0);
+			if (m_deviceBuffer.size() == 0) {
 				ATA_ERROR("error allocating device buffer memory.");
 				goto error;
 			}
@@ -540,10 +537,7 @@ error:
 			m_userBuffer[i] = 0;
 		}
 	}
-	if (m_deviceBuffer) {
-		free(m_deviceBuffer);
-		m_deviceBuffer = 0;
-	}
+	m_deviceBuffer.clear();
 	return false;
 }
 
@@ -568,10 +562,7 @@ enum audio::orchestra::error audio::orchestra::api::Asio::closeStream() {
 			m_userBuffer[i] = 0;
 		}
 	}
-	if (m_deviceBuffer) {
-		free(m_deviceBuffer);
-		m_deviceBuffer = 0;
-	}
+	m_deviceBuffer.clear();
 	m_mode = audio::orchestra::mode_unknow;
 	m_state = audio::orchestra::state::closed;
 	return audio::orchestra::error_none;
@@ -736,9 +727,9 @@ bool audio::orchestra::api::Asio::callbackEvent(long bufferIndex) {
 				}
 			}
 		} else if (m_doConvertBuffer[0]) {
-			convertBuffer(m_deviceBuffer, m_userBuffer[0], m_convertInfo[0]);
+			convertBuffer(&m_deviceBuffer[0], m_userBuffer[0], m_convertInfo[0]);
 			if (m_doByteSwap[0]) {
-				byteSwapBuffer(m_deviceBuffer,
+				byteSwapBuffer(&m_deviceBuffer[0],
 				               m_bufferSize * m_nDeviceChannels[0],
 				               m_deviceFormat[0]);
 			}
@@ -781,12 +772,12 @@ bool audio::orchestra::api::Asio::callbackEvent(long bufferIndex) {
 				}
 			}
 			if (m_doByteSwap[1]) {
-				byteSwapBuffer(m_deviceBuffer,
+				byteSwapBuffer(&m_deviceBuffer[0],
 				               m_bufferSize * m_nDeviceChannels[1],
 				               m_deviceFormat[1]);
 			}
 			convertBuffer(m_userBuffer[1],
-			              m_deviceBuffer,
+			              &m_deviceBuffer[0],
 			              m_convertInfo[1]);
 		} else {
 			for (i=0, j=0; i<nChannels; i++) {
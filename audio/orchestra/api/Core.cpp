@@ -803,7 +803,7 @@ bool audio::orchestra::api::Core::open(uint32_t _device,
 		bufferBytes = m_nDeviceChannels[modeToIdTable(_mode)] * audio::getFormatBytes(m_deviceFormat[modeToIdTable(_mode)]);
 		if (_mode == audio::orchestra::mode_input) {
 			if (    m_mode == audio::orchestra::mode_output
-			     && m_deviceBuffer) {
+			     && m_deviceBuffer.size() != 0) {
 				uint64_t bytesOut = m_nDeviceChannels[0] * audio::getFormatBytes(m_deviceFormat[0]);
 				if (bufferBytes <= bytesOut) {
 					makeBuffer = false;
@@ -812,12 +812,9 @@ bool audio::orchestra::api::Core::open(uint32_t _device,
 		}
 		if (makeBuffer) {
 			bufferBytes *= *_bufferSize;
-			if (m_deviceBuffer) {
-				free(m_deviceBuffer);
-				m_deviceBuffer = null;
-			}
-			m_deviceBuffer = (char *) calloc(bufferBytes, 1);
-			if (m_deviceBuffer == null) {
+			m_deviceBuffer.clear();
+			m_deviceBuffer.resize(bufferBytes, 0);
+			if (m_deviceBuffer.size() == 0) {
 				ATA_ERROR("error allocating device buffer memory.");
 				goto error;
 			}
@@ -865,10 +862,7 @@ bool audio::orchestra::api::Core::open(uint32_t _device,
 error:
 	m_userBuffer[0].clear();
 	m_userBuffer[1].clear();
-	if (m_deviceBuffer) {
-		free(m_deviceBuffer);
-		m_deviceBuffer = 0;
-	}
+	m_deviceBuffer.clear();
 	m_state = audio::orchestra::state::closed;
 	ATA_VERBOSE("Set state as closed");
 	return false;
@@ -906,10 +900,7 @@ enum audio::orchestra::error audio::orchestra::api::Core::closeStream() {
 	}
 	m_userBuffer[0].clear();
 	m_userBuffer[1].clear();
-	if (m_deviceBuffer) {
-		free(m_deviceBuffer);
-		m_deviceBuffer = null;
-	}
+	m_deviceBuffer.clear();
 	m_mode = audio::orchestra::mode_unknow;
 	m_state = audio::orchestra::state::closed;
 	ATA_VERBOSE("Set state as closed");
@@ -1109,8 +1100,8 @@ bool audio::orchestra::api::Core::callbackEvent(AudioDeviceID _deviceId,
 			// fill multiple streams
 			float *inBuffer = (float *) &m_userBuffer[0][0];
 			if (m_doConvertBuffer[0]) {
-				convertBuffer(m_deviceBuffer, &m_userBuffer[0][0], m_convertInfo[0]);
-				inBuffer = (float *) m_deviceBuffer;
+				convertBuffer(&m_deviceBuffer[0], &m_userBuffer[0][0], m_convertInfo[0]);
+				inBuffer = (float *) &m_deviceBuffer[0];
 			}
 			if (m_deviceInterleaved[0] == false) { // mono mode
 				uint32_t bufferBytes = _outBufferList->mBuffers[m_private->iStream[0]].mDataByteSize;
@@ -1194,7 +1185,7 @@ bool audio::orchestra::api::Core::callbackEvent(AudioDeviceID _deviceId,
 		} else { // read from multiple streams
 			float *outBuffer = (float *) &m_userBuffer[1][0];
 			if (m_doConvertBuffer[1]) {
-				outBuffer = (float *) m_deviceBuffer;
+				outBuffer = (float *) &m_deviceBuffer[0];
 			}
 			if (m_deviceInterleaved[1] == false) {
 				// mono mode
@@ -1256,7 +1247,7 @@ bool audio::orchestra::api::Core::callbackEvent(AudioDeviceID _deviceId,
 			}
 			if (m_doConvertBuffer[1]) { // convert from our internal "device" buffer
 				convertBuffer(&m_userBuffer[1][0],
-				              m_deviceBuffer,
+				              &m_deviceBuffer[0],
 				              m_convertInfo[1]);
 			}
 		}
@@ -715,7 +715,7 @@ bool audio::orchestra::api::Ds::open(uint32_t _device,
 		bool makeBuffer = true;
 		bufferBytes = m_nDeviceChannels[modeToIdTable(_mode)] * audio::getFormatBytes(m_deviceFormat[modeToIdTable(_mode)]);
 		if (_mode == audio::orchestra::mode_input) {
-			if (m_mode == audio::orchestra::mode_output && m_deviceBuffer) {
+			if (m_mode == audio::orchestra::mode_output && m_deviceBuffer.size() != 0) {
 				uint64_t bytesOut = m_nDeviceChannels[0] * audio::getFormatBytes(m_deviceFormat[0]);
 				if (bufferBytes <= (long) bytesOut) {
 					makeBuffer = false;
@@ -724,11 +724,9 @@ bool audio::orchestra::api::Ds::open(uint32_t _device,
 		}
 		if (makeBuffer) {
 			bufferBytes *= *_bufferSize;
-			if (m_deviceBuffer) {
-				free(m_deviceBuffer);
-			}
-			m_deviceBuffer = (char *) calloc(bufferBytes, 1);
-			if (m_deviceBuffer == null) {
+			m_deviceBuffer.clear();
+			m_deviceBuffer.resize(bufferBytes, 0);
+			if (m_deviceBuffer.size() == 0) {
 				ATA_ERROR("error allocating device buffer memory.");
 				goto error;
 			}
@@ -792,10 +790,7 @@ error:
 	for (size_t iii=0; iii<2; ++iii) {
 		m_userBuffer[iii].clear();
 	}
-	if (m_deviceBuffer) {
-		free(m_deviceBuffer);
-		m_deviceBuffer = 0;
-	}
+	m_deviceBuffer.clear();
 	m_state = audio::orchestra::state::closed;
 	return false;
 }
@@ -833,10 +828,7 @@ enum audio::orchestra::error audio::orchestra::api::Ds::closeStream() {
 	for (size_t iii=0; iii<2; ++iii) {
 		m_userBuffer[iii].clear();
 	}
-	if (m_deviceBuffer) {
-		free(m_deviceBuffer);
-		m_deviceBuffer = 0;
-	}
+	m_deviceBuffer.clear();
 	m_mode = audio::orchestra::mode_unknow;
 	m_state = audio::orchestra::state::closed;
 }
@@ -1121,7 +1113,7 @@ void audio::orchestra::api::Ds::callbackEvent() {
 		}
 		// Setup parameters and do buffer conversion if necessary.
 		if (m_doConvertBuffer[0]) {
-			buffer = m_deviceBuffer;
+			buffer = &m_deviceBuffer[0];
 			convertBuffer(buffer, &m_userBuffer[0][0], m_convertInfo[0]);
 			bufferBytes = m_bufferSize * m_nDeviceChannels[0];
 			bufferBytes *= audio::getFormatBytes(m_deviceFormat[0]);
@@ -1220,7 +1212,7 @@ void audio::orchestra::api::Ds::callbackEvent() {
 	     || m_mode == audio::orchestra::mode_duplex) {
 		// Setup parameters.
 		if (m_doConvertBuffer[1]) {
-			buffer = m_deviceBuffer;
+			buffer = &m_deviceBuffer[0];
 			bufferBytes = m_bufferSize * m_nDeviceChannels[1];
 			bufferBytes *= audio::getFormatBytes(m_deviceFormat[1]);
 		} else {
@@ -1345,7 +1337,7 @@ void audio::orchestra::api::Ds::callbackEvent() {
 		}
 		// Do buffer conversion if necessary.
 		if (m_doConvertBuffer[1]) {
-			convertBuffer(&m_userBuffer[1][0], m_deviceBuffer, m_convertInfo[1]);
+			convertBuffer(&m_userBuffer[1][0], &m_deviceBuffer[0], m_convertInfo[1]);
 		}
 	}
 unlock:
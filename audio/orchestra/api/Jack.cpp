@@ -10,11 +10,13 @@
 extern "C" {
 	#include <limits.h>
 	#include <string.h>
+	#include <errno.h>
 }
 #include <audio/orchestra/Interface.hpp>
 #include <audio/orchestra/debug.hpp>
 #include <ethread/tools.hpp>
 #include <audio/orchestra/api/Jack.hpp>
+#include <audio/orchestra/api/JackMonitor.hpp>
 
 ememory::SharedPtr<audio::orchestra::Api> audio::orchestra::api::Jack::create() {
 	return ememory::SharedPtr<audio::orchestra::api::Jack>(ETK_NEW(audio::orchestra::api::Jack));
@@ -54,12 +56,22 @@ ememory::SharedPtr<audio::orchestra::Api> audio::orchestra::api::Jack::create()
 #include <jack/jack.h>
 extern "C" {
 #include <stdio.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
 }
 
+// Maximum period size of a jack server: the buffers are preallocated for this size to follow the server changes.
+static const uint32_t jackMaxBufferSize = 8192;
+
 namespace audio {
 	namespace orchestra {
 		namespace api {
 			class JackPrivate {
+				public:
+					// List of the actions that the process callback can request to the control thread:
+					static const uint32_t control_stop = 1<<0; //!< Stop the stream (drain done or abort requested by the user callback).
+					static const uint32_t control_close = 1<<1; //!< Close the stream (jack server shutdown).
+					static const uint32_t control_exit = 1<<2; //!< Stop the control thread.
 				public:
 					jack_client_t *client;
 					jack_port_t **ports[2];
@@ -68,15 +80,30 @@ namespace audio {
 					ethread::Semaphore m_semaphore;
 					int32_t drainCounter; // Tracks callback counts when draining
 					bool internalDrain; // Indicates if stop is initiated from callback or not.
+					etk::Vector<enum audio::orchestra::status> status; //!< Preallocated status list (no allocation in the process callback).
+					ememory::SharedPtr<ethread::Thread> controlThread; //!< Thread that execute the blocking actions requested by the process callback.
+					int32_t controlFd; //!< eventfd used to wake up the control thread.
+					uint32_t controlPending; //!< Bit-field of the requested actions (only accessed with atomic operations).
+					uint32_t bufferSizeMax; //!< Number of frames preallocated in the user and device buffers.
+					bool bufferSizeChange; //!< The buffer size changed since the last user callback.
+					bool planar; //!< The jack port buffers are given directly to the user callback.
+					etk::Vector<jack_default_audio_sample_t*> portBuffer[2]; //!< Preallocated list of the port buffers given to the callback in planar mode.
+					ememory::SharedPtr<audio::orchestra::api::JackMonitor> monitor; //!< Hot-plug monitor (null if not requested)
 					
 					JackPrivate() :
 					  client(0),
 					  drainCounter(0),
-					  internalDrain(false) {
+					  internalDrain(false),
+					  controlFd(-1),
+					  controlPending(0),
+					  bufferSizeMax(0),
+					  bufferSizeChange(false),
+					  planar(false) {
 						ports[0] = 0;
 						ports[1] = 0;
 						xrun[0] = false;
 						xrun[1] = false;
+						status.reserve(3);
 				}
 			};
 		}
@@ -89,9 +116,101 @@ audio::orchestra::api::Jack::Jack() :
 }
 
 audio::orchestra::api::Jack::~Jack() {
+	stopDeviceMonitor();
 	if (m_state != audio::orchestra::state::closed) {
 		closeStream();
 	}
+	controlStop();
+	if (m_private->controlFd >= 0) {
+		close(m_private->controlFd);
+		m_private->controlFd = -1;
+	}
+}
+
+bool audio::orchestra::api::Jack::controlStart() {
+	if (m_private->controlThread != null) {
+		return true;
+	}
+	// Note: the eventfd is kept up to the destruction of the object, the process callback can write in it at any time.
+	if (m_private->controlFd < 0) {
+		m_private->controlFd = eventfd(0, EFD_CLOEXEC);
+		if (m_private->controlFd < 0) {
+			ATA_ERROR("Can not create the control eventfd: " << strerror(errno));
+			return false;
+		}
+	}
+	__atomic_store_n(&m_private->controlPending, 0, __ATOMIC_RELEASE);
+	m_private->controlThread = ememory::makeShared<ethread::Thread>([&](){controlEvent();}, "Jack_control");
+	if (m_private->controlThread == null) {
+		ATA_ERROR("Can not create the control thread");
+		return false;
+	}
+	return true;
+}
+
+void audio::orchestra::api::Jack::controlStop() {
+	if (m_private->controlThread == null) {
+		return;
+	}
+	controlPush(audio::orchestra::api::JackPrivate::control_exit);
+	m_private->controlThread->join();
+	m_private->controlThread.reset();
+}
+
+void audio::orchestra::api::Jack::controlPush(uint32_t _command) {
+	// Note: This is called in the jack process callback ==> no lock, no allocation.
+	__atomic_fetch_or(&m_private->controlPending, _command, __ATOMIC_RELEASE);
+	uint64_t value = 1;
+	if (write(m_private->controlFd, &value, sizeof(value)) != sizeof(value)) {
+		// The counter can not overflow in practice, the action is already registered in the bit-field.
+	}
+}
+
+void audio::orchestra::api::Jack::controlEvent() {
+	ethread::setName("Jack ctrl-" + m_name);
+	while (true) {
+		uint64_t value = 0;
+		if (read(m_private->controlFd, &value, sizeof(value)) != sizeof(value)) {
+			if (errno == EINTR) {
+				continue;
+			}
+			ATA_ERROR("Read error on the control eventfd: " << strerror(errno));
+			return;
+		}
+		uint32_t command = __atomic_exchange_n(&m_private->controlPending, 0, __ATOMIC_ACQ_REL);
+		if ((command & audio::orchestra::api::JackPrivate::control_exit) != 0) {
+			return;
+		}
+		if ((command & audio::orchestra::api::JackPrivate::control_close) != 0) {
+			ATA_ERROR("The Jack server is shutting down this client ... stream stopped and closed!!");
+			closeStreamLocal();
+			continue;
+		}
+		if (    (command & audio::orchestra::api::JackPrivate::control_stop) != 0
+		     && m_state != audio::orchestra::state::closed
+		     && m_state != audio::orchestra::state::stopped) {
+			stopStream();
+		}
+	}
+}
+
+bool audio::orchestra::api::Jack::startDeviceMonitor(audio::orchestra::DeviceEventCallback _callback) {
+	stopDeviceMonitor();
+	ememory::SharedPtr<audio::orchestra::api::JackMonitor> monitor = ememory::makeShared<audio::orchestra::api::JackMonitor>();
+	if (    monitor == null
+	     || monitor->start(_callback) == false) {
+		return false;
+	}
+	m_private->monitor = monitor;
+	return true;
+}
+
+void audio::orchestra::api::Jack::stopDeviceMonitor() {
+	if (m_private->monitor == null) {
+		return;
+	}
+	m_private->monitor->stop();
+	m_private->monitor.reset();
 }
 
 uint32_t audio::orchestra::api::Jack::getDeviceCount() {
@@ -225,6 +344,75 @@ int32_t audio::orchestra::api::Jack::jackCallbackHandler(jack_nframes_t _nframes
 }
 
 
+int32_t audio::orchestra::api::Jack::jackBufferSize(jack_nframes_t _nframes, void* _userData) {
+	audio::orchestra::api::Jack* myClass = reinterpret_cast<audio::orchestra::api::Jack*>(_userData);
+	if (_nframes > myClass->m_private->bufferSizeMax) {
+		ATA_ERROR("the JACK buffer size (" << _nframes << ") is bigger than the preallocated size (" << myClass->m_private->bufferSizeMax << ") ... cannot process!");
+		return 1;
+	}
+	ATA_INFO("the JACK buffer size change: " << myClass->m_bufferSize << " ==> " << _nframes);
+	// Note: nothing is reallocated here, the process callback switch on the new size.
+	return 0;
+}
+
+void audio::orchestra::api::Jack::jackLatency(jack_latency_callback_mode_t _mode, void* _userData) {
+	audio::orchestra::api::Jack* myClass = reinterpret_cast<audio::orchestra::api::Jack*>(_userData);
+	// The graph changed: get the latency of our (terminal) ports, computed by the server from the connections.
+	int32_t idTable = 0;
+	if (_mode == JackCaptureLatency) {
+		idTable = 1;
+	}
+	if (    myClass->m_private->ports[idTable] == null
+	     || myClass->m_nUserChannels[idTable] == 0
+	     || myClass->m_private->ports[idTable][0] == null) {
+		return;
+	}
+	jack_latency_range_t latrange;
+	latrange.min = latrange.max = 0;
+	jack_port_get_latency_range(myClass->m_private->ports[idTable][0], _mode, &latrange);
+	// be optimistic, use the min!
+	__atomic_store_n(&myClass->m_latency[idTable], uint64_t(latrange.min), __ATOMIC_RELEASE);
+	ATA_VERBOSE("Jack " << (idTable==0?"playback":"capture") << " latency: " << latrange.min << " frames");
+}
+
+audio::Time audio::orchestra::api::Jack::frameToTime(jack_nframes_t _frame) {
+	// jack time is in micro-second on the monotonic clock of the server
+	jack_time_t time = jack_frames_to_time(m_private->client, _frame);
+	return audio::Time(time/1000000, (time%1000000)*1000);
+}
+
+audio::Time audio::orchestra::api::Jack::getStreamTime() {
+	if (verifyStream() != audio::orchestra::error_none) {
+		return audio::Time();
+	}
+	// Start time of the current cycle.
+	return frameToTime(jack_last_frame_time(m_private->client));
+}
+
+uint32_t audio::orchestra::api::Jack::getBufferSizeMax() const {
+	// The buffers are preallocated to follow the period changes of the server.
+	if (m_private->bufferSizeMax > m_bufferSize) {
+		return m_private->bufferSizeMax;
+	}
+	return m_bufferSize;
+}
+
+long audio::orchestra::api::Jack::getStreamLatency() {
+	if (verifyStream() != audio::orchestra::error_none) {
+		return 0;
+	}
+	long totalLatency = 0;
+	if (    m_mode == audio::orchestra::mode_output
+	     || m_mode == audio::orchestra::mode_duplex) {
+		totalLatency = __atomic_load_n(&m_latency[0], __ATOMIC_ACQUIRE);
+	}
+	if (    m_mode == audio::orchestra::mode_input
+	     || m_mode == audio::orchestra::mode_duplex) {
+		totalLatency += __atomic_load_n(&m_latency[1], __ATOMIC_ACQUIRE);
+	}
+	return totalLatency;
+}
+
 void audio::orchestra::api::Jack::jackShutdown(void* _userData) {
 	audio::orchestra::api::Jack* myClass = reinterpret_cast<audio::orchestra::api::Jack*>(_userData);
 	// Check current stream state. If stopped, then we'll assume this
@@ -235,8 +423,7 @@ void audio::orchestra::api::Jack::jackShutdown(void* _userData) {
 	if (myClass->isStreamRunning() == false) {
 		return;
 	}
-	ETK_NEW(ethread::Thread, [=](){myClass->closeStream();});
-	ATA_ERROR("The Jack server is shutting down this client ... stream stopped and closed!!");
+	myClass->controlPush(audio::orchestra::api::JackPrivate::control_close);
 }
 
 int32_t audio::orchestra::api::Jack::jackXrun(void* _userData) {
@@ -274,6 +461,11 @@ bool audio::orchestra::api::Jack::open(uint32_t _device,
 			ATA_ERROR("Jack server not found or connection error!");
 			return false;
 		}
+		if (m_reconnect == true) {
+			// The client, the ports and the connections are not restored: jackShutdown close the stream.
+			ATA_WARNING("Jack does not support StreamOptions::reconnect: the stream is closed when the server is lost");
+			m_reconnect = false;
+		}
 	} else {
 		// The handle must have been created on an earlier pass.
 		client = m_private->client;
@@ -329,9 +521,12 @@ bool audio::orchestra::api::Jack::open(uint32_t _device,
 	// Check the jack server sample rate.
 	uint32_t jackRate = jack_get_sample_rate(client);
 	if (_sampleRate != jackRate) {
-		jack_client_close(client);
-		ATA_ERROR("the requested sample rate (" << _sampleRate << ") is different than the JACK server rate (" << jackRate << ").");
-		return false;
+		if (_options.resampling == audio::orchestra::resamplerQuality_none) {
+			jack_client_close(client);
+			ATA_ERROR("the requested sample rate (" << _sampleRate << ") is different than the JACK server rate (" << jackRate << ").");
+			return false;
+		}
+		ATA_INFO("the requested sample rate (" << _sampleRate << ") is different than the JACK server rate (" << jackRate << ") ==> resample");
 	}
 	m_sampleRate = jackRate;
 	// Get the latency of the JACK port.
@@ -359,30 +554,60 @@ bool audio::orchestra::api::Jack::open(uint32_t _device,
 	// (periods) is set when the jack server is started.
 	m_bufferSize = (int) jack_get_buffer_size(client);
 	*_bufferSize = m_bufferSize;
+	m_nBuffers = 1;
+	m_bufferLatency = uint64_t(m_bufferSize) * 1000000LL / uint64_t(m_sampleRate);
+	if (    _options.getTargetLatency() != 0
+	     && _options.getTargetLatency() < m_bufferLatency) {
+		ATA_WARNING("The target latency (" << _options.getTargetLatency() << "us) is lower than the jack server period (" << m_bufferLatency << "us): it can only be changed in the server configuration");
+	}
+	// The server can change the period while the stream is running: allocate the buffers for the biggest size.
+	if (m_private->bufferSizeMax < jackMaxBufferSize) {
+		m_private->bufferSizeMax = jackMaxBufferSize;
+	}
+	if (m_private->bufferSizeMax < m_bufferSize) {
+		m_private->bufferSizeMax = m_bufferSize;
+	}
+	m_private->bufferSizeChange = false;
 	m_nDeviceChannels[modeToIdTable(_mode)] = _channels;
 	m_nUserChannels[modeToIdTable(_mode)] = _channels;
 	// Set flags for buffer conversion.
 	m_doConvertBuffer[modeToIdTable(_mode)] = false;
-	if (m_userFormat != m_deviceFormat[modeToIdTable(_mode)]) {
-		m_doConvertBuffer[modeToIdTable(_mode)] = true;
-		ATA_CRITICAL("Can not update format ==> use RIVER lib for this ...");
-	}
-	if (    m_deviceInterleaved[modeToIdTable(_mode)] == false
-	     && m_nUserChannels[modeToIdTable(_mode)] > 1) {
-		ATA_ERROR("Reorder channel for the interleaving properties ...");
-		m_doConvertBuffer[modeToIdTable(_mode)] = true;
+	m_private->planar = _options.flags.m_planar;
+	if (m_private->planar == true) {
+		// The jack port buffers are directly given to the user ==> no conversion availlable.
+		if (m_userFormat != m_deviceFormat[modeToIdTable(_mode)]) {
+			ATA_ERROR("planar mode is only availlable with the jack format: " << m_deviceFormat[modeToIdTable(_mode)]);
+			if (client != m_private->client) {
+				// The client is not yet stored in the stream (first pass): close it here.
+				jack_client_close(client);
+			}
+			return false;
+		}
+		m_private->portBuffer[modeToIdTable(_mode)].resize(_channels, null);
+	} else {
+		if (m_userFormat != m_deviceFormat[modeToIdTable(_mode)]) {
+			m_doConvertBuffer[modeToIdTable(_mode)] = true;
+			ATA_CRITICAL("Can not update format ==> use RIVER lib for this ...");
+		}
+		if (    m_deviceInterleaved[modeToIdTable(_mode)] == false
+		     && m_nUserChannels[modeToIdTable(_mode)] > 1) {
+			ATA_ERROR("Reorder channel for the interleaving properties ...");
+			m_doConvertBuffer[modeToIdTable(_mode)] = true;
+		}
 	}
 	// Allocate our JackHandle structure for the stream.
 	m_private->client = client;
 	m_private->deviceName[modeToIdTable(_mode)] = deviceName;
 	// Allocate necessary internal buffers.
 	uint64_t bufferBytes;
-	bufferBytes = m_nUserChannels[modeToIdTable(_mode)] * *_bufferSize * audio::getFormatBytes(m_deviceFormat[modeToIdTable(_mode)]);
-	ATA_VERBOSE("allocate : nbChannel=" << m_nUserChannels[modeToIdTable(_mode)] << " bufferSize=" << *_bufferSize << " format=" << m_deviceFormat[modeToIdTable(_mode)] << "=" << audio::getFormatBytes(m_deviceFormat[modeToIdTable(_mode)]));
-	m_userBuffer[modeToIdTable(_mode)].resize(bufferBytes, 0);
-	if (m_userBuffer[modeToIdTable(_mode)].size() == 0) {
-		ATA_ERROR("error allocating user buffer memory.");
-		goto error;
+	bufferBytes = m_nUserChannels[modeToIdTable(_mode)] * m_private->bufferSizeMax * audio::getFormatBytes(m_deviceFormat[modeToIdTable(_mode)]);
+	ATA_VERBOSE("allocate : nbChannel=" << m_nUserChannels[modeToIdTable(_mode)] << " bufferSize=" << m_private->bufferSizeMax << " format=" << m_deviceFormat[modeToIdTable(_mode)] << "=" << audio::getFormatBytes(m_deviceFormat[modeToIdTable(_mode)]));
+	if (m_private->planar == false) {
+		m_userBuffer[modeToIdTable(_mode)].resize(bufferBytes, 0);
+		if (m_userBuffer[modeToIdTable(_mode)].size() == 0) {
+			ATA_ERROR("error allocating user buffer memory.");
+			goto error;
+		}
 	}
 	if (m_doConvertBuffer[modeToIdTable(_mode)]) {
 		bool makeBuffer = true;
@@ -390,7 +615,7 @@ bool audio::orchestra::api::Jack::open(uint32_t _device,
 			bufferBytes = m_nDeviceChannels[0] * audio::getFormatBytes(m_deviceFormat[0]);
 		} else { // _mode == audio::orchestra::mode_input
 			bufferBytes = m_nDeviceChannels[1] * audio::getFormatBytes(m_deviceFormat[1]);
-			if (m_mode == audio::orchestra::mode_output && m_deviceBuffer) {
+			if (m_mode == audio::orchestra::mode_output && m_deviceBuffer.size() != 0) {
 				uint64_t bytesOut = m_nDeviceChannels[0] * audio::getFormatBytes(m_deviceFormat[0]);
 				if (bufferBytes < bytesOut) {
 					makeBuffer = false;
@@ -398,10 +623,10 @@ bool audio::orchestra::api::Jack::open(uint32_t _device,
 			}
 		}
 		if (makeBuffer) {
-			bufferBytes *= *_bufferSize;
-			if (m_deviceBuffer) free(m_deviceBuffer);
-			m_deviceBuffer = (char *) calloc(bufferBytes, 1);
-			if (m_deviceBuffer == null) {
+			bufferBytes *= m_private->bufferSizeMax;
+			m_deviceBuffer.clear();
+			m_deviceBuffer.resize(bufferBytes, 0);
+			if (m_deviceBuffer.size() == 0) {
 				ATA_ERROR("error allocating device buffer memory.");
 				goto error;
 			}
@@ -422,8 +647,13 @@ bool audio::orchestra::api::Jack::open(uint32_t _device,
 		m_mode = audio::orchestra::mode_duplex;
 	} else {
 		m_mode = _mode;
+		if (controlStart() == false) {
+			goto error;
+		}
 		jack_set_process_callback(m_private->client, &audio::orchestra::api::Jack::jackCallbackHandler, this);
 		jack_set_xrun_callback(m_private->client, &audio::orchestra::api::Jack::jackXrun, this);
+		jack_set_buffer_size_callback(m_private->client, &audio::orchestra::api::Jack::jackBufferSize, this);
+		jack_set_latency_callback(m_private->client, &audio::orchestra::api::Jack::jackLatency, this);
 		jack_on_shutdown(m_private->client, &audio::orchestra::api::Jack::jackShutdown, this);
 	}
 	// Register our ports.
@@ -451,11 +681,12 @@ bool audio::orchestra::api::Jack::open(uint32_t _device,
 	// buffers to do channel offsets, so we override that parameter
 	// here.
 	if (m_doConvertBuffer[modeToIdTable(_mode)]) {
-		setConvertInfo(_mode, 0);
+		setConvertInfo(_mode, 0, m_private->bufferSizeMax);
 	}
 	return true;
 error:
 	jack_client_close(m_private->client);
+	controlStop();
 	if (m_private->ports[0] != null) {
 		free(m_private->ports[0]);
 		m_private->ports[0] = null;
@@ -466,15 +697,19 @@ error:
 	}
 	for (int32_t iii=0; iii<2; ++iii) {
 		m_userBuffer[iii].clear();
+		m_private->portBuffer[iii].clear();
 	}
-	if (m_deviceBuffer) {
-		free(m_deviceBuffer);
-		m_deviceBuffer = null;
-	}
+	m_deviceBuffer.clear();
 	return false;
 }
 
 enum audio::orchestra::error audio::orchestra::api::Jack::closeStream() {
+	// Stop the control thread first: it can not close the stream in parallel.
+	controlStop();
+	return closeStreamLocal();
+}
+
+enum audio::orchestra::error audio::orchestra::api::Jack::closeStreamLocal() {
 	if (m_state == audio::orchestra::state::closed) {
 		ATA_ERROR("no open stream to close!");
 		return audio::orchestra::error_warning;
@@ -495,11 +730,9 @@ enum audio::orchestra::error audio::orchestra::api::Jack::closeStream() {
 	}
 	for (int32_t i=0; i<2; i++) {
 		m_userBuffer[i].clear();
+		m_private->portBuffer[i].clear();
 	}
-	if (m_deviceBuffer) {
-		free(m_deviceBuffer);
-		m_deviceBuffer = null;
-	}
+	m_deviceBuffer.clear();
 	m_mode = audio::orchestra::mode_unknow;
 	m_state = audio::orchestra::state::closed;
 	return audio::orchestra::error_none;
@@ -619,14 +852,19 @@ bool audio::orchestra::api::Jack::callbackEvent(uint64_t _nframes) {
 		return false;
 	}
 	if (m_bufferSize != _nframes) {
-		ATA_ERROR("the JACK buffer size has changed ... cannot process!");
-		return false;
+		// The buffer size callback is called before, but the process use the real value.
+		if (_nframes > m_private->bufferSizeMax) {
+			ATA_ERROR("the JACK buffer size has changed over the preallocated size ... cannot process!");
+			return false;
+		}
+		m_bufferSize = _nframes;
+		m_private->bufferSizeChange = true;
 	}
 	// Check if we were draining the stream and signal is finished.
 	if (m_private->drainCounter > 3) {
 		m_state = audio::orchestra::state::stopping;
 		if (m_private->internalDrain == true) {
-			ETK_NEW(ethread::Thread, [&](){stopStream();}, "Jack_stopStream");
+			controlPush(audio::orchestra::api::JackPrivate::control_stop);
 		} else {
 			m_private->m_semaphore.post();
 		}
@@ -634,8 +872,19 @@ bool audio::orchestra::api::Jack::callbackEvent(uint64_t _nframes) {
 	}
 	// Invoke user callback first, to get fresh output data.
 	if (m_private->drainCounter == 0) {
-		audio::Time streamTime = getStreamTime();
-		etk::Vector<enum audio::orchestra::status> status;
+		// Timestamps from the jack clock: the first output sample is played after the playback latency,
+		// the first input sample has been captured before the capture latency.
+		jack_nframes_t frameTime = jack_last_frame_time(m_private->client);
+		uint64_t latencyOutput = __atomic_load_n(&m_latency[0], __ATOMIC_ACQUIRE);
+		uint64_t latencyInput = __atomic_load_n(&m_latency[1], __ATOMIC_ACQUIRE);
+		if (m_private->planar == false) {
+			// the input buffer has been copied at the end of the previous cycle.
+			latencyInput += m_bufferSize;
+		}
+		audio::Time timeOutput = frameToTime(frameTime + jack_nframes_t(latencyOutput));
+		audio::Time timeInput = frameToTime(frameTime - jack_nframes_t(latencyInput));
+		etk::Vector<enum audio::orchestra::status>& status = m_private->status;
+		status.clear();
 		if (m_mode != audio::orchestra::mode_input && m_private->xrun[0] == true) {
 			status.pushBack(audio::orchestra::status::underflow);
 			m_private->xrun[0] = false;
@@ -644,16 +893,39 @@ bool audio::orchestra::api::Jack::callbackEvent(uint64_t _nframes) {
 			status.pushBack(audio::orchestra::status::overflow);
 			m_private->xrun[1] = false;
 		}
-		int32_t cbReturnValue = m_callback(&m_userBuffer[1][0],
-		                                   streamTime,
-		                                   &m_userBuffer[0][0],
-		                                   streamTime,
+		if (m_private->bufferSizeChange == true) {
+			status.pushBack(audio::orchestra::status::bufferSizeChange);
+			m_private->bufferSizeChange = false;
+		}
+		void* inputBuffer = null;
+		void* outputBuffer = null;
+		if (m_private->planar == false) {
+			inputBuffer = &m_userBuffer[1][0];
+			outputBuffer = &m_userBuffer[0][0];
+		} else {
+			// Zero-copy: the user read and write directly in the jack port buffers.
+			for (int32_t iii=0; iii<2; ++iii) {
+				for (size_t jjj=0; jjj<m_private->portBuffer[iii].size(); ++jjj) {
+					m_private->portBuffer[iii][jjj] = (jack_default_audio_sample_t *) jack_port_get_buffer(m_private->ports[iii][jjj], (jack_nframes_t) _nframes);
+				}
+			}
+			if (m_private->portBuffer[0].size() != 0) {
+				outputBuffer = &m_private->portBuffer[0][0];
+			}
+			if (m_private->portBuffer[1].size() != 0) {
+				inputBuffer = &m_private->portBuffer[1][0];
+			}
+		}
+		int32_t cbReturnValue = m_callback(inputBuffer,
+		                                   timeInput,
+		                                   outputBuffer,
+		                                   timeOutput,
 		                                   m_bufferSize,
 		                                   status);
 		if (cbReturnValue == 2) {
 			m_state = audio::orchestra::state::stopping;
 			m_private->drainCounter = 2;
-			ETK_NEW(ethread::Thread, [&](){stopStream();}, "Jack_stopStream2");
+			controlPush(audio::orchestra::api::JackPrivate::control_stop);
 			return true;
 		}
 		else if (cbReturnValue == 1) {
@@ -663,6 +935,8 @@ bool audio::orchestra::api::Jack::callbackEvent(uint64_t _nframes) {
 	}
 	jack_default_audio_sample_t *jackbuffer;
 	uint64_t bufferBytes = _nframes * sizeof(jack_default_audio_sample_t);
+	// the internal buffers are allocated for the maximum size:
+	uint64_t bufferStride = m_private->bufferSizeMax * sizeof(jack_default_audio_sample_t);
 	if (    m_mode == audio::orchestra::mode_output
 	     || m_mode == audio::orchestra::mode_duplex) {
 		if (m_private->drainCounter > 1) { // write zeros to the output stream
@@ -670,16 +944,18 @@ bool audio::orchestra::api::Jack::callbackEvent(uint64_t _nframes) {
 				jackbuffer = (jack_default_audio_sample_t *) jack_port_get_buffer(m_private->ports[0][i], (jack_nframes_t) _nframes);
 				memset(jackbuffer, 0, bufferBytes);
 			}
+		} else if (m_private->planar == true) {
+			// Nothing to do: the user write directly in the jack port buffers.
 		} else if (m_doConvertBuffer[0]) {
-			convertBuffer(m_deviceBuffer, &m_userBuffer[0][0], m_convertInfo[0]);
+			convertBuffer(&m_deviceBuffer[0], &m_userBuffer[0][0], m_convertInfo[0]);
 			for (uint32_t i=0; i<m_nDeviceChannels[0]; i++) {
 				jackbuffer = (jack_default_audio_sample_t *) jack_port_get_buffer(m_private->ports[0][i], (jack_nframes_t) _nframes);
-				memcpy(jackbuffer, &m_deviceBuffer[i*bufferBytes], bufferBytes);
+				memcpy(jackbuffer, &m_deviceBuffer[i*bufferStride], bufferBytes);
 			}
 		} else { // no buffer conversion
 			for (uint32_t i=0; i<m_nUserChannels[0]; i++) {
 				jackbuffer = (jack_default_audio_sample_t *) jack_port_get_buffer(m_private->ports[0][i], (jack_nframes_t) _nframes);
-				memcpy(jackbuffer, &m_userBuffer[0][i*bufferBytes], bufferBytes);
+				memcpy(jackbuffer, &m_userBuffer[0][i*bufferStride], bufferBytes);
 			}
 		}
 		if (m_private->drainCounter) {
@@ -687,23 +963,26 @@ bool audio::orchestra::api::Jack::callbackEvent(uint64_t _nframes) {
 			goto unlock;
 		}
 	}
-	if (    m_mode == audio::orchestra::mode_input
-	     || m_mode == audio::orchestra::mode_duplex) {
+	if (    m_private->planar == false
+	     && (    m_mode == audio::orchestra::mode_input
+	          || m_mode == audio::orchestra::mode_duplex)) {
 		if (m_doConvertBuffer[1]) {
 			for (uint32_t i=0; i<m_nDeviceChannels[1]; i++) {
 				jackbuffer = (jack_default_audio_sample_t *) jack_port_get_buffer(m_private->ports[1][i], (jack_nframes_t) _nframes);
-				memcpy(&m_deviceBuffer[i*bufferBytes], jackbuffer, bufferBytes);
+				memcpy(&m_deviceBuffer[i*bufferStride], jackbuffer, bufferBytes);
 			}
-			convertBuffer(&m_userBuffer[1][0], m_deviceBuffer, m_convertInfo[1]);
+			convertBuffer(&m_userBuffer[1][0], &m_deviceBuffer[0], m_convertInfo[1]);
 		} else {
 			// no buffer conversion
 			for (uint32_t i=0; i<m_nUserChannels[1]; i++) {
 				jackbuffer = (jack_default_audio_sample_t *) jack_port_get_buffer(m_private->ports[1][i], (jack_nframes_t) _nframes);
-				memcpy(&m_userBuffer[1][i*bufferBytes], jackbuffer, bufferBytes);
+				memcpy(&m_userBuffer[1][i*bufferStride], jackbuffer, bufferBytes);
 			}
 		}
 	}
 unlock:
+	// Note: the stream time came from the jack clock, the clock estimator is fed with the jack time of the period.
+	m_periodTime = frameToTime(jack_last_frame_time(m_private->client));
 	audio::orchestra::Api::tickStreamTime();
 	return true;
 }
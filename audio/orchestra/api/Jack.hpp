@@ -29,6 +29,13 @@ namespace audio {
 					enum audio::orchestra::error stopStream();
 					enum audio::orchestra::error abortStream();
 					long getStreamLatency();
+					audio::Time getStreamTime();
+					bool isPlanarSupported() {
+						return true;
+					}
+					uint32_t getBufferSizeMax() const;
+					bool startDeviceMonitor(audio::orchestra::DeviceEventCallback _callback);
+					void stopDeviceMonitor();
 					// This function is intended for internal use only.	It must be
 					// public because it is called by the internal callback handler,
 					// which is not a member of RtAudio.	External use of this function
@@ -38,6 +45,37 @@ namespace audio {
 					static int32_t jackXrun(void* _userData);
 					static void jackShutdown(void* _userData);
 					static int32_t jackCallbackHandler(jack_nframes_t _nframes, void* _userData);
+					static int32_t jackBufferSize(jack_nframes_t _nframes, void* _userData);
+					static void jackLatency(jack_latency_callback_mode_t _mode, void* _userData);
+					/**
+					 * @brief Convert a jack frame time in a stream timestamp (with the jack server clock).
+					 * @param[in] _frame Jack frame time.
+					 * @return The corresponding time.
+					 */
+					audio::Time frameToTime(jack_nframes_t _frame);
+				private:
+					/**
+					 * @brief Create the control thread (called in the user context, never in the jack process callback).
+					 * @return true if the thread is started.
+					 */
+					bool controlStart();
+					/**
+					 * @brief Stop and join the control thread.
+					 */
+					void controlStop();
+					/**
+					 * @brief Request an action to the control thread (wait-free and allocation-free, can be call from the jack process callback).
+					 * @param[in] _command Bit-field of the action to do (JackPrivate::control_*).
+					 */
+					void controlPush(uint32_t _command);
+					/**
+					 * @brief Control thread main loop.
+					 */
+					void controlEvent();
+					/**
+					 * @brief Close the stream without stopping the control thread.
+					 */
+					enum audio::orchestra::error closeStreamLocal();
 				private:
 					ememory::SharedPtr<JackPrivate> m_private;
 					bool open(uint32_t _device,
@@ -0,0 +1,135 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license APACHE v2.0 (see license file)
+ */
+
+#if defined(ORCHESTRA_BUILD_JACK)
+
+#include <audio/orchestra/debug.hpp>
+#include <audio/orchestra/api/JackMonitor.hpp>
+extern "C" {
+	#include <stdlib.h>
+	#include <string.h>
+}
+
+audio::orchestra::api::JackMonitor::JackMonitor() :
+  m_client(null) {
+	
+}
+
+audio::orchestra::api::JackMonitor::~JackMonitor() {
+	stop();
+}
+
+bool audio::orchestra::api::JackMonitor::start(audio::orchestra::DeviceEventCallback _callback) {
+	stop();
+	jack_options_t options = (jack_options_t) (JackNoStartServer);
+	jack_status_t *status = null;
+	m_client = jack_client_open("orchestraMonitor", options, status);
+	if (m_client == null) {
+		ATA_ERROR("Jack monitor: server not found or connection error!");
+		return false;
+	}
+	m_callback = _callback;
+	// Initial list: the callback is not active yet.
+	const char **ports = jack_get_ports(m_client, null, JACK_DEFAULT_AUDIO_TYPE, 0);
+	if (ports != null) {
+		for (size_t iii=0; ports[iii] != null; ++iii) {
+			updatePort(jack_port_by_name(m_client, ports[iii]), true, false);
+		}
+		jack_free(ports);
+	}
+	if (    jack_set_port_registration_callback(m_client, &audio::orchestra::api::JackMonitor::jackPortRegistration, this) != 0
+	     || jack_activate(m_client) != 0) {
+		ATA_ERROR("Jack monitor: can not register the port callback");
+		stop();
+		return false;
+	}
+	ATA_DEBUG("Jack monitor: " << m_devices.size() << " devices");
+	return true;
+}
+
+void audio::orchestra::api::JackMonitor::stop() {
+	if (m_client != null) {
+		// jack_client_close wait the end of the notification thread.
+		jack_client_close(m_client);
+		m_client = null;
+	}
+	m_devices.clear();
+	m_callback = null;
+}
+
+void audio::orchestra::api::JackMonitor::jackPortRegistration(jack_port_id_t _port, int _register, void* _userData) {
+	audio::orchestra::api::JackMonitor* myClass = static_cast<audio::orchestra::api::JackMonitor*>(_userData);
+	myClass->updatePort(jack_port_by_id(myClass->m_client, _port), _register != 0, true);
+}
+
+void audio::orchestra::api::JackMonitor::updatePort(jack_port_t* _port, bool _register, bool _notify) {
+	if (_port == null) {
+		return;
+	}
+	const char* type = jack_port_type(_port);
+	if (    type == null
+	     || strcmp(type, JACK_DEFAULT_AUDIO_TYPE) != 0) {
+		return;
+	}
+	etk::String name = jack_port_name(_port);
+	size_t iColon = name.find(":");
+	if (iColon == etk::String::npos) {
+		return;
+	}
+	name = name.extract(0, iColon);
+	// The ports of the jack outputs are read by a capture stream.
+	int32_t idTable = 0;
+	enum audio::orchestra::mode mode = audio::orchestra::mode_output;
+	if ((jack_port_flags(_port) & JackPortIsOutput) != 0) {
+		idTable = 1;
+		mode = audio::orchestra::mode_input;
+	}
+	auto it = m_devices.begin();
+	while (    it != m_devices.end()
+	        && it->name != name) {
+		++it;
+	}
+	if (it == m_devices.end()) {
+		if (_register == false) {
+			return;
+		}
+		audio::orchestra::api::JackMonitorDevice device;
+		device.name = name;
+		device.nbPort[0] = 0;
+		device.nbPort[1] = 0;
+		m_devices.pushBack(device);
+		it = m_devices.end() - 1;
+	}
+	enum audio::orchestra::deviceEvent event;
+	if (_register == true) {
+		it->nbPort[idTable]++;
+		if (it->nbPort[idTable] != 1) {
+			return;
+		}
+		event = audio::orchestra::deviceEvent_added;
+	} else {
+		if (it->nbPort[idTable] == 0) {
+			return;
+		}
+		it->nbPort[idTable]--;
+		if (it->nbPort[idTable] != 0) {
+			return;
+		}
+		event = audio::orchestra::deviceEvent_removed;
+		if (it->nbPort[1-idTable] == 0) {
+			m_devices.erase(it);
+		}
+	}
+	if (_notify == false) {
+		return;
+	}
+	ATA_INFO("Jack monitor: " << event << " '" << name << "' (" << mode << ")");
+	if (m_callback != null) {
+		m_callback(event, name, mode);
+	}
+}
+
+#endif
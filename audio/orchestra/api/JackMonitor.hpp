@@ -0,0 +1,62 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license APACHE v2.0 (see license file)
+ */
+#pragma once
+#ifdef ORCHESTRA_BUILD_JACK
+
+#include <jack/jack.h>
+#include <etk/types.hpp>
+#include <etk/String.hpp>
+#include <etk/Vector.hpp>
+#include <audio/orchestra/DeviceEvent.hpp>
+
+namespace audio {
+	namespace orchestra {
+		namespace api {
+			/**
+			 * @brief Jack client seen as a device by the monitor (a device exist while the client has audio ports).
+			 */
+			class JackMonitorDevice {
+				public:
+					etk::String name; //!< Name of the client (device name of the Jack API)
+					uint32_t nbPort[2]; //!< Number of audio ports: [0] playback (jack input), [1] capture (jack output)
+			};
+			/**
+			 * @brief Hot-plug monitor of the jack server (port registration callback of a dedicated client).
+			 * The events are received on the notification thread of the jack client (non real-time).
+			 */
+			class JackMonitor {
+				private:
+					audio::orchestra::DeviceEventCallback m_callback; //!< User callback
+					jack_client_t* m_client;
+					etk::Vector<audio::orchestra::api::JackMonitorDevice> m_devices; //!< Clients that have audio ports
+				public:
+					JackMonitor();
+					~JackMonitor();
+					/**
+					 * @brief Connect to the server and register the port callback.
+					 * @param[in] _callback Function called on each event (on the jack notification thread).
+					 * @return false if the server is not running.
+					 */
+					bool start(audio::orchestra::DeviceEventCallback _callback);
+					/**
+					 * @brief Close the monitor client (the callback is not called anymore).
+					 */
+					void stop();
+				private:
+					static void jackPortRegistration(jack_port_id_t _port, int _register, void* _userData);
+					/**
+					 * @brief Update the number of ports of a client.
+					 * @param[in] _port Port registered or unregistered.
+					 * @param[in] _register true if the port is registered.
+					 * @param[in] _notify Report the device events (false for the initial list).
+					 */
+					void updatePort(jack_port_t* _port, bool _register, bool _notify);
+			};
+		}
+	}
+}
+
+#endif
@@ -19,6 +19,7 @@ extern "C" {
 #include <ethread/tools.hpp>
 #include <audio/orchestra/api/PulseDeviceList.hpp>
 #include <audio/orchestra/api/Pulse.hpp>
+#include <audio/orchestra/api/PulseMonitor.hpp>
 
 ememory::SharedPtr<audio::orchestra::Api> audio::orchestra::api::Pulse::create() {
 	return ememory::SharedPtr<audio::orchestra::api::Pulse>(ETK_NEW(audio::orchestra::api::Pulse));
@@ -47,6 +48,8 @@ static const rtaudio_pa_format_mapping_t supported_sampleformats[] = {
 	{audio::format_float, PA_SAMPLE_FLOAT32LE},
 	{audio::format_unknow, PA_SAMPLE_INVALID}};
 
+static const int32_t reconnectRetryMs = 5; //!< Delay between two connection tries when the server is lost
+
 
 namespace audio {
 	namespace orchestra {
@@ -58,10 +61,15 @@ namespace audio {
 					bool threadRunning;
 					ethread::Semaphore m_semaphore;
 					bool runnable;
+					pa_buffer_attr bufferAttr; //!< Buffering requested to the server
+					bool useBufferAttr; //!< A buffering is requested (latency class or number of buffers)
+					pa_sample_spec sampleSpec; //!< Format of the stream (used to reconnect it)
+					ememory::SharedPtr<audio::orchestra::api::PulseMonitor> monitor; //!< Hot-plug monitor (null if not requested)
 					PulsePrivate() :
 					  handle(0),
 					  threadRunning(false),
-					  runnable(false) {
+					  runnable(false),
+					  useBufferAttr(false) {
 						
 					}
 			};
@@ -74,6 +82,7 @@ audio::orchestra::api::Pulse::Pulse() :
 }
 
 audio::orchestra::api::Pulse::~Pulse() {
+	stopDeviceMonitor();
 	if (m_state != audio::orchestra::state::closed) {
 		closeStream();
 	}
@@ -97,10 +106,30 @@ audio::orchestra::DeviceInfo audio::orchestra::api::Pulse::getDeviceInfo(uint32_
 	return list[_device];
 }
 
+bool audio::orchestra::api::Pulse::startDeviceMonitor(audio::orchestra::DeviceEventCallback _callback) {
+	stopDeviceMonitor();
+	ememory::SharedPtr<audio::orchestra::api::PulseMonitor> monitor = ememory::makeShared<audio::orchestra::api::PulseMonitor>();
+	if (    monitor == null
+	     || monitor->start(_callback) == false) {
+		return false;
+	}
+	m_private->monitor = monitor;
+	return true;
+}
+
+void audio::orchestra::api::Pulse::stopDeviceMonitor() {
+	if (m_private->monitor == null) {
+		return;
+	}
+	m_private->monitor->stop();
+	m_private->monitor.reset();
+}
+
 
 
 void audio::orchestra::api::Pulse::callbackEvent() {
 	ethread::setName("Pulse IO-" + m_name);
+	configureIoThread();
 	while (m_private->threadRunning == true) {
 		callbackEventOneCycle();
 	}
@@ -115,11 +144,13 @@ enum audio::orchestra::error audio::orchestra::api::Pulse::closeStream() {
 	}
 	m_mutex.unLock();
 	m_private->thread->join();
-	if (m_mode == audio::orchestra::mode_output) {
-		pa_simple_flush(m_private->handle, null);
+	if (m_private->handle != null) {
+		if (m_mode == audio::orchestra::mode_output) {
+			pa_simple_flush(m_private->handle, null);
+		}
+		pa_simple_free(m_private->handle);
+		m_private->handle = null;
 	}
-	pa_simple_free(m_private->handle);
-	m_private->handle = null;
 	m_userBuffer[0].clear();
 	m_userBuffer[1].clear();
 	m_state = audio::orchestra::state::closed;
@@ -154,8 +185,8 @@ void audio::orchestra::api::Pulse::callbackEventOneCycle() {
 		return;
 	}
 	m_mutex.lock();
-	void *pulse_in = m_doConvertBuffer[audio::orchestra::modeToIdTable(audio::orchestra::mode_input)] ? m_deviceBuffer : &m_userBuffer[audio::orchestra::modeToIdTable(audio::orchestra::mode_input)][0];
-	void *pulse_out = m_doConvertBuffer[audio::orchestra::modeToIdTable(audio::orchestra::mode_output)] ? m_deviceBuffer : &m_userBuffer[audio::orchestra::modeToIdTable(audio::orchestra::mode_output)][0];
+	void *pulse_in = m_doConvertBuffer[audio::orchestra::modeToIdTable(audio::orchestra::mode_input)] ? &m_deviceBuffer[0] : &m_userBuffer[audio::orchestra::modeToIdTable(audio::orchestra::mode_input)][0];
+	void *pulse_out = m_doConvertBuffer[audio::orchestra::modeToIdTable(audio::orchestra::mode_output)] ? &m_deviceBuffer[0] : &m_userBuffer[audio::orchestra::modeToIdTable(audio::orchestra::mode_output)][0];
 	if (m_state != audio::orchestra::state::running) {
 		goto unLock;
 	}
@@ -163,7 +194,7 @@ void audio::orchestra::api::Pulse::callbackEventOneCycle() {
 	size_t bytes;
 	if (m_mode == audio::orchestra::mode_output) {
 		if (m_doConvertBuffer[audio::orchestra::modeToIdTable(audio::orchestra::mode_output)]) {
-			convertBuffer(m_deviceBuffer,
+			convertBuffer(&m_deviceBuffer[0],
 			              &m_userBuffer[audio::orchestra::modeToIdTable(audio::orchestra::mode_output)][0],
 			              m_convertInfo[audio::orchestra::modeToIdTable(audio::orchestra::mode_output)]);
 			bytes = m_nDeviceChannels[audio::orchestra::modeToIdTable(audio::orchestra::mode_output)] * m_bufferSize * audio::getFormatBytes(m_deviceFormat[audio::orchestra::modeToIdTable(audio::orchestra::mode_output)]);
@@ -172,6 +203,8 @@ void audio::orchestra::api::Pulse::callbackEventOneCycle() {
 		}
 		if (pa_simple_write(m_private->handle, pulse_out, bytes, &pa_error) < 0) {
 			ATA_ERROR("audio write error, " << pa_strerror(pa_error) << ".");
+			m_mutex.unLock();
+			reconnect();
 			return;
 		}
 	}
@@ -183,11 +216,13 @@ void audio::orchestra::api::Pulse::callbackEventOneCycle() {
 		}
 		if (pa_simple_read(m_private->handle, pulse_in, bytes, &pa_error) < 0) {
 			ATA_ERROR("audio read error, " << pa_strerror(pa_error) << ".");
+			m_mutex.unLock();
+			reconnect();
 			return;
 		}
 		if (m_doConvertBuffer[audio::orchestra::modeToIdTable(audio::orchestra::mode_input)]) {
 			convertBuffer(&m_userBuffer[audio::orchestra::modeToIdTable(audio::orchestra::mode_input)][0],
-			              m_deviceBuffer,
+			              &m_deviceBuffer[0],
 			              m_convertInfo[audio::orchestra::modeToIdTable(audio::orchestra::mode_input)]);
 		}
 	}
@@ -201,6 +236,61 @@ unLock:
 	return;
 }
 
+bool audio::orchestra::api::Pulse::reconnect() {
+	int32_t idTable = audio::orchestra::modeToIdTable(m_mode);
+	pa_stream_direction_t direction = PA_STREAM_PLAYBACK;
+	const char* streamName = "Playback";
+	if (m_mode == audio::orchestra::mode_input) {
+		direction = PA_STREAM_RECORD;
+		streamName = "Record";
+	}
+	audio::Time lossTime = audio::Time::now();
+	audio::Duration timeout(0, int64_t(m_reconnectTimeout)*1000000LL);
+	pa_simple* handle = null;
+	if (m_reconnect == true) {
+		ATA_WARNING("PulseAudio connection lost: try to reconnect (timeout=" << m_reconnectTimeout << "ms)");
+	}
+	while (    m_reconnect == true
+	        && m_private->threadRunning == true) {
+		int32_t error;
+		// First the default device of the server, then the fallback devices.
+		for (int32_t iii=-1; iii<int32_t(m_fallbackDeviceName[idTable].size()) && handle == null; ++iii) {
+			const char* device = null;
+			if (iii >= 0) {
+				device = m_fallbackDeviceName[idTable][iii].c_str();
+			}
+			handle = pa_simple_new(null, "orchestra", direction, device, streamName, &m_private->sampleSpec, null, (m_private->useBufferAttr == true ? &m_private->bufferAttr : null), &error);
+		}
+		if (handle != null) {
+			break;
+		}
+		if (timeout <= audio::Time::now() - lossTime) {
+			break;
+		}
+		ethread::sleepMilliSeconds(reconnectRetryMs);
+	}
+	m_mutex.lock();
+	pa_simple_free(m_private->handle);
+	m_private->handle = handle;
+	if (handle == null) {
+		// The stream is dead: the thread wait on the semaphore until the stream is closed.
+		ATA_ERROR("The stream is disconnected from PulseAudio ==> stop the stream");
+		m_state = audio::orchestra::state::stopped;
+		m_private->runnable = false;
+		m_mutex.unLock();
+		return false;
+	}
+	m_mutex.unLock();
+	ATA_INFO("PulseAudio stream reconnected after " << (audio::Time::now() - lossTime));
+	int32_t ret = fillStreamGap(audio::Time::now() - lossTime);
+	if (ret == 2) {
+		abortStream();
+	} else if (ret == 1) {
+		stopStream();
+	}
+	return true;
+}
+
 enum audio::orchestra::error audio::orchestra::api::Pulse::startStream() {
 	// TODO : Check return ...
 	audio::orchestra::Api::startStream();
@@ -212,6 +302,10 @@ enum audio::orchestra::error audio::orchestra::api::Pulse::startStream() {
 		ATA_ERROR("the stream is already running!");
 		return audio::orchestra::error_warning;
 	}
+	if (m_private->handle == null) {
+		ATA_ERROR("the stream is disconnected from the server!");
+		return audio::orchestra::error_systemError;
+	}
 	m_mutex.lock();
 	m_state = audio::orchestra::state::running;
 	m_private->runnable = true;
@@ -305,6 +399,25 @@ bool audio::orchestra::api::Pulse::open(uint32_t _device,
 			break;
 		}
 	}
+	if (    sr_found == false
+	     && _options.resampling != audio::orchestra::resamplerQuality_none) {
+		// Use the nearest rate supported, the resampling stage convert to the user rate.
+		uint32_t bestRate = 0;
+		for (const uint32_t *sr = SUPPORTED_SAMPLERATES; *sr; ++sr) {
+			uint32_t delta = (*sr > _sampleRate ? *sr - _sampleRate : _sampleRate - *sr);
+			uint32_t bestDelta = (bestRate > _sampleRate ? bestRate - _sampleRate : _sampleRate - bestRate);
+			if (    bestRate == 0
+			     || delta < bestDelta) {
+				bestRate = *sr;
+			}
+		}
+		if (bestRate != 0) {
+			ATA_INFO("unsupported sample rate " << _sampleRate << " ==> open at " << bestRate << " and resample");
+			sr_found = true;
+			m_sampleRate = bestRate;
+			ss.rate = bestRate;
+		}
+	}
 	if (!sr_found) {
 		ATA_ERROR("unsupported sample rate.");
 		return false;
@@ -325,7 +438,6 @@ bool audio::orchestra::api::Pulse::open(uint32_t _device,
 		return false;
 	}
 	m_deviceInterleaved[modeToIdTable(_mode)] = true;
-	m_nBuffers = 1;
 	m_doByteSwap[modeToIdTable(_mode)] = false;
 	m_doConvertBuffer[modeToIdTable(_mode)] = false;
 	m_deviceFormat[modeToIdTable(_mode)] = m_userFormat;
@@ -344,16 +456,16 @@ bool audio::orchestra::api::Pulse::open(uint32_t _device,
 		bool makeBuffer = true;
 		bufferBytes = m_nDeviceChannels[modeToIdTable(_mode)] * audio::getFormatBytes(m_deviceFormat[modeToIdTable(_mode)]);
 		if (_mode == audio::orchestra::mode_input) {
-			if (m_mode == audio::orchestra::mode_output && m_deviceBuffer) {
+			if (m_mode == audio::orchestra::mode_output && m_deviceBuffer.size() != 0) {
 				uint64_t bytesOut = m_nDeviceChannels[0] * audio::getFormatBytes(m_deviceFormat[0]);
 				if (bufferBytes <= bytesOut) makeBuffer = false;
 			}
 		}
 		if (makeBuffer) {
 			bufferBytes *= *_bufferSize;
-			if (m_deviceBuffer) free(m_deviceBuffer);
-			m_deviceBuffer = (char *) calloc(bufferBytes, 1);
-			if (m_deviceBuffer == null) {
+			m_deviceBuffer.clear();
+			m_deviceBuffer.resize(bufferBytes, 0);
+			if (m_deviceBuffer.size() == 0) {
 				ATA_ERROR("error allocating device buffer memory.");
 				goto error;
 			}
@@ -365,16 +477,51 @@ bool audio::orchestra::api::Pulse::open(uint32_t _device,
 		setConvertInfo(_mode, _firstChannel);
 	}
 	int32_t error;
+	{
+		// Map the latency request on the server buffering (pa_simple adjust the latency of the device with it).
+		uint32_t targetLatency = _options.getTargetLatency();
+		if (    targetLatency == 0
+		     && _options.numberOfBuffers > 0) {
+			targetLatency = uint64_t(_options.numberOfBuffers) * uint64_t(m_bufferSize) * 1000000LL / uint64_t(m_sampleRate);
+		}
+		uint32_t frameBytes = m_nDeviceChannels[modeToIdTable(_mode)] * audio::getFormatBytes(m_deviceFormat[modeToIdTable(_mode)]);
+		uint32_t periodBytes = m_bufferSize * frameBytes;
+		m_private->bufferAttr.maxlength = uint32_t(-1);
+		m_private->bufferAttr.tlength = uint32_t(-1);
+		m_private->bufferAttr.prebuf = uint32_t(-1);
+		m_private->bufferAttr.minreq = uint32_t(-1);
+		m_private->bufferAttr.fragsize = uint32_t(-1);
+		m_private->useBufferAttr = false;
+		m_nBuffers = 1;
+		if (targetLatency != 0) {
+			uint32_t targetBytes = pa_usec_to_bytes(targetLatency, &ss);
+			if (targetBytes < periodBytes) {
+				targetBytes = periodBytes;
+			}
+			if (_mode == audio::orchestra::mode_output) {
+				m_private->bufferAttr.tlength = targetBytes;
+				m_private->bufferAttr.minreq = periodBytes;
+			} else {
+				m_private->bufferAttr.fragsize = periodBytes;
+				m_private->bufferAttr.maxlength = targetBytes;
+			}
+			m_private->useBufferAttr = true;
+			m_nBuffers = targetBytes / periodBytes;
+			m_bufferLatency = pa_bytes_to_usec(targetBytes, &ss);
+			ATA_INFO("Pulse buffering: " << m_bufferLatency << "us (target=" << targetLatency << "us) nbBuffers=" << m_nBuffers);
+		}
+	}
+	m_private->sampleSpec = ss;
 	switch (_mode) {
 		case audio::orchestra::mode_input:
-			m_private->handle = pa_simple_new(null, "orchestra", PA_STREAM_RECORD, null, "Record", &ss, null, null, &error);
+			m_private->handle = pa_simple_new(null, "orchestra", PA_STREAM_RECORD, null, "Record", &ss, null, (m_private->useBufferAttr == true ? &m_private->bufferAttr : null), &error);
 			if (m_private->handle == null) {
 				ATA_ERROR("error connecting input to PulseAudio server.");
 				goto error;
 			}
 			break;
 		case audio::orchestra::mode_output:
-			m_private->handle = pa_simple_new(null, "orchestra", PA_STREAM_PLAYBACK, null, "Playback", &ss, null, null, &error);
+			m_private->handle = pa_simple_new(null, "orchestra", PA_STREAM_PLAYBACK, null, "Playback", &ss, null, (m_private->useBufferAttr == true ? &m_private->bufferAttr : null), &error);
 			if (m_private->handle == null) {
 				ATA_ERROR("error connecting output to PulseAudio server.");
 				goto error;
@@ -402,10 +549,7 @@ error:
 	for (int32_t iii=0; iii<2; ++iii) {
 		m_userBuffer[iii].clear();
 	}
-	if (m_deviceBuffer) {
-		free(m_deviceBuffer);
-		m_deviceBuffer = 0;
-	}
+	m_deviceBuffer.clear();
 	return false;
 }
 
@@ -32,6 +32,8 @@ namespace audio {
 					// will most likely produce highly undesireable results!
 					void callbackEventOneCycle();
 					void callbackEvent();
+					bool startDeviceMonitor(audio::orchestra::DeviceEventCallback _callback);
+					void stopDeviceMonitor();
 				private:
 					ememory::SharedPtr<PulsePrivate> m_private;
 					etk::Vector<audio::orchestra::DeviceInfo> m_devices;
@@ -44,6 +46,12 @@ namespace audio {
 					          audio::format _format,
 					          uint32_t *_bufferSize,
 					          const audio::orchestra::StreamOptions& _options);
+					/**
+					 * @brief Connect again the stream to the server after a read/write error (StreamOptions::reconnect).
+					 * The default device is tried first, then the fallback devices, until the reconnect timeout.
+					 * @return true if the stream is connected again, false if it is stopped.
+					 */
+					bool reconnect();
 			};
 		}
 	}
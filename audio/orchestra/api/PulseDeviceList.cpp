@@ -17,6 +17,7 @@ extern "C" {
 #include <audio/Duration.hpp>
 #include <audio/format.hpp>
 #include <etk/stdTools.hpp>
+#include <ethread/Mutex.hpp>
 
 // This callback gets called when our context changes state.  We really only
 // care about when it's ready or if it has failed
@@ -247,8 +248,10 @@ static void callbackGetSourceList(pa_context* _contex, const pa_source_info* _in
 // to not update all the time ...
 static etk::Vector<audio::orchestra::DeviceInfo> pulseAudioListOfDevice;
 static audio::Time pulseAudioListOfDeviceTime;
+static ethread::Mutex pulseAudioListOfDeviceMutex; //!< Streams can be open from many threads (openStreamAsync)
 
 etk::Vector<audio::orchestra::DeviceInfo> audio::orchestra::api::pulse::getDeviceList() {
+	ethread::UniqueLock lock(pulseAudioListOfDeviceMutex);
 	audio::Duration delta = audio::Time::now() - pulseAudioListOfDeviceTime;
 	if (delta < audio::Duration(30,0)) {
 		return pulseAudioListOfDevice;
@@ -0,0 +1,243 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license APACHE v2.0 (see license file)
+ */
+
+#if defined(ORCHESTRA_BUILD_PULSE)
+
+#include <pulse/pulseaudio.h>
+#include <audio/orchestra/debug.hpp>
+#include <audio/orchestra/api/PulseMonitor.hpp>
+
+static void callbackState(pa_context* _context, void* _userdata) {
+	static_cast<audio::orchestra::api::PulseMonitor*>(_userdata)->onStateChange();
+}
+
+static void callbackSubscribe(pa_context* _context, pa_subscription_event_type_t _type, uint32_t _index, void* _userdata) {
+	static_cast<audio::orchestra::api::PulseMonitor*>(_userdata)->onSubscribe(_type, _index);
+}
+
+static void callbackSink(pa_context* _context, const pa_sink_info* _info, int _eol, void* _userdata) {
+	if (_eol != 0) {
+		return;
+	}
+	static_cast<audio::orchestra::api::PulseMonitor*>(_userdata)->onDevice(_info->index, _info->name, false);
+}
+
+static void callbackSource(pa_context* _context, const pa_source_info* _info, int _eol, void* _userdata) {
+	if (_eol != 0) {
+		return;
+	}
+	static_cast<audio::orchestra::api::PulseMonitor*>(_userdata)->onDevice(_info->index, _info->name, true);
+}
+
+static void callbackServer(pa_context* _context, const pa_server_info* _info, void* _userdata) {
+	if (_info == null) {
+		return;
+	}
+	static_cast<audio::orchestra::api::PulseMonitor*>(_userdata)->onServer(_info->default_sink_name, _info->default_source_name);
+}
+
+static void callbackInitialized(pa_context* _context, int _success, void* _userdata) {
+	static_cast<audio::orchestra::api::PulseMonitor*>(_userdata)->onInitialized();
+}
+
+/**
+ * @brief Release a request (the callbacks are called by the main loop).
+ */
+static void requestDone(pa_operation* _operation) {
+	if (_operation != null) {
+		pa_operation_unref(_operation);
+	}
+}
+
+audio::orchestra::api::PulseMonitor::PulseMonitor() :
+  m_mainLoop(null),
+  m_context(null),
+  m_initialized(false) {
+	
+}
+
+audio::orchestra::api::PulseMonitor::~PulseMonitor() {
+	stop();
+}
+
+bool audio::orchestra::api::PulseMonitor::start(audio::orchestra::DeviceEventCallback _callback) {
+	stop();
+	m_callback = _callback;
+	m_mainLoop = pa_threaded_mainloop_new();
+	if (m_mainLoop == null) {
+		ATA_ERROR("Pulse monitor: can not create the main loop");
+		return false;
+	}
+	m_context = pa_context_new(pa_threaded_mainloop_get_api(m_mainLoop), "orchestraMonitor");
+	if (m_context == null) {
+		ATA_ERROR("Pulse monitor: can not create the context");
+		stop();
+		return false;
+	}
+	pa_context_set_state_callback(m_context, callbackState, this);
+	pa_context_set_subscribe_callback(m_context, callbackSubscribe, this);
+	if (pa_context_connect(m_context, null, PA_CONTEXT_NOAUTOSPAWN, null) < 0) {
+		ATA_ERROR("Pulse monitor: can not connect to the server: " << pa_strerror(pa_context_errno(m_context)));
+		stop();
+		return false;
+	}
+	pa_threaded_mainloop_lock(m_mainLoop);
+	if (pa_threaded_mainloop_start(m_mainLoop) < 0) {
+		pa_threaded_mainloop_unlock(m_mainLoop);
+		ATA_ERROR("Pulse monitor: can not start the main loop");
+		stop();
+		return false;
+	}
+	// Wait the connection (signaled by onStateChange).
+	pa_context_state_t state = pa_context_get_state(m_context);
+	while (    state != PA_CONTEXT_READY
+	        && state != PA_CONTEXT_FAILED
+	        && state != PA_CONTEXT_TERMINATED) {
+		pa_threaded_mainloop_wait(m_mainLoop);
+		state = pa_context_get_state(m_context);
+	}
+	pa_threaded_mainloop_unlock(m_mainLoop);
+	if (state != PA_CONTEXT_READY) {
+		ATA_ERROR("Pulse monitor: can not connect to the server");
+		stop();
+		return false;
+	}
+	return true;
+}
+
+void audio::orchestra::api::PulseMonitor::stop() {
+	if (m_mainLoop != null) {
+		// Stop the thread first: no callback can run after this point.
+		pa_threaded_mainloop_stop(m_mainLoop);
+	}
+	if (m_context != null) {
+		pa_context_disconnect(m_context);
+		pa_context_unref(m_context);
+		m_context = null;
+	}
+	if (m_mainLoop != null) {
+		pa_threaded_mainloop_free(m_mainLoop);
+		m_mainLoop = null;
+	}
+	m_devices.clear();
+	m_defaultName[0].clear();
+	m_defaultName[1].clear();
+	m_initialized = false;
+	m_callback = null;
+}
+
+void audio::orchestra::api::PulseMonitor::onStateChange() {
+	pa_context_state_t state = pa_context_get_state(m_context);
+	if (state == PA_CONTEXT_READY) {
+		// The requests are processed in order: the initial lists are received before the first event.
+		requestDone(pa_context_get_sink_info_list(m_context, callbackSink, this));
+		requestDone(pa_context_get_source_info_list(m_context, callbackSource, this));
+		requestDone(pa_context_get_server_info(m_context, callbackServer, this));
+		requestDone(pa_context_subscribe(m_context,
+		                                 pa_subscription_mask_t(  PA_SUBSCRIPTION_MASK_SINK
+		                                                        | PA_SUBSCRIPTION_MASK_SOURCE
+		                                                        | PA_SUBSCRIPTION_MASK_SERVER),
+		                                 callbackInitialized,
+		                                 this));
+	} else if (    state == PA_CONTEXT_FAILED
+	            || state == PA_CONTEXT_TERMINATED) {
+		ATA_WARNING("Pulse monitor: connection to the server lost");
+	}
+	pa_threaded_mainloop_signal(m_mainLoop, 0);
+}
+
+void audio::orchestra::api::PulseMonitor::onInitialized() {
+	m_initialized = true;
+	ATA_DEBUG("Pulse monitor: " << m_devices.size() << " devices, default sink='" << m_defaultName[0] << "' source='" << m_defaultName[1] << "'");
+}
+
+void audio::orchestra::api::PulseMonitor::onSubscribe(int32_t _type, uint32_t _index) {
+	int32_t facility = _type & PA_SUBSCRIPTION_EVENT_FACILITY_MASK;
+	int32_t type = _type & PA_SUBSCRIPTION_EVENT_TYPE_MASK;
+	if (facility == PA_SUBSCRIPTION_EVENT_SERVER) {
+		if (type == PA_SUBSCRIPTION_EVENT_CHANGE) {
+			requestDone(pa_context_get_server_info(m_context, callbackServer, this));
+		}
+		return;
+	}
+	if (    facility != PA_SUBSCRIPTION_EVENT_SINK
+	     && facility != PA_SUBSCRIPTION_EVENT_SOURCE) {
+		return;
+	}
+	bool input = facility == PA_SUBSCRIPTION_EVENT_SOURCE;
+	if (type == PA_SUBSCRIPTION_EVENT_NEW) {
+		if (input == true) {
+			requestDone(pa_context_get_source_info_by_index(m_context, _index, callbackSource, this));
+		} else {
+			requestDone(pa_context_get_sink_info_by_index(m_context, _index, callbackSink, this));
+		}
+		return;
+	}
+	if (type != PA_SUBSCRIPTION_EVENT_REMOVE) {
+		return;
+	}
+	auto it = m_devices.begin();
+	while (it != m_devices.end()) {
+		if (    it->index == _index
+		     && it->input == input) {
+			etk::String name = it->name;
+			it = m_devices.erase(it);
+			enum audio::orchestra::mode mode = input == true ? audio::orchestra::mode_input : audio::orchestra::mode_output;
+			ATA_INFO("Pulse monitor: " << audio::orchestra::deviceEvent_removed << " '" << name << "' (" << mode << ")");
+			if (m_callback != null) {
+				m_callback(audio::orchestra::deviceEvent_removed, name, mode);
+			}
+		} else {
+			++it;
+		}
+	}
+}
+
+void audio::orchestra::api::PulseMonitor::onDevice(uint32_t _index, const char* _name, bool _input) {
+	for (size_t iii=0; iii<m_devices.size(); ++iii) {
+		if (    m_devices[iii].index == _index
+		     && m_devices[iii].input == _input) {
+			return;
+		}
+	}
+	audio::orchestra::api::PulseMonitorDevice device;
+	device.index = _index;
+	device.name = _name;
+	device.input = _input;
+	m_devices.pushBack(device);
+	if (m_initialized == false) {
+		return;
+	}
+	enum audio::orchestra::mode mode = _input == true ? audio::orchestra::mode_input : audio::orchestra::mode_output;
+	ATA_INFO("Pulse monitor: " << audio::orchestra::deviceEvent_added << " '" << device.name << "' (" << mode << ")");
+	if (m_callback != null) {
+		m_callback(audio::orchestra::deviceEvent_added, device.name, mode);
+	}
+}
+
+void audio::orchestra::api::PulseMonitor::onServer(const char* _defaultSink, const char* _defaultSource) {
+	const char* names[2] = {_defaultSink, _defaultSource};
+	for (int32_t iii=0; iii<2; ++iii) {
+		if (names[iii] == null) {
+			continue;
+		}
+		etk::String name = names[iii];
+		if (name == m_defaultName[iii]) {
+			continue;
+		}
+		m_defaultName[iii] = name;
+		if (m_initialized == false) {
+			continue;
+		}
+		enum audio::orchestra::mode mode = iii == 0 ? audio::orchestra::mode_output : audio::orchestra::mode_input;
+		ATA_INFO("Pulse monitor: " << audio::orchestra::deviceEvent_defaultChanged << " '" << name << "' (" << mode << ")");
+		if (m_callback != null) {
+			m_callback(audio::orchestra::deviceEvent_defaultChanged, name, mode);
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,66 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license APACHE v2.0 (see license file)
+ */
+#pragma once
+#ifdef ORCHESTRA_BUILD_PULSE
+
+#include <etk/types.hpp>
+#include <etk/String.hpp>
+#include <etk/Vector.hpp>
+#include <audio/orchestra/DeviceEvent.hpp>
+
+struct pa_threaded_mainloop;
+struct pa_context;
+
+namespace audio {
+	namespace orchestra {
+		namespace api {
+			/**
+			 * @brief Sink or source known by the monitor (the remove event give only the index).
+			 */
+			class PulseMonitorDevice {
+				public:
+					uint32_t index; //!< Index of the sink/source on the server
+					etk::String name; //!< Name of the sink/source
+					bool input; //!< The device is a source
+			};
+			/**
+			 * @brief Hot-plug monitor of the pulseaudio server (pa_context_subscribe on the sinks, sources and server).
+			 * The events are received on the thread of a pa_threaded_mainloop (non real-time).
+			 */
+			class PulseMonitor {
+				private:
+					audio::orchestra::DeviceEventCallback m_callback; //!< User callback
+					pa_threaded_mainloop* m_mainLoop;
+					pa_context* m_context;
+					etk::Vector<audio::orchestra::api::PulseMonitorDevice> m_devices; //!< Sinks and sources currently available
+					etk::String m_defaultName[2]; //!< Default device: [0] sink, [1] source
+					bool m_initialized; //!< The initial list is received (the next changes are reported)
+				public:
+					PulseMonitor();
+					~PulseMonitor();
+					/**
+					 * @brief Connect to the server and subscribe to the events.
+					 * @param[in] _callback Function called on each event (on the thread of the pulseaudio main loop).
+					 * @return false if the server is not available.
+					 */
+					bool start(audio::orchestra::DeviceEventCallback _callback);
+					/**
+					 * @brief Disconnect from the server (the callback is not called anymore).
+					 */
+					void stop();
+				public:
+					// Callbacks of the pulseaudio main loop (internal use only).
+					void onStateChange();
+					void onSubscribe(int32_t _type, uint32_t _index);
+					void onDevice(uint32_t _index, const char* _name, bool _input);
+					void onServer(const char* _defaultSink, const char* _defaultSource);
+					void onInitialized();
+			};
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,71 @@
+/** @file
+ * @author Edouard DUPIN
+ * @copyright 2011, Edouard DUPIN, all right reserved
+ * @license APACHE v2.0 (see license file)
+ */
+#pragma once
+
+#include <etk/types.hpp>
+#if defined(__SSE__) || defined(__x86_64__)
+	#include <xmmintrin.h>
+	#define ORCHESTRA_SIMD_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	#include <arm_neon.h>
+	#define ORCHESTRA_SIMD_NEON
+#endif
+
+namespace audio {
+	namespace orchestra {
+		/**
+		 * @brief Vectorized helpers of the processing stages (SSE or NEON when availlable).
+		 */
+		namespace simd {
+			/**
+			 * @brief Dot product of 2 vectors.
+			 * @param[in] _data First vector.
+			 * @param[in] _coef Second vector.
+			 * @param[in] _size Size of the vectors (must be a multiple of 4).
+			 * @return Sum of the products.
+			 */
+			inline float dotProduct(const float* _data, const float* _coef, uint32_t _size) {
+				#if defined(ORCHESTRA_SIMD_SSE)
+					__m128 sum = _mm_setzero_ps();
+					for (uint32_t iii=0; iii<_size; iii+=4) {
+						sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(_data+iii), _mm_loadu_ps(_coef+iii)));
+					}
+					sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+					sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 0x55));
+					return _mm_cvtss_f32(sum);
+				#elif defined(ORCHESTRA_SIMD_NEON)
+					float32x4_t sum = vdupq_n_f32(0.0f);
+					for (uint32_t iii=0; iii<_size; iii+=4) {
+						sum = vmlaq_f32(sum, vld1q_f32(_data+iii), vld1q_f32(_coef+iii));
+					}
+					float32x2_t tmp = vadd_f32(vget_low_f32(sum), vget_high_f32(sum));
+					return vget_lane_f32(vpadd_f32(tmp, tmp), 0);
+				#else
+					float sum0 = 0.0f;
+					float sum1 = 0.0f;
+					float sum2 = 0.0f;
+					float sum3 = 0.0f;
+					for (uint32_t iii=0; iii<_size; iii+=4) {
+						sum0 += _data[iii] * _coef[iii];
+						sum1 += _data[iii+1] * _coef[iii+1];
+						sum2 += _data[iii+2] * _coef[iii+2];
+						sum3 += _data[iii+3] * _coef[iii+3];
+					}
+					return (sum0 + sum1) + (sum2 + sum3);
+				#endif
+			}
+			/**
+			 * @brief Round a number of elements to the size of the vectors used by dotProduct.
+			 * @param[in] _size Number of elements.
+			 * @return _size rounded to the upper multiple of 4.
+			 */
+			inline uint32_t alignSize(uint32_t _size) {
+				return (_size + 3) & ~uint32_t(3);
+			}
+		}
+	}
+}
+
@@ -10,7 +10,9 @@
 static const char* listValue[] = {
 	"ok",
 	"overflow",
-	"underflow"
+	"underflow",
+	"bufferSizeChange",
+	"reconnect"
 };
 
 etk::Stream& audio::orchestra::operator <<(etk::Stream& _os, enum audio::orchestra::status _obj) {
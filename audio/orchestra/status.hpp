@@ -14,8 +14,11 @@ namespace audio {
 		enum class status {
 			ok, //!< nothing...
 			overflow, //!< Internal buffer has more data than they can accept
-			underflow //!< The internal buffer is empty
+			underflow, //!< The internal buffer is empty
+			bufferSizeChange, //!< The number of chunk per callback has changed (new value in the _nbChunk parameter)
+			reconnect //!< The device has been lost and reopened: the buffers of the gap are silence (StreamOptions::reconnect)
 		};
+		const size_t statusNumber = size_t(audio::orchestra::status::reconnect) + 1; //!< Number of values of audio::orchestra::status (keep reconnect last)
 		etk::Stream& operator <<(etk::Stream& _os, enum audio::orchestra::status _obj);
 		etk::Stream& operator <<(etk::Stream& _os, const etk::Vector<enum audio::orchestra::status>& _obj);
 	}
@@ -38,6 +38,14 @@ def configure(target, my_module):
 		'audio/orchestra/Api.cpp',
 		'audio/orchestra/DeviceInfo.cpp',
 		'audio/orchestra/StreamOptions.cpp',
+		'audio/orchestra/ThreadConfig.cpp',
+		'audio/orchestra/ClockEstimator.cpp',
+		'audio/orchestra/Resampler.cpp',
+		'audio/orchestra/StreamBuffer.cpp',
+		'audio/orchestra/DeviceEvent.cpp',
+		'audio/orchestra/Futex.cpp',
+		'audio/orchestra/BlockReader.cpp',
+		'audio/orchestra/FrameRing.cpp',
 		'audio/orchestra/api/Dummy.cpp'
 		])
 	my_module.add_header_file([
@@ -53,7 +61,18 @@ def configure(target, my_module):
 		'audio/orchestra/Api.hpp',
 		'audio/orchestra/DeviceInfo.hpp',
 		'audio/orchestra/StreamOptions.hpp',
+		'audio/orchestra/ThreadConfig.hpp',
+		'audio/orchestra/SeqLock.hpp',
+		'audio/orchestra/ClockEstimator.hpp',
+		'audio/orchestra/Resampler.hpp',
+		'audio/orchestra/simd.hpp',
+		'audio/orchestra/StreamBuffer.hpp',
+		'audio/orchestra/DeviceEvent.hpp',
+		'audio/orchestra/Futex.hpp',
+		'audio/orchestra/BlockReader.hpp',
+		'audio/orchestra/FrameRing.hpp',
 		'audio/orchestra/CallbackInfo.hpp',
+		'audio/orchestra/TypedCallback.hpp',
 		'audio/orchestra/StreamParameters.hpp'
 		])
 	my_module.add_depend([
@@ -76,9 +95,14 @@ def configure(target, my_module):
 	elif "Linux" in target.get_type():
 		my_module.add_src_file([
 		    'audio/orchestra/api/Alsa.cpp',
+		    'audio/orchestra/api/AlsaAggregate.cpp',
+		    'audio/orchestra/api/AlsaEngine.cpp',
+		    'audio/orchestra/api/AlsaMonitor.cpp',
 		    'audio/orchestra/api/Jack.cpp',
+		    'audio/orchestra/api/JackMonitor.cpp',
 		    'audio/orchestra/api/Pulse.cpp',
-		    'audio/orchestra/api/PulseDeviceList.cpp'
+		    'audio/orchestra/api/PulseDeviceList.cpp',
+		    'audio/orchestra/api/PulseMonitor.cpp'
 		    ])
 		my_module.add_optionnal_depend('alsa', ["c++", "-DORCHESTRA_BUILD_ALSA"])
 		my_module.add_optionnal_depend('jack', ["c++", "-DORCHESTRA_BUILD_JACK"])